@@ -0,0 +1,86 @@
+/*
+ *  AsyncSceneObject.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <future>
+#include "SceneObject.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * @class	AsyncSceneObject
+   *
+   * @brief	A handle to a SceneObject which is being loaded on a background thread. Its
+   * 			model, texture and bounding boxes are read and decoded there, so the game can
+   * 			keep rendering (e.g. a start screen) in the meantime. Nothing is uploaded to
+   * 			the GPU while loading, since OpenGL can only be used on the render thread.
+   * 			Once the object is ready, get it and pass it to Renderer::prepareSceneObject
+   * 			(on the render thread) before rendering it for the first time:
+   *
+   * 			if (!goat && goatLoading.isReady()) {
+   * 			  goat = goatLoading.get();
+   * 			  renderer->prepareSceneObject(goat);
+   * 			}
+   *
+   */
+
+  class AsyncSceneObject {
+  private:
+    string name;
+    shared_future<shared_ptr<SceneObject> > loading;
+
+  public:
+
+    /**
+     * Constructor. Starts loading the object on a background thread. The parameters
+     * are the same as those of the SceneObject constructor.
+     * @param name The name of the object
+     * @param modelPath The path to the file containing the object's model
+     * @param numFrames The number of frames, if the object is animated
+     * @param texturePath The path to the file containing the object's texture
+     * @param boundingBoxesPath The path to the file containing the object's bounding boxes
+     * @param modelCache The cache from which to get the object's model (optional)
+     */
+    AsyncSceneObject(const string &name, const string &modelPath,
+                     const int &numFrames = 1, const string &texturePath = "",
+                     const string &boundingBoxesPath = "",
+                     const shared_ptr<ModelCache> &modelCache = shared_ptr<ModelCache>());
+
+    /**
+     * Destructor. Waits for the loading to finish, if it is still in progress.
+     */
+    ~AsyncSceneObject();
+
+    /**
+     * Check, without waiting, if the object has been loaded (or has failed to load).
+     * @return true if get() can be called without blocking, false otherwise
+     */
+    bool isReady() const;
+
+    /**
+     * Get the loaded object, waiting for the loading to finish if necessary. If the
+     * loading has failed, the exception thrown by it (e.g. for a missing file) is
+     * thrown again, every time this is called.
+     * @return The object
+     */
+    shared_ptr<SceneObject> get() const;
+
+    /**
+     * Get the name of the object being loaded
+     * @return The name of the object
+     */
+    const string getName() const;
+
+  };
+
+}
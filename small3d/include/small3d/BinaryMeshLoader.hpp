@@ -0,0 +1,104 @@
+/*
+ *  BinaryMeshLoader.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+#pragma once
+
+#include "ModelLoader.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * @class	BinaryMeshLoader
+   *
+   * @brief	Class that loads a model from a binary .s3dmesh file, into a Model object,
+   * 			and saves models to such files. The file holds the final vertex, index,
+   * 			normals and texture coordinates data of the model (and the index data of its
+   * 			lower levels of detail, if any), exactly as they are held by the Model, so
+   * 			loading it only involves mapping it into memory and copying the data,
+   * 			without any parsing. It starts with a header containing
+   * 			a format version, the size and modification time of the file the model was
+   * 			originally loaded from (so that outdated files can be detected) and a checksum
+   * 			of the data.
+   *
+   */
+
+  class BinaryMeshLoader : public ModelLoader {
+
+  public:
+
+    /**
+     * @fn	BinaryMeshLoader::BinaryMeshLoader();
+     *
+     * @brief	Default constructor.
+     *
+     */
+
+    BinaryMeshLoader();
+
+    /**
+     * @fn	BinaryMeshLoader::~BinaryMeshLoader();
+     *
+     * @brief	Destructor.
+     *
+     */
+
+    ~BinaryMeshLoader();
+
+    /**
+     * @fn	void BinaryMeshLoader::load(const string &fileLocation, Model &model);
+     *
+     * @brief	Loads a model from the given .s3dmesh file into the model object. An exception
+     * 			is thrown if the file cannot be read or is not a valid .s3dmesh file.
+     *
+     * @param	fileLocation	Path to the file in which the model is stored, relative to the
+     * 						game's execution directory.
+     * @param	model   	The model.
+     */
+
+    void load(const string &fileLocation, Model &model);
+
+    /**
+     * @fn	bool BinaryMeshLoader::tryLoad(const string &fileLocation, Model &model,
+     * 		const string &sourceFileLocation);
+     *
+     * @brief	Loads a model from the given .s3dmesh file into the model object, if possible.
+     *
+     * @param	fileLocation	Path to the .s3dmesh file, relative to the game's execution directory.
+     * @param	model   	The model. It is only modified if loading succeeds.
+     * @param	sourceFileLocation	Optional path to the file the model was originally loaded from,
+     * 							relative to the game's execution directory. If provided, the
+     * 							.s3dmesh file is only used if it was created from the current
+     * 							version of that file.
+     *
+     * @return	true if the model was loaded, false if the file does not exist, is not valid or is outdated.
+     */
+
+    bool tryLoad(const string &fileLocation, Model &model, const string &sourceFileLocation = "");
+
+    /**
+     * @fn	void BinaryMeshLoader::save(const string &fileLocation, const Model &model,
+     * 		const string &sourceFileLocation);
+     *
+     * @brief	Saves a model to a .s3dmesh file. The file is written under a temporary
+     * 			name, unique to each call, first and then renamed over any existing file,
+     * 			so that it never appears half-written or missing, even if the same model
+     * 			is saved from several threads or processes at the same time.
+     *
+     * @param	fileLocation	Path to the .s3dmesh file, relative to the game's execution directory.
+     * @param	model   	The model.
+     * @param	sourceFileLocation	Optional path to the file the model was originally loaded from,
+     * 							relative to the game's execution directory, so that outdated
+     * 							.s3dmesh files can be detected when loading.
+     */
+
+    void save(const string &fileLocation, const Model &model, const string &sourceFileLocation = "");
+
+  };
+
+}
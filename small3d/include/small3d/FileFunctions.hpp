@@ -0,0 +1,35 @@
+/*
+ *  FileFunctions.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * Get a name for a file to write to before it replaces another one (see replaceFile),
+   * unique to each writer, so that files saved to the same location at the same time
+   * (e.g. by several threads, or by several instances of the game) do not mix
+   * @param filePath The path of the file to be replaced
+   * @return The path of the temporary file, in the same directory
+   */
+  string getTemporaryFilePath(const string &filePath);
+
+  /**
+   * Replace a file with a temporary file in one step, so that it is never missing or
+   * partly written for anyone reading it. The temporary file is removed if this fails.
+   * @param temporaryFilePath The path of the temporary file
+   * @param filePath The path of the file to be replaced (or created)
+   * @return true on success, false otherwise
+   */
+  bool replaceFile(const string &temporaryFilePath, const string &filePath);
+
+}
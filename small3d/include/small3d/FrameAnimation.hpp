@@ -0,0 +1,157 @@
+/*
+ *  FrameAnimation.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "Model.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * @class	FrameAnimation
+   *
+   * @brief	The frames of a vertex-animated model, whose topology (index data) and texture
+   * 			coordinates are the same in every frame and only the positions and normals
+   * 			change. The first frame is kept as a complete Model, holding the topology and
+   * 			texture coordinates once, while this only holds the positions and normals of
+   * 			the other frames, in the same layout as the corresponding Model data.
+   *
+   */
+
+  class FrameAnimation {
+  private:
+
+    shared_ptr<const Model> firstFrame;
+
+  public:
+
+    /**
+     * @brief	The vertex data of each frame after the first one (empty if the first
+     * 			frame has been quantised, in which case only the compact format is kept)
+     */
+
+    vector<vector<float> > vertexData;
+
+    /**
+     * @brief	The normals data of each frame after the first one (empty if the first
+     * 			frame has been quantised)
+     */
+
+    vector<vector<float> > normalsData;
+
+    /**
+     * @brief	The compact vertex data of each frame after the first one
+     * 			(empty if the first frame has not been quantised)
+     */
+
+    vector<vector<float> > compactVertexData;
+
+    /**
+     * @brief	The packed normals data of each frame after the first one
+     * 			(empty if the first frame has not been quantised)
+     */
+
+    vector<vector<unsigned int> > packedNormalsData;
+
+    /**
+     * Constructor
+     * @param firstFrame The first frame of the animation
+     */
+    FrameAnimation(const shared_ptr<const Model> &firstFrame);
+
+    /**
+     * Create an animation from its frames, as loaded from Wavefront files exported with
+     * "Keep Vertex Order", so that the faces are in the same order in every frame. The frames
+     * can also have been optimised by the loader, since frames with the same index data are
+     * reordered the same way. The vertices are welded the same way in all the frames (a vertex
+     * is only shared by two face corners if it is shared by them in every frame), so that
+     * all the frames can use the first frame's index data. The frames are validated while
+     * doing this: they must have the same number of faces and the same texture coordinates,
+     * and welding them this way must not need more vertices than the first frame has (which
+     * happens when their faces are connected differently). If the first frame has been
+     * quantised, the other frames are only stored in the compact format.
+     * @param frames The frames. They are not modified.
+     * @param optimiseMesh Whether to optimise the shared topology for the GPU's caches (see
+     *                     MeshOptimisation.hpp), reordering the vertices of all the frames
+     *                     the same way.
+     * @return The animation, or null if the frames do not share the same topology
+     */
+    static shared_ptr<FrameAnimation> create(const vector<shared_ptr<Model> > &frames,
+                                             const bool &optimiseMesh = true);
+
+    /**
+     * Get the first frame of the animation, which holds its topology and texture coordinates
+     * @return The first frame
+     */
+    const shared_ptr<const Model>& getFirstFrame() const;
+
+    /**
+     * Get the number of frames, including the first one
+     * @return The number of frames
+     */
+    int getNumFrames() const;
+
+    /**
+     * Check if the frames are stored in the compact vertex format (see VertexQuantisation.hpp)
+     * @return true if the first frame has been quantised, false otherwise
+     */
+    bool isQuantised() const;
+
+    /**
+     * Get the vertex data of a frame. An Exception is raised for the frames after the
+     * first one of a quantised animation, which are not kept in this format (see getFrameData).
+     * @param frame The frame (0 for the first one)
+     * @return The vertex data
+     */
+    const vector<float>& getVertexData(const int &frame) const;
+
+    /**
+     * Get the normals data of a frame. An Exception is raised for the frames after the
+     * first one of a quantised animation (see getFrameData).
+     * @param frame The frame (0 for the first one)
+     * @return The normals data
+     */
+    const vector<float>& getNormalsData(const int &frame) const;
+
+    /**
+     * Get copies of the vertex and normals data of any frame, decoding them from the
+     * compact format if the animation is quantised (the normals then differ slightly
+     * from the original ones)
+     * @param frame The frame (0 for the first one)
+     * @param [out] vertexData The vertex data
+     * @param [out] normalsData The normals data
+     */
+    void getFrameData(const int &frame, vector<float> &vertexData, vector<float> &normalsData) const;
+
+    /**
+     * Get the compact vertex data of a frame
+     * @param frame The frame (0 for the first one)
+     * @return The compact vertex data
+     */
+    const vector<float>& getCompactVertexData(const int &frame) const;
+
+    /**
+     * Get the packed normals data of a frame
+     * @param frame The frame (0 for the first one)
+     * @return The packed normals data
+     */
+    const vector<unsigned int>& getPackedNormalsData(const int &frame) const;
+
+    /**
+     * Get the memory taken up by the vertex attributes and indices of all the frames
+     * @return The size, in bytes
+     */
+    size_t getDataSize() const;
+
+  };
+
+}
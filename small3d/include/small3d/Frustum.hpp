@@ -0,0 +1,90 @@
+/*
+ *  Frustum.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * @class	Frustum
+   *
+   * @brief	The view frustum of the camera, as six planes, against which bounding
+   * 			volumes are tested, so that objects which cannot be seen are not drawn.
+   * 			The planes are stored one component per array, so that many volumes can
+   * 			be tested at once in loops that the compiler can vectorise (see cullSpheres).
+   *
+   */
+
+  class Frustum {
+  private:
+
+    // The planes (left, right, bottom, top, near, far), normalised and facing
+    // inwards: a point is on the inner side of a plane if x * planeX + y * planeY +
+    // z * planeZ + planeD >= 0
+    float planeX[6];
+    float planeY[6];
+    float planeZ[6];
+    float planeD[6];
+
+  public:
+
+    /**
+     * Default constructor. The frustum contains everything.
+     */
+    Frustum();
+
+    /**
+     * Constructor, extracting the planes of the frustum from a view-projection matrix
+     * (Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the
+     * World-View-Projection Matrix")
+     * @param viewProjectionMatrix The view-projection matrix (clip space z from -1 to 1)
+     */
+    Frustum(const glm::mat4 &viewProjectionMatrix);
+
+    /**
+     * Check if a sphere is (at least partly) inside the frustum. Spheres just outside
+     * the corners of the frustum may be reported as inside.
+     * @param centre The centre of the sphere
+     * @param radius The radius of the sphere
+     * @return true if the sphere may be inside the frustum, false if it is certainly not
+     */
+    bool containsSphere(const glm::vec3 &centre, const float &radius) const;
+
+    /**
+     * Check if an axis aligned box is (at least partly) inside the frustum. Like
+     * containsSphere, boxes just outside the corners of the frustum may be reported
+     * as inside.
+     * @param centre The centre of the box
+     * @param halfExtents Half the size of the box along each axis
+     * @return true if the box may be inside the frustum, false if it is certainly not
+     */
+    bool containsBox(const glm::vec3 &centre, const glm::vec3 &halfExtents) const;
+
+    /**
+     * Test many spheres against the frustum. The spheres are passed one component per
+     * array, so that each plane is tested against all of them in a loop without branches.
+     * @param centreX The x coordinates of the centres of the spheres
+     * @param centreY The y coordinates of the centres of the spheres
+     * @param centreZ The z coordinates of the centres of the spheres
+     * @param radii The radii of the spheres
+     * @param numSpheres The number of spheres
+     * @param [out] visible Set to 1 for each sphere that may be inside the frustum and to 0
+     *                      for each one that is certainly not (numSpheres elements)
+     * @return The number of spheres that may be inside the frustum
+     */
+    size_t cullSpheres(const float *centreX, const float *centreY, const float *centreZ, const float *radii,
+                       const size_t &numSpheres, unsigned char *visible) const;
+
+  };
+
+}
@@ -13,18 +13,19 @@
  * omitted if deactivated.
  */
 
-#define LOGERROR(MESSAGE) logger->append(error, MESSAGE)
+#define LOGERROR(MESSAGE) small3d::logMessage(small3d::error, MESSAGE)
 
-#define LOGINFO(MESSAGE) logger->append(info, MESSAGE)
+#define LOGINFO(MESSAGE) small3d::logMessage(small3d::info, MESSAGE)
 
 #if defined(DEBUG) || defined(_DEBUG)
-#define LOGDEBUG(MESSAGE) logger->append(debug, MESSAGE)
+#define LOGDEBUG(MESSAGE) small3d::logMessage(small3d::debug, MESSAGE)
 #else
 #define LOGDEBUG(MESSAGE)
 #endif
 
 #include <ostream>
 #include <memory>
+#include <mutex>
 
 using namespace std;
 
@@ -51,6 +52,7 @@ namespace small3d {
   class Logger {
   private:
     ostream *logStream;
+    mutex appendMutex;
   public:
 
     /**
@@ -90,6 +92,19 @@ namespace small3d {
   void initLogger(ostream &stream);
 
   void deleteLogger();
+
+  /**
+   * @fn	void logMessage(const LogLevel level, const string &message);
+   *
+   * @brief	Appends a message to the logger, if there is one. The logger is
+   * 			copied under the same lock as initLogger and deleteLogger use, so
+   * 			that it is not deleted while the message is being appended.
+   *
+   * @param	level  	The logging level (debug, info, etc).
+   * @param	message	The message.
+   */
+
+  void logMessage(const LogLevel level, const string &message);
 }
 
 extern shared_ptr<small3d::Logger> logger;
@@ -0,0 +1,70 @@
+/*
+ *  MappedFile.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * @class	MappedFile
+   *
+   * @brief	A read-only view of a whole file, mapped into memory. The contents
+   * 			can be parsed in place, without being copied into strings or streams.
+   * 			The mapping is released when the object is destroyed.
+   *
+   */
+
+  class MappedFile {
+  private:
+
+    const char* data;
+    size_t size;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+    // Mappings cannot be shared
+    MappedFile(const MappedFile &other);
+    MappedFile& operator=(const MappedFile &other);
+
+  public:
+
+    /**
+     * Constructor. Maps the file into memory.
+     * @param fileLocation The full path to the file (not relative to the
+     *                     game's execution directory).
+     */
+    MappedFile(const string &fileLocation);
+
+    /**
+     * Destructor. Unmaps the file.
+     */
+    ~MappedFile();
+
+    /**
+     * Get the contents of the file. Note that they are not null terminated.
+     * @return Pointer to the first byte of the file (NULL if the file is empty)
+     */
+    const char* getData() const;
+
+    /**
+     * Get the size of the file
+     * @return The size of the file, in bytes
+     */
+    size_t getSize() const;
+
+  };
+
+}
@@ -43,4 +43,12 @@ namespace small3d {
    */
   glm::mat4x4 rotateZ(const float &angle);
 
+  /**
+   * Rotation transformation for rotating around all three axes, in the order in which
+   * objects are rotated (first around the Z axis, then the X axis and then the Y axis)
+   * @param rotation The angles to rotate by around the x, y and z axes, in radians.
+   * @return The rotation matrix
+   */
+  glm::mat4x4 rotate(const glm::vec3 &rotation);
+
 }
@@ -0,0 +1,70 @@
+/*
+ *  MeshOptimisation.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include "Model.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * Calculates the average cache miss ratio (ACMR) of a model's index data, i.e. the
+   * average number of times per triangle that the vertex shader has to run, assuming
+   * a FIFO post-transform vertex cache of the given size. It ranges from 0.5 (ideal,
+   * for large meshes) to 3 (no reuse at all).
+   *
+   * @param	model	 	The model
+   * @param	cacheSize	The number of entries in the simulated vertex cache
+   *
+   * @return	The average cache miss ratio (0 if the model has no triangles)
+   */
+
+  float calculateACMR(const Model &model, const int &cacheSize = 16);
+
+  /**
+   * Reorders the triangles of a model, so that vertices which have been processed
+   * recently by the vertex shader are used again as soon as possible and can be fetched
+   * from the post-transform cache, rather than being processed again. This uses Tom
+   * Forsyth's "Linear-Speed Vertex Cache Optimisation" algorithm. The vertex data is
+   * not affected. The triangles of each level of detail of the model are reordered
+   * separately.
+   *
+   * @param [in,out]	model	The model
+   */
+
+  void optimiseVertexCache(Model &model);
+
+  /**
+   * Reorders triangles for the post-transform vertex cache, like optimiseVertexCache
+   * does for a model, but given just their (32-bit) index data.
+   *
+   * @param [in,out]	triangles	The index data, 3 indices per triangle
+   * @param	vertexCount	The number of vertices referenced by the index data
+   */
+
+  void optimiseVertexCache(vector<unsigned int> &triangles, const size_t &vertexCount);
+
+  /**
+   * Reorders the vertices of a model in the order in which they are first referenced
+   * by its (already optimised) index data, so that they are fetched from memory as
+   * sequentially as possible. The vertex, normals and texture coordinates data are
+   * reordered together and the index data (including that of the lower levels of
+   * detail) is updated accordingly.
+   *
+   * @param [in,out]	model	The model
+   * @param [out]	vertexRemap	If not NULL, it receives the new position of each of the
+   * 							original vertices (-1 for vertices that were not used and
+   * 							have been dropped), so that other data kept per vertex
+   * 							(e.g. the other frames of an animation) can be reordered
+   * 							the same way.
+   */
+
+  void optimiseVertexFetch(Model &model, vector<unsigned int> *vertexRemap = NULL);
+}
@@ -0,0 +1,54 @@
+/*
+ *  MeshSimplification.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include "Model.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * Simplifies the triangles of a model, by repeatedly collapsing the edge whose removal
+   * changes the shape of the model the least, as measured by quadric error metrics
+   * (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics"). Each
+   * collapse moves a vertex onto one of its neighbours, so the simplified triangles use
+   * a subset of the model's vertices and no new vertex data is created. Vertices where
+   * the normals or texture coordinates are discontinuous (so that more than one vertex
+   * has the same position) are never moved, so that seams do not open up, and vertices
+   * on the open borders of the mesh are only moved along them. Collapses which would
+   * flip a triangle are not performed.
+   *
+   * @param	model           	The model, whose vertex data the triangles use
+   * @param	triangles       	The (32-bit) index data of the triangles to simplify, 3
+   * 							indices per triangle (e.g. the model's index data, or a
+   * 							level of detail that has already been simplified)
+   * @param	targetNumIndexes	The number of indices to reduce the triangles to. The
+   * 							result may have more indices, if no further collapse is
+   * 							possible.
+   *
+   * @return	The index data of the simplified triangles
+   */
+
+  vector<unsigned int> simplifyMesh(const Model &model, const vector<unsigned int> &triangles,
+                                    const size_t &targetNumIndexes);
+
+  /**
+   * Generates the lower levels of detail of a model (see Model::lodIndexData), each one
+   * simplified from the previous one (see simplifyMesh) and optimised for the vertex cache.
+   * Any levels of detail the model already had are replaced. Fewer levels are generated
+   * if the model cannot be simplified any further.
+   *
+   * @param [in,out]	model	The model
+   * @param	numLevels	The number of levels of detail, including the model itself
+   * @param	reduction	The proportion of the triangles of each level that is kept in the next one
+   */
+
+  void generateLevelsOfDetail(Model &model, const int &numLevels = 4, const float &reduction = 0.5f);
+}
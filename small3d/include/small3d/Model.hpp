@@ -9,6 +9,7 @@
 
 #include <string>
 #include <vector>
+#include <glm/glm.hpp>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -84,9 +85,62 @@ namespace small3d {
     int textureCoordsDataSize;
 
     /**
-     * @brief	Number of elements in the texture coordinates array.
+     * @brief	The vertex data in the compact vertex format (see VertexQuantisation.hpp): a 3 column
+     * 			table, holding the x, y, z values, without the fourth column. Empty, unless the model
+     * 			has been quantised.
      */
 
+    vector<float> compactVertexData;
+
+    /**
+     * @brief	The normals data in the compact vertex format: one signed 10:10:10:2 integer per
+     * 			normal (see packNormal). Empty, unless the model has been quantised.
+     */
+
+    vector<unsigned int> packedNormalsData;
+
+    /**
+     * @brief	The texture coordinates data in the compact vertex format: 16-bit half floats,
+     * 			2 per vertex. Empty, unless the model has been quantised (or has no texture
+     * 			coordinates).
+     */
+
+    vector<unsigned short> halfTextureCoordsData;
+
+    /**
+     * @brief	The index data of the model's lower levels of detail (see MeshSimplification.hpp),
+     * 			from the most to the least detailed. They use the same vertices as the model
+     * 			itself, which is the first (most detailed) level.
+     */
+
+    vector<vector<unsigned int> > lodIndexData;
+
+    /**
+     * @brief	The corner of the model's bounding box with the smallest coordinates.
+     * 			The box is aligned to the model's own axes (see calculateBoundingVolumes).
+     */
+
+    glm::vec3 boundingBoxMin;
+
+    /**
+     * @brief	The corner of the model's bounding box with the largest coordinates.
+     */
+
+    glm::vec3 boundingBoxMax;
+
+    /**
+     * @brief	The centre of the model's bounding sphere (the centre of the bounding box).
+     */
+
+    glm::vec3 boundingSphereCentre;
+
+    /**
+     * @brief	The radius of the model's bounding sphere. Negative if the bounding volumes
+     * 			have not been calculated, in which case the model is never culled.
+     */
+
+    float boundingSphereRadius;
+
     /**
      * @fn	Model();
      *
@@ -105,6 +159,64 @@ namespace small3d {
 
     ~Model(void);
 
+    /**
+     * @fn	size_t getNumIndexes(const size_t &level) const;
+     *
+     * @brief	Get the number of indices of a level of detail.
+     *
+     * @param	level	The level of detail (0, the default, for the model itself).
+     *
+     * @return	The number of indices.
+     */
+
+    size_t getNumIndexes(const size_t &level = 0) const;
+
+    /**
+     * @fn	const vector<unsigned int>& getIndexData(const size_t &level) const;
+     *
+     * @brief	Get the index data of a level of detail (indexData or one of lodIndexData).
+     *
+     * @param	level	The level of detail (0, the default, for the model itself).
+     *
+     * @return	The index data.
+     */
+
+    const vector<unsigned int>& getIndexData(const size_t &level = 0) const;
+
+    /**
+     * @fn	size_t getNumLevelsOfDetail() const;
+     *
+     * @brief	Get the number of levels of detail of the model, including the model itself.
+     *
+     * @return	The number of levels of detail (1 if no lower levels have been generated).
+     */
+
+    size_t getNumLevelsOfDetail() const;
+
+    /**
+     * @fn	bool isQuantised() const;
+     *
+     * @brief	Check if the compact vertex format is available for the model's current data.
+     *
+     * @return	true if the model has been quantised, false otherwise.
+     */
+
+    bool isQuantised() const;
+
+    /**
+     * @fn	void calculateBoundingVolumes(const vector<const vector<float>*> &otherFrames);
+     *
+     * @brief	Calculate the bounding box and sphere of the model from its vertex data. The
+     * 			loaders do this when a model is loaded, so it only needs to be called again
+     * 			if the vertex data is changed.
+     *
+     * @param	otherFrames	The vertex data of any other frames the model is animated through,
+     * 						which the bounding volumes will also contain.
+     */
+
+    void calculateBoundingVolumes(const vector<const vector<float>*> &otherFrames =
+        vector<const vector<float>*>());
+
   };
 
 }
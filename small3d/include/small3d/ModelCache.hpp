@@ -0,0 +1,172 @@
+/*
+ *  ModelCache.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include "Model.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * @class	ModelCache
+   *
+   * @brief	A cache of loaded models, so that objects using the same model file share a single,
+   * 			immutable copy of it in memory and the file is only loaded once. Models are keyed
+   * 			by the canonical path of their file, so different relative paths to the same file
+   * 			still hit the cache, and by their number of levels of detail. The cache can be used from more than one thread at a time
+   * 			(e.g. when loading animation frames in parallel). A model that is being loaded by
+   * 			one thread is not loaded again by another; the second thread waits for it instead.
+   *
+   */
+
+  class ModelCache {
+  private:
+
+    // A model in the cache (or being loaded) and the number of the load which put it
+    // there, so that a failed load only removes its own entry
+    struct CachedModel {
+      shared_future<shared_ptr<const Model> > model;
+      unsigned long load;
+    };
+
+    mutex cacheMutex;
+    unordered_map<string, CachedModel> models;
+    long hits;
+    long misses;
+    unsigned long numLoads;
+    string meshCacheDirectory;
+    int levelsOfDetail;
+
+    // The absolute path of a file, with any symbolic links and "." or ".." components resolved
+    // (or just the absolute path, if the file does not exist)
+    static string getCanonicalPath(const string &fileLocation);
+
+    // The number of levels of detail a model is loaded with (to be called with the lock held)
+    int getLevelsOfDetail(const int &frame) const;
+
+    // The key of a model in the cache
+    static string getKey(const string &canonicalPath, const int &levelsOfDetail);
+
+    // Models cannot be copied out of a cache
+    ModelCache(const ModelCache &other);
+    ModelCache& operator=(const ModelCache &other);
+
+  public:
+
+    /**
+     * Constructor
+     */
+    ModelCache();
+
+    /**
+     * Destructor
+     */
+    ~ModelCache();
+
+    /**
+     * Get the location of the file containing a frame of an animated model. The program
+     * appends an underscore, a 6-digit frame number and the .obj suffix to the model path
+     * (e.g. goatAnim will become goatAnim_000001.obj for the first frame).
+     * @param modelPath The path up to the name part of the model
+     * @param frame The frame number (starting from 1)
+     * @return The location of the frame's file
+     */
+    static string getFrameLocation(const string &modelPath, const int &frame);
+
+    /**
+     * Get a model, loading it from its Wavefront file if it is not already in the cache.
+     * @param modelPath The path to the file containing the model or, for animated models,
+     *                  the path up to the name part of the model (see getFrameLocation).
+     * @param frame The frame number, for animated models (starting from 1), or 0 for models
+     *              that are not animated
+     * @return The model, shared with anyone else who has got it from the cache
+     */
+    shared_ptr<const Model> getModel(const string &modelPath, const int &frame = 0);
+
+    /**
+     * Save the models loaded by the cache to binary .s3dmesh files in the given directory
+     * and load them from there the next time, as long as their Wavefront files have not
+     * changed (see WavefrontLoader::setMeshCacheDirectory). Nothing is saved by default.
+     * @param directory The directory, relative to the game's execution directory and ending
+     *                  with a slash, which has to exist (empty to stop saving models)
+     */
+    void setMeshCacheDirectory(const string &directory);
+
+    /**
+     * Generate lower levels of detail for the models loaded by the cache from now on, for the
+     * Renderer to draw further away from the camera (see WavefrontLoader and
+     * Renderer::levelOfDetailDistances). The frames of animated models never get any. Models
+     * already in the cache with a different number of levels are loaded again when requested.
+     * @param levelsOfDetail The number of levels of detail, including the model itself
+     *                       (the default is 1, for no lower levels)
+     */
+    void setLevelsOfDetail(const int &levelsOfDetail);
+
+    /**
+     * Check if a model is in the cache with the current number of levels of detail
+     * (see setLevelsOfDetail), without loading it.
+     * @param modelPath The path to the file containing the model (see getModel)
+     * @param frame The frame number, for animated models, or 0
+     * @return true if the model is in the cache (or is being loaded), false otherwise
+     */
+    bool contains(const string &modelPath, const int &frame = 0);
+
+    /**
+     * Remove a model with the current number of levels of detail from the cache. Objects
+     * which are already using it keep their copy, which is released when the last of them
+     * stops using it.
+     * @param modelPath The path to the file containing the model (see getModel)
+     * @param frame The frame number, for animated models, or 0
+     * @return true if the model was in the cache, false otherwise
+     */
+    bool evict(const string &modelPath, const int &frame = 0);
+
+    /**
+     * Remove all the models which are not being used by anyone else from the cache.
+     * @return The number of models removed
+     */
+    size_t evictUnused();
+
+    /**
+     * Remove all the models from the cache.
+     */
+    void clear();
+
+    /**
+     * Get the number of models in the cache
+     * @return The number of models
+     */
+    size_t getSize();
+
+    /**
+     * Get the number of requests for models which were already in the cache
+     * @return The number of cache hits
+     */
+    long getHits();
+
+    /**
+     * Get the number of requests for models which had to be loaded
+     * @return The number of cache misses
+     */
+    long getMisses();
+
+    /**
+     * Set the hit and miss counts back to 0.
+     */
+    void resetStatistics();
+
+  };
+
+}
@@ -0,0 +1,108 @@
+/*
+ *  OcclusionBuffer.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * @class	OcclusionBuffer
+   *
+   * @brief	A coarse depth buffer, into which large objects (occluders) are rasterised
+   * 			on the CPU, so that objects hidden behind them can be found and skipped
+   * 			before they are sent to the GPU. Depths are normalised device z coordinates
+   * 			(-1 at zNear, 1 at zFar). Rasterisation is conservative: only pixels entirely
+   * 			inside an occluder are covered, with its farthest depth on them, so an object is
+   * 			not reported as hidden while part of it shows through. A pixel crossing an edge
+   * 			between two triangles counts as covered when the triangles share the edge's
+   * 			vertices, face the same way and contain the pixel together, with the farther
+   * 			of their depths on it. Texture seams (which split vertices) leave thin gaps in
+   * 			an occluder. Each row of a triangle is filled in a loop without branches,
+   * 			which the compiler can vectorise.
+   *
+   */
+
+  class OcclusionBuffer {
+  private:
+
+    int width;
+    int height;
+    vector<float> depths;
+    glm::mat4 viewProjectionMatrix;
+    int numTrianglesRasterised;
+
+  public:
+
+    /**
+     * Constructor
+     * @param width The width of the buffer, in pixels
+     * @param height The height of the buffer, in pixels
+     */
+    OcclusionBuffer(const int &width = 0, const int &height = 0);
+
+    /**
+     * Clear the buffer, so that nothing is hidden, and set the view-projection matrix
+     * with which occluders and bounding boxes are projected onto it
+     * @param viewProjectionMatrix The view-projection matrix
+     */
+    void clear(const glm::mat4 &viewProjectionMatrix);
+
+    /**
+     * Rasterise the triangles of a model into the buffer. Triangles which cross the near
+     * plane are skipped, so they do not hide anything. The model should not extend beyond
+     * the object it stands in for, or it will hide things that can be seen.
+     * @param model The model (its full level of detail is used)
+     * @param modelMatrix The model's transformation
+     */
+    void rasteriseOccluder(const Model &model, const glm::mat4 &modelMatrix);
+
+    /**
+     * Check if a box can be seen past what has been rasterised in the buffer
+     * @param boxMin The corner of the box with the smallest coordinates
+     * @param boxMax The corner of the box with the largest coordinates
+     * @param modelMatrix The transformation of the box
+     * @return false if the box is certainly hidden, true otherwise (also when it is
+     *         outside the buffer or crosses the near plane)
+     */
+    bool isBoxVisible(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const glm::mat4 &modelMatrix) const;
+
+    /**
+     * Get the number of triangles rasterised since the buffer was last cleared
+     * @return The number of triangles
+     */
+    int getNumTrianglesRasterised() const;
+
+    /**
+     * Get the depth stored at a pixel of the buffer
+     * @param x The horizontal position of the pixel (0 on the left)
+     * @param y The vertical position of the pixel (0 at the bottom)
+     * @return The depth (the largest float if nothing covers the pixel)
+     */
+    float getDepth(const int &x, const int &y) const;
+
+    /**
+     * Get the width of the buffer
+     * @return The width, in pixels
+     */
+    int getWidth() const;
+
+    /**
+     * Get the height of the buffer
+     * @return The height, in pixels
+     */
+    int getHeight() const;
+
+  };
+
+}
@@ -0,0 +1,30 @@
+/*
+ *  ParallelFor.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include <functional>
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * Runs a task for each index from 0 to count - 1, on a pool of worker threads
+   * (as many as the hardware supports, but no more than the number of tasks).
+   * The calling thread also takes part in the work. Each index is processed exactly
+   * once, but in no particular order, so the tasks must be independent of each other.
+   * If a task throws an exception, no further tasks are started and, once all the
+   * threads have finished, the first exception thrown is rethrown to the caller.
+   *
+   * @param	count	The number of tasks
+   * @param	task 	The task, which receives the index to process
+   */
+
+  void parallelFor(const int &count, const function<void(const int &)> &task);
+}
@@ -0,0 +1,41 @@
+/*
+ *  ParseNumbers.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * Parses a floating point number from a character range, without copying
+   * it and without taking the locale into account (the decimal separator is
+   * always '.'). Scientific notation is supported. The result is the same as
+   * converting the text with atof and casting to float.
+   *
+   * @param	pos		  	The position at which the number starts
+   * @param	end		  	The end of the character range (one past the last character)
+   * @param [out]	value	The parsed number
+   *
+   * @return	The position right after the number, or pos if no number was found there
+   */
+
+  const char* parseFloat(const char* pos, const char* end, float &value);
+
+  /**
+   * Parses a (possibly signed) integer from a character range, without copying it.
+   *
+   * @param	pos		  	The position at which the number starts
+   * @param	end		  	The end of the character range (one past the last character)
+   * @param [out]	value	The parsed number
+   *
+   * @return	The position right after the number, or pos if no number was found there
+   */
+
+  const char* parseInt(const char* pos, const char* end, int &value);
+}
@@ -18,9 +18,14 @@
 
 #include <memory>
 #include "SceneObject.hpp"
+#include "Frustum.hpp"
+#include "OcclusionBuffer.hpp"
 #include <vector>
 #include "Logger.hpp"
 #include <unordered_map>
+#include <map>
+#include <atomic>
+#include <chrono>
 #include <glm/glm.hpp>
 
 using namespace std;
@@ -28,6 +33,177 @@ using namespace std;
 namespace small3d
 {
 
+  /**
+   * @struct	Instance
+   *
+   * @brief	A copy of a model, drawn with Renderer::renderInstances together with
+   * 			all the other copies of the same model.
+   *
+   */
+
+  struct Instance
+  {
+    /**
+     * @brief	The offset (position) of the instance.
+     */
+
+    glm::vec3 offset;
+
+    /**
+     * @brief	The rotation of the instance (around the x, y and z axes).
+     */
+
+    glm::vec3 rotation;
+
+    /**
+     * @brief	The colour of the instance. If it is (0, 0, 0, 0), the instance
+     * 			is drawn with the texture passed to Renderer::renderInstances.
+     */
+
+    glm::vec4 colour;
+
+    /**
+     * Constructor
+     * @param offset The offset
+     * @param rotation The rotation
+     * @param colour The colour
+     */
+    Instance(const glm::vec3 &offset = glm::vec3(0.0f, 0.0f, 0.0f),
+             const glm::vec3 &rotation = glm::vec3(0.0f, 0.0f, 0.0f),
+             const glm::vec4 &colour = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)) :
+      offset(offset), rotation(rotation), colour(colour) {}
+  };
+
+  /**
+   * @enum	ErrorChecking
+   *
+   * @brief	When the Renderer checks for OpenGL errors while rendering (see
+   * 			Renderer::errorChecking). Checking after every call is the most precise,
+   * 			but it can stall the pipeline on many drivers.
+   */
+
+  enum ErrorChecking {
+    noErrorChecking, perFrameErrorChecking, perCallErrorChecking
+  };
+
+  /**
+   * @struct	RenderStatistics
+   *
+   * @brief	Counts of what the Renderer did while rendering a frame.
+   *
+   */
+
+  struct RenderStatistics
+  {
+    /**
+     * @brief	The number of times a shader program, texture or vertex array object
+     * 			was bound.
+     */
+
+    int binds;
+
+    /**
+     * @brief	The number of times binding a shader program, texture or vertex array
+     * 			object was skipped, because it was already bound.
+     */
+
+    int bindsAvoided;
+
+    /**
+     * @brief	The number of scene objects and instances that were drawn.
+     */
+
+    int objectsDrawn;
+
+    /**
+     * @brief	The number of scene objects and instances that were not drawn, because
+     * 			they were outside the view frustum (see Renderer::frustumCulling).
+     */
+
+    int objectsCulled;
+
+    /**
+     * @brief	The number of scene objects and instances that were not drawn, because
+     * 			they were hidden behind occluders (see Renderer::addOccluder).
+     */
+
+    int objectsOccluded;
+
+    /**
+     * @brief	The number of occluder triangles rasterised into the occlusion buffer.
+     */
+
+    int occluderTrianglesRasterised;
+
+    /**
+     * @brief	The time spent rasterising occluders and testing objects against them,
+     * 			in milliseconds.
+     */
+
+    double occlusionMilliseconds;
+
+    /**
+     * @brief	The number of draw calls (an instanced draw call counts as one).
+     */
+
+    int drawCalls;
+
+    /**
+     * @brief	The number of triangles drawn, counting those of every instance.
+     */
+
+    int trianglesDrawn;
+
+    /**
+     * @brief	The number of times data was uploaded to a buffer or texture on the GPU.
+     */
+
+    int bufferUploads;
+
+    /**
+     * @brief	The number of bytes uploaded to buffers and textures on the GPU.
+     */
+
+    size_t bytesUploaded;
+
+    /**
+     * @brief	The number of times a texture was bound (included in binds).
+     */
+
+    int textureBinds;
+
+    /**
+     * @brief	The number of times the shader program was switched (included in binds).
+     */
+
+    int programSwitches;
+
+    /**
+     * @brief	The time the GPU took to render a frame, in milliseconds, measured with
+     * 			timer queries. The results are only read once the GPU has made them available,
+     * 			so that rendering never waits for them, so this is the time of an earlier frame
+     * 			(usually two or three frames earlier). -1 if no frame has been measured yet,
+     * 			or if timer queries are not supported.
+     */
+
+    double gpuMilliseconds;
+
+    /**
+     * @brief	The time the GPU took to render each pass (see Renderer::beginPass) of the
+     * 			same frame as gpuMilliseconds, in milliseconds, by the name of the pass.
+     */
+
+    map<string, double> passGpuMilliseconds;
+
+    /**
+     * Constructor (all counts start at 0)
+     */
+    RenderStatistics() : binds(0), bindsAvoided(0), objectsDrawn(0), objectsCulled(0), objectsOccluded(0),
+                         occluderTrianglesRasterised(0), occlusionMilliseconds(0.0), drawCalls(0),
+                         trianglesDrawn(0), bufferUploads(0), bytesUploaded(0), textureBinds(0),
+                         programSwitches(0), gpuMilliseconds(-1.0) {}
+  };
+
   /**
    * @class	Renderer
    *
@@ -42,6 +218,20 @@ namespace small3d
 
     SDL_Window* sdlWindow;
 
+    /**
+     * The framebuffer object rendered to in headless mode (see initHeadless) and its
+     * colour and depth renderbuffers. 0 when rendering to the window.
+     */
+    GLuint offscreenFramebuffer;
+    GLuint offscreenColourBuffer;
+    GLuint offscreenDepthBuffer;
+
+    /**
+     * The size of the frames rendered, in pixels
+     */
+    int frameWidth;
+    int frameHeight;
+
     GLuint perspectiveProgram;
 
     GLuint orthographicProgram;
@@ -58,6 +248,144 @@ namespace small3d
 
     float zOffsetFromCamera;
 
+    /**
+     * The locations of the uniforms of the perspective program, which are
+     * retrieved once, after it has been linked
+     */
+    struct PerspectiveUniforms {
+      // Set for every object (or image). The object's model matrix, normal
+      // matrix and colour are vertex attributes, so that they can also be
+      // set per instance (see renderInstances).
+      GLint frameBlend;
+      // Set once per frame. On OpenGL 3.3, they are in the FrameUniforms block
+      // instead, so these are only used on OpenGL 2.1.
+      GLint viewProjectionMatrix;
+      GLint lightDirection;
+      GLint lightIntensity;
+    };
+
+    PerspectiveUniforms perspectiveUniforms;
+
+    /**
+     * The perspective projection, set up at initialisation
+     */
+    glm::mat4 perspectiveMatrix;
+
+    /**
+     * The camera's view transformation combined with the perspective projection,
+     * composed whenever the camera moves (see updateViewProjection)
+     */
+    glm::mat4 viewProjectionMatrix;
+
+    /**
+     * The view frustum, corresponding to viewProjectionMatrix
+     */
+    Frustum frustum;
+
+    /**
+     * Whether the view-projection matrix has been composed, and the camera position
+     * and rotation it was composed for
+     */
+    bool viewProjectionCalculated;
+    glm::vec3 viewCameraPosition;
+    glm::vec3 viewCameraRotation;
+
+    /**
+     * Compose the view-projection matrix and extract the view frustum from it, if the
+     * camera has moved since this was last done. No OpenGL calls are made.
+     */
+    void updateViewProjection();
+
+    /**
+     * An object hiding what is behind it, with the model rasterised in its place
+     */
+    struct Occluder {
+      shared_ptr<SceneObject> sceneObject;
+      shared_ptr<const Model> model;
+    };
+
+    vector<Occluder> occluders;
+
+    /**
+     * The depth buffer the occluders are rasterised into, once per frame, when the
+     * first object is tested against them. It is rasterised again if the camera moves.
+     */
+    OcclusionBuffer occlusionBuffer;
+    bool occlusionBufferReady;
+
+    /**
+     * Rasterise the occluders into the occlusion buffer, if this has not been done
+     * in the current frame
+     */
+    void prepareOcclusionBuffer();
+
+    /**
+     * The timer queries of a frame, timestamps at its start and end and at the start
+     * and end of each of its passes. They are kept for a few frames, until their
+     * results are available.
+     */
+    struct FrameTimerQueries {
+      GLuint frameQueries[2];
+      vector<string> passNames;
+      vector<GLuint> passQueries;
+      size_t numPasses;
+      bool issued;
+    };
+
+    vector<FrameTimerQueries> frameTimerQueries;
+    size_t currentFrameTimerQueries;
+    vector<size_t> openPasses;
+    bool timerQueriesSupported;
+    double lastGpuMilliseconds;
+    map<string, double> lastPassGpuMilliseconds;
+    int numFramesRendered;
+
+    /**
+     * Start timing a frame on the GPU
+     */
+    void startFrameTimer();
+
+    /**
+     * Finish timing the current frame on the GPU and read the results of the
+     * earlier frames whose timings have become available
+     */
+    void finishFrameTimer();
+
+    /**
+     * Count an upload of data to the GPU in the frame's statistics
+     * @param bytes The size of the data, in bytes
+     */
+    void countUpload(const size_t &bytes);
+
+    /**
+     * Count a draw call in the frame's statistics
+     * @param numIndexes The number of indices drawn per instance
+     * @param numInstances The number of instances drawn
+     */
+    void countDraw(const size_t &numIndexes, const size_t &numInstances = 1);
+
+    /**
+     * The uniform buffer holding the FrameUniforms block (OpenGL 3.3)
+     */
+    GLuint frameUniformBuffer;
+
+    /**
+     * Whether the per-frame uniforms have been uploaded, and the values that were
+     * uploaded, so that they are only uploaded again when they change
+     */
+    bool frameUniformsUploaded;
+    glm::vec3 uploadedCameraPosition;
+    glm::vec3 uploadedCameraRotation;
+    glm::vec3 uploadedLightDirection;
+    float uploadedLightIntensity;
+
+    /**
+     * Upload the uniforms which are the same for all the objects rendered in a
+     * frame (camera and lighting), if they have changed since they were last uploaded.
+     * The perspective program has to be in use.
+     */
+    void updateFrameUniforms();
+
     /**
      * Load a shader's source code from a file into a string
      * @param fileLocation The file's location, relative to the game path
@@ -71,12 +399,73 @@ namespace small3d
      * @param shaderType Type of shader (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER - the latter for OpenGL 3.3)
      * @return OpenGL shader reference
      */
-    GLuint compileShader(const string &shaderSource, const GLenum shaderType);
+    GLuint compileShader(const string &shaderSource, const string &shaderSourceFile, const GLenum shaderType);
+
+    /**
+     * Create a program from a vertex and a fragment shader, loading it from the program
+     * cache if a binary of it, produced by the same driver from the same source code,
+     * is there (see programCachePath). Otherwise, the shaders are compiled and linked
+     * and the binary is saved to the cache, if program binaries are supported.
+     * @param name The name of the program, by which it is cached
+     * @param vertexShaderPath The location of the vertex shader, relative to the game path
+     * @param fragmentShaderPath The location of the fragment shader, relative to the game path
+     * @param attributeLocations The locations to bind vertex attributes to, before linking
+     * @return The program
+     */
+    GLuint createProgram(const string &name, const string &vertexShaderPath, const string &fragmentShaderPath,
+                         const vector<pair<GLuint, string> > &attributeLocations);
+
+    /**
+     * Load a program binary from the program cache
+     * @param cacheFile The cache file
+     * @param cacheKey The driver and source code the binary has to have been produced from
+     * @return The program, or 0 if the file is missing, stale or rejected by the driver
+     */
+    GLuint loadProgramBinary(const string &cacheFile, const string &cacheKey);
+
+    /**
+     * Save the binary of a linked program to the program cache
+     * @param program The program
+     * @param cacheFile The cache file
+     * @param cacheKey The driver and source code the binary has been produced from
+     */
+    void saveProgramBinary(const GLuint &program, const string &cacheFile, const string &cacheKey);
+
+    /**
+     * The binary formats the driver can load programs from (empty if program
+     * binaries are not supported) and the number of programs loaded from the cache
+     */
+    vector<GLint> programBinaryFormats;
+    int numProgramsLoadedFromCache;
+
+    /**
+     * When initialisation started and how long it took to render the first frame
+     * after that (-1 until it has been rendered)
+     */
+    chrono::high_resolution_clock::time_point initialisationStart;
+    double timeToFirstFrame;
 
     /**
      * Initialise SDL
+     * @param headless Whether to create a hidden window, only to hold the OpenGL context,
+     *                 falling back to SDL's offscreen video driver if there is no display
+     */
+    void initSDL(int width, int height, bool fullScreen, const string &windowTitle = "",
+                 const bool &headless = false);
+
+    /**
+     * Initialise the renderer, either on a window or headless (see init and initHeadless)
      */
-    void initSDL(int width, int height, bool fullScreen, const string &windowTitle = "");
+    void initialise(const int width, const int height, const bool fullScreen, const string &windowTitle,
+                    const float &frustumScale, const float &zNear, const float &zFar,
+                    const float &zOffsetFromCamera, const string &shadersPath, const bool &headless);
+
+    /**
+     * Create the framebuffer object rendered to in headless mode and bind it
+     * @param width The width of the framebuffer, in pixels
+     * @param height The height of the framebuffer, in pixels
+     */
+    void createOffscreenFramebuffer(const int &width, const int &height);
 
     /**
      * Retrieve the information of what went wrong when linking a shader program
@@ -91,12 +480,230 @@ namespace small3d
 
     void checkForOpenGLErrors(string when, bool abort);
 
+    /**
+     * Check for OpenGL errors while rendering, if the error checking policy calls for
+     * it at this point (see errorChecking). With debug output, the errors reported to
+     * the debug message callback since the last check are checked instead.
+     * @param when What was being done, for the exception raised if there was an error
+     * @param perCall Whether this is a check after a call (rather than once per frame)
+     */
+    void checkForRenderingErrors(const string &when, const bool &perCall);
+
+    /**
+     * Route OpenGL errors and high or medium severity warnings to the Logger through a
+     * debug message callback, if the context is a debug context and KHR_debug or
+     * ARB_debug_output is supported
+     */
+    void enableDebugOutput();
+
+    /**
+     * Whether the debug message callback is in use and whether it has reported
+     * an error since the last check (it may be called from another thread)
+     */
+    bool debugOutputEnabled;
+    atomic<bool> debugOutputErrorReported;
+
+    /**
+     * The debug message callback (see enableDebugOutput). Only errors make the
+     * error checks fail.
+     */
+    static void GLAPIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                                GLsizei length, const GLchar *message, const void *userParam);
+
     /**
      * Textures used in the scene, each corresponding to the name of one of
      * the rendered models
      */
     unordered_map<string, GLuint> *textures;
 
+    /**
+     * The buffers holding the data of a model on the GPU, together with the
+     * vertex array object (OpenGL 3.3) through which they are drawn
+     */
+    struct ModelBuffers {
+      // The model, so that its buffers can be released once it is destroyed
+      weak_ptr<const Model> model;
+      GLuint vao;
+      // The indices of all the levels of detail, one after the other
+      GLuint indexBuffer;
+      // The offset (in bytes) of each level of detail in the index buffer
+      vector<size_t> indexOffsets;
+      // GL_UNSIGNED_SHORT if the indices have been uploaded as 16-bit ones, GL_UNSIGNED_INT otherwise
+      GLenum indexType;
+      GLuint uvBuffer;
+      // The positions and normals of each frame, if the model is the first
+      // frame of a FrameAnimation, or only of the model itself otherwise
+      vector<GLuint> positionBuffers;
+      vector<GLuint> normalsBuffers;
+      // The frames whose buffers the vertex array object currently points to
+      // (-1 for the next frame if it is not being blended with the current one)
+      int boundFrame;
+      int boundNextFrame;
+    };
+
+    /**
+     * The buffers of the models that have been rendered (or prepared), so that
+     * their data is only uploaded to the GPU once
+     */
+    unordered_map<const Model*, ModelBuffers> modelBuffers;
+
+    /**
+     * The buffer to which the transformations and colours of instances are
+     * uploaded (see renderInstances)
+     */
+    GLuint instanceBuffer;
+
+    /**
+     * The buffers of the quad through which images are rendered (see renderImage),
+     * and a vertex array object for each program (OpenGL 3.3)
+     */
+    GLuint imageVertexBuffer;
+    GLuint imageIndexBuffer;
+    GLuint imageUvBuffer;
+    GLuint orthographicImageVao;
+    GLuint perspectiveImageVao;
+
+    /**
+     * A draw waiting in the render queue (see renderQueue), either of a scene
+     * object or of an image
+     */
+    struct QueuedDraw {
+      // What the draws are sorted by
+      GLuint program;
+      GLuint texture;
+      const Model* model;
+      shared_ptr<SceneObject> sceneObject;
+      float imageVertices[16];
+      string textureName;
+      bool perspective;
+      glm::vec3 offset;
+    };
+
+    /**
+     * The draws queued for the current frame
+     */
+    vector<QueuedDraw> queuedDraws;
+
+    /**
+     * The program, texture and vertex array object currently bound, so that
+     * binding them again can be avoided
+     */
+    GLuint boundProgram;
+    GLuint boundTexture;
+    GLuint boundVertexArray;
+
+    /**
+     * The statistics of the current frame and of the last complete one
+     */
+    RenderStatistics frameStatistics;
+    RenderStatistics lastFrameStatistics;
+
+    /**
+     * Use a shader program, unless it is already in use
+     * @param program The program
+     */
+    void useProgram(const GLuint &program);
+
+    /**
+     * Bind a texture, unless it is already bound
+     * @param texture The texture
+     */
+    void bindTexture(const GLuint &texture);
+
+    /**
+     * Bind a vertex array object (OpenGL 3.3), unless it is already bound
+     * @param vertexArray The vertex array object
+     */
+    void bindVertexArray(const GLuint &vertexArray);
+
+    /**
+     * Unbind the program, texture and vertex array object, so that the OpenGL
+     * state is clean between frames
+     */
+    void unbindAll();
+
+    /**
+     * Create the buffers through which images are rendered
+     */
+    void createImageBuffers();
+
+    /**
+     * Get the buffers of a model, uploading its data to the GPU if this has not
+     * been done yet
+     * @param model The model
+     * @param frameAnimation The frames, if the model is the first frame of a FrameAnimation
+     * @param frame The frame whose positions and normals are needed
+     * @return The buffers
+     */
+    ModelBuffers& getModelBuffers(const shared_ptr<const Model> &model,
+                                  const shared_ptr<const FrameAnimation> &frameAnimation,
+                                  const int &frame);
+
+    /**
+     * Get the level of detail at which to draw a model at the given position
+     * @param model The model
+     * @param offset The position
+     * @return The level of detail (see levelOfDetailDistances)
+     */
+    size_t getLevelOfDetail(const Model &model, const glm::vec3 &offset) const;
+
+    /**
+     * Check if a model at the given position and rotation may be visible, by testing its
+     * bounding sphere and then its bounding box against the view frustum (see frustumCulling)
+     * @param model The model
+     * @param offset The position
+     * @param rotation The rotation
+     * @return false if the model is certainly outside the view frustum, true otherwise
+     */
+    bool isInFrustum(const Model &model, const glm::vec3 &offset, const glm::vec3 &rotation);
+
+    /**
+     * Find which of the given models, placed at the given positions and rotations, may be
+     * visible. Their bounding spheres are tested all together (see Frustum::cullSpheres)
+     * and the bounding boxes of those which pass are then tested one by one.
+     * @param models The models (one per object)
+     * @param offsets The positions of the objects
+     * @param rotations The rotations of the objects
+     * @param [out] visible Set to 1 for each object that may be visible, 0 for the rest
+     * @return The number of objects that may be visible
+     */
+    size_t cullObjects(const vector<const Model*> &models, const vector<glm::vec3> &offsets,
+                       const vector<glm::vec3> &rotations, vector<unsigned char> &visible);
+
+    /**
+     * Check if a model at the given position and rotation is hidden behind the occluders,
+     * by testing its bounding box against the occlusion buffer (see addOccluder)
+     * @param model The model
+     * @param offset The position
+     * @param rotation The rotation
+     * @param sceneObject The scene object being tested, if any (occluders are never hidden)
+     * @return true if the model is certainly hidden, false otherwise
+     */
+    bool isOccluded(const Model &model, const glm::vec3 &offset, const glm::vec3 &rotation,
+                    const SceneObject *sceneObject);
+
+    /**
+     * Draw a scene object, without checking whether it is visible (see renderSceneObject)
+     * @param sceneObject The scene object
+     */
+    void drawSceneObject(const shared_ptr<SceneObject> &sceneObject);
+
+    /**
+     * Point the vertex attributes to the buffers of the given frames
+     * @param buffers The buffers of the model
+     * @param compactFormat Whether the data is in the compact vertex format
+     * @param frame The current frame
+     * @param nextFrame The next frame, if it is being blended with the current one (-1 otherwise)
+     */
+    void bindModelBuffers(ModelBuffers &buffers, const bool &compactFormat,
+                          const int &frame, const int &nextFrame);
+
+    /**
+     * Delete the buffers of a model from the GPU
+     * @param buffers The buffers
+     */
+    void deleteModelBuffers(ModelBuffers &buffers);
+
   public:
 
     /**
@@ -131,6 +738,36 @@ namespace small3d
 	      const float &zFar = 24.0f, const float &zOffsetFromCamera = -1.0f,
 	      const string &shadersPath = "resources/shaders/");
 
+    /**
+     * Initialise the renderer in headless mode, for running without a display (e.g.
+     * for automated tests and benchmarks). Frames are rendered into an offscreen
+     * framebuffer of the given size, from which they can be read back (see readFrame),
+     * and nothing is shown on the screen. An OpenGL context is still needed, so on
+     * machines without a display, SDL's offscreen video driver (SDL 2.0.12 or later)
+     * is used, which creates one through EGL (e.g. with Mesa's software renderer).
+     * The parameters are the same as those of init.
+     */
+    void initHeadless(const int width, const int height, const float &frustumScale = 1.0f,
+                      const float &zNear = 1.0f, const float &zFar = 24.0f,
+                      const float &zOffsetFromCamera = -1.0f,
+                      const string &shadersPath = "resources/shaders/");
+
+    /**
+     * Check if the renderer is running in headless mode (see initHeadless)
+     * @return true if it is, false if it is rendering to a window
+     */
+    bool isHeadless() const;
+
+    /**
+     * Read back the frame rendered so far. When rendering to a window, this has to be
+     * done before swapBuffers. In headless mode, the last frame can also be read after it.
+     * @param [out] pixels The pixels, 4 bytes per pixel (red, green, blue and alpha),
+     *                     row by row from the top of the frame
+     * @param [out] width The width of the frame, in pixels
+     * @param [out] height The height of the frame, in pixels
+     */
+    void readFrame(vector<unsigned char> &pixels, int &width, int &height);
+
     /**
      * @brief	Vector indicating the direction of the light in the scene.
      */
@@ -155,6 +792,63 @@ namespace small3d
 
     float lightIntensity;
 
+    /**
+     * @brief	The distances from the camera beyond which scene objects are drawn using their
+     * 			lower levels of detail, if their models have them (see WavefrontLoader): beyond
+     * 			the first distance the second level is used, beyond the second one the third
+     * 			level, etc. There are none by default, so objects are always drawn in full
+     * 			detail. For example, 6, 12 and 18 divide the default frustum in quarters.
+     */
+
+    vector<float> levelOfDetailDistances;
+
+    /**
+     * @brief	Whether scene objects and instances whose bounding volumes (see Model) are
+     * 			outside the view frustum are skipped, before any OpenGL calls are made for them.
+     * 			On by default.
+     */
+
+    bool frustumCulling;
+
+    /**
+     * @brief	Whether scene objects and instances hidden behind the occluders (see addOccluder)
+     * 			are skipped. On by default, but it has no effect until occluders are added.
+     */
+
+    bool occlusionCulling;
+
+    /**
+     * @brief	Log the statistics of every so many frames (see logStatistics), when swapping
+     * 			the buffers. 0 (the default) for never.
+     */
+
+    int statisticsLogInterval;
+
+    /**
+     * @brief	When to check for OpenGL errors while rendering (an Exception is raised if
+     * 			there is one): after every call, once per frame (when swapping the buffers),
+     * 			or never. It defaults to every call in debug builds (DEBUG or _DEBUG defined)
+     * 			and never otherwise. Set this before init to check every call, so that a
+     * 			debug context is requested. In a debug context where KHR_debug or
+     * 			ARB_debug_output is supported, the errors are logged as the driver reports
+     * 			them, through a debug message callback, and the checks only look at whether
+     * 			any were reported, rather than querying OpenGL, which can stall rendering.
+     */
+
+    ErrorChecking errorChecking;
+
+    /**
+     * @brief	The directory, relative to the application's executing directory, where
+     * 			the linked shader programs are cached, so that they do not have to be compiled
+     * 			again the next time the renderer is initialised, if program binaries are
+     * 			supported (OpenGL 4.1 or ARB_get_program_binary). The cache is keyed by the
+     * 			driver's vendor, renderer and version and the shaders' source code, so it is
+     * 			ignored and overwritten when any of them changes. The directory has to exist and
+     * 			this has to be set before init. Empty (the default) for no caching.
+     */
+
+    string programCachePath;
+
     /**
      * Generate a texture in OpenGL, using the given data
      * @param name The name by which the texture will be known
@@ -196,7 +890,9 @@ namespace small3d
     /**
      * @fn	void Renderer::positionCamera();
      *
-     * @brief	Position the camera.
+     * @brief	Position the camera, uploading its position and rotation (and the
+     * 			lighting) to the shaders. This happens when rendering anyway, whenever
+     * 			they have changed, so it does not need to be called for every object.
      *
      */
 
@@ -215,11 +911,146 @@ namespace small3d
 		     const glm::vec3 &offset = glm::vec3(0.0f, 0.0f, 0.0f));
 
     /**
-     * Render a scene object
+     * Upload the data of a scene object to the GPU (its texture and the vertex and index
+     * data of all its frames), so that this does not have to happen the first time the
+     * object is rendered. It has to be called on the render thread. Objects loaded in the
+     * background (see AsyncSceneObject) should be passed to this method once they are ready.
+     * @param sceneObject The scene object
+     */
+    void prepareSceneObject(shared_ptr<SceneObject> sceneObject);
+
+    /**
+     * Release the GPU buffers holding the data of a scene object's model (or frames),
+     * which are otherwise kept for as long as the model exists, since other objects may
+     * be sharing it (see ModelCache). They are uploaded again if the object, or another
+     * one using the same model, is rendered after this. The texture is not deleted
+     * (see deleteTexture).
+     * @param sceneObject The scene object
+     */
+    void releaseSceneObject(shared_ptr<SceneObject> sceneObject);
+
+    /**
+     * Get the number of models whose data is currently held in GPU buffers
+     * @return The number of models
+     */
+    size_t getNumResidentModels() const;
+
+    /**
+     * Add a scene object which hides whatever is behind it (e.g. a building or the terrain).
+     * In every frame, the occluders are rasterised into a coarse depth buffer on the CPU and
+     * scene objects and instances whose bounding boxes are completely hidden behind them
+     * are not drawn (see occlusionCulling). The occluders themselves are drawn as usual.
+     * @param sceneObject The scene object
+     * @param occluderModel A simplified model (a few dozen triangles), to be rasterised in
+     *                      the place of the scene object's model. It should fit inside the
+     *                      object, or things that can be seen may be hidden. If it is not
+     *                      provided, the object's own model is used.
+     */
+    void addOccluder(shared_ptr<SceneObject> sceneObject,
+                     shared_ptr<const Model> occluderModel = shared_ptr<const Model>());
+
+    /**
+     * Remove an occluder (see addOccluder)
+     * @param sceneObject The scene object
+     */
+    void removeOccluder(shared_ptr<SceneObject> sceneObject);
+
+    /**
+     * Render a scene object. The data of its model is uploaded to the GPU the first time
+     * this happens and the buffers are reused afterwards, until the model is destroyed
+     * or the object is released (see releaseSceneObject). Nothing is done if the object
+     * is outside the view frustum (see frustumCulling), or hidden behind the occluders
+     * (see addOccluder).
      * @param sceneObject The scene object
      */
     void renderSceneObject(shared_ptr<SceneObject> sceneObject);
 
+    /**
+     * Render many copies (instances) of a model, each one with its own position,
+     * rotation and colour, with as few draw calls as possible. On OpenGL 3.3, all the
+     * instances at the same level of detail are drawn with a single instanced draw call.
+     * On OpenGL 2.1, which does not support instancing, they are drawn one by one, but
+     * still without the overhead of rendering them as separate scene objects. Animated
+     * models are drawn at their first frame. The instances outside the view frustum, or
+     * hidden behind the occluders, are left out (see frustumCulling and addOccluder).
+     * @param model The model (its data is kept on the GPU as for scene objects)
+     * @param instances The instances
+     * @param textureName The name of the texture with which to draw the instances
+     *                    whose colour is (0, 0, 0, 0) (see generateTexture)
+     */
+    void renderInstances(const shared_ptr<const Model> &model, const vector<Instance> &instances,
+                         const string &textureName = "");
+
+    /**
+     * Queue a scene object to be rendered by renderQueue, rather than immediately.
+     * The object is kept until then, so it should not be changed in the meantime.
+     * @param sceneObject The scene object
+     */
+    void queueSceneObject(shared_ptr<SceneObject> sceneObject);
+
+    /**
+     * Queue an image to be rendered by renderQueue, rather than immediately
+     * (see renderImage). The vertices are copied.
+     * @param vertices The vertices
+     * @param textureName The name of the texture, containing the image
+     * @param perspective If set to true, use perspective rendering, otherwise use simple (orthographic) rendering.
+     * @param offset	The offset (position) at which the quad of the image will be drawn.
+     */
+    void queueImage(const float *vertices, const string &textureName, const bool &perspective = false,
+                    const glm::vec3 &offset = glm::vec3(0.0f, 0.0f, 0.0f));
+
+    /**
+     * Render everything queued since the last time this was called (see queueSceneObject
+     * and queueImage), sorted so that the OpenGL state changes as little as possible:
+     * images drawn with the orthographic program come first, then those drawn in
+     * perspective and the scene objects, grouped by texture and model. Draws with the
+     * same program, texture and model keep the order in which they were queued, but
+     * draws which depend on the order otherwise (e.g. transparent ones) should be
+     * rendered directly instead. It is called by swapBuffers if anything is still queued.
+     */
+    void renderQueue();
+
+    /**
+     * Get the statistics of the last frame rendered (up to the last call to swapBuffers)
+     * @return The statistics
+     */
+    const RenderStatistics& getLastFrameStatistics() const;
+
+    /**
+     * Get the time from the start of initialisation to the end of the first frame
+     * (the first call to swapBuffers)
+     * @return The time, in milliseconds, or -1 if no frame has been rendered yet
+     */
+    double getTimeToFirstFrame() const;
+
+    /**
+     * Get the number of shader programs which were loaded from the program cache
+     * at initialisation, rather than compiled (see programCachePath)
+     * @return The number of programs (0 to 2)
+     */
+    int getNumProgramsLoadedFromCache() const;
+
+    /**
+     * Print the statistics of the last frame rendered through the Logger
+     */
+    void logStatistics() const;
+
+    /**
+     * Start a pass of the current frame, so that the time the GPU takes to render the
+     * pass is measured separately (see RenderStatistics::passGpuMilliseconds). Passes
+     * can be nested and a pass with the same name can be started more than once in a
+     * frame, in which case the times are added up. Nothing is measured if timer queries
+     * are not supported.
+     * @param name The name of the pass
+     */
+    void beginPass(const string &name);
+
+    /**
+     * End the pass started last (see beginPass). Passes still open at the end of the
+     * frame are ended by swapBuffers.
+     */
+    void endPass();
+
     /**
      * Clears the screen.
      */
@@ -227,7 +1058,10 @@ namespace small3d
 
     /**
      * This is a double buffered system and this commands swaps
-     * the buffers
+     * the buffers. The GPU buffers of models that have been destroyed
+     * since the previous frame are deleted at this point. In headless
+     * mode, there is nothing to swap, so the rendering commands are only
+     * flushed.
      */
     void swapBuffers();
 
@@ -10,6 +10,8 @@
 
 #include <vector>
 #include "Model.hpp"
+#include "ModelCache.hpp"
+#include "FrameAnimation.hpp"
 #include <memory>
 #include "Logger.hpp"
 #include "Image.hpp"
@@ -31,12 +33,15 @@ namespace small3d
   class SceneObject
   {
   private:
-    vector<Model> model;
+    // One model per frame, or only the first frame if the frames share their topology
+    vector<shared_ptr<const Model> > model;
+    shared_ptr<FrameAnimation> frameAnimation;
     bool animating;
     int frameDelay;
     int currentFrame;
     int framesWaited;
     int numFrames;
+    bool interpolateFrames;
     shared_ptr<Image> texture;
     string name;
     shared_ptr<glm::vec4> colour;
@@ -46,6 +51,10 @@ namespace small3d
 
     void initPropVectors();
 
+    // Load a model, through the cache if there is one
+    static shared_ptr<const Model> loadModel(const string &modelPath,
+                                             const shared_ptr<ModelCache> &modelCache);
+
   public:
 
     /**
@@ -62,10 +71,14 @@ namespace small3d
      * 					be the non-moving state.
      * @param boundingBoxesPath The path to the file containing the object's bounding boxes. If no such
      * 							path is given, the object cannot be checked for collision detection.
+     * @param modelCache The cache from which to get the object's model (or frames). Objects using the
+     * 					 same model through the same cache share it, so it is only loaded and stored
+     * 					 once. If no cache is given, the object loads its own copy of the model.
      */
     SceneObject(const string &name, const string &modelPath,
 		const int &numFrames = 1, const string &texturePath = "",
-		const string &boundingBoxesPath = "");
+		const string &boundingBoxesPath = "",
+		const shared_ptr<ModelCache> &modelCache = shared_ptr<ModelCache>());
 
     /**
      * Destructor
@@ -73,10 +86,100 @@ namespace small3d
     virtual ~SceneObject();
 
     /**
-     * Get the object's model
+     * Get the object's model (the current frame, if the object is animated). The model
+     * may be shared with other objects, so it cannot be modified. If the frames of an
+     * animated object share their topology (see getFrameAnimation), this is always the
+     * first frame, which holds the shared topology and texture coordinates, so the
+     * positions and normals of the current frame have to be retrieved with getVertexData
+     * and getNormalsData (or getCompactVertexData and getPackedNormalsData).
      * @return The object's model
      */
-    Model& getModel() ;
+    const Model& getModel() const;
+
+    /**
+     * Get the model of a frame, as shared with the object. If the frames share their
+     * topology (see getFrameAnimation), this is the first frame for every frame.
+     * @param frame The frame (0 for the first one)
+     * @return The model
+     */
+    shared_ptr<const Model> getFrameModel(const int &frame) const;
+
+    /**
+     * Get the number of frames
+     * @return The number of frames (1 if the object is not animated)
+     */
+    int getNumFrames() const;
+
+    /**
+     * Get the current frame
+     * @return The current frame (0 for the first one)
+     */
+    int getCurrentFrame() const;
+
+    /**
+     * Get the frame after the current one (wrapping around to the first)
+     * @return The next frame
+     */
+    int getNextFrame() const;
+
+    /**
+     * Get the vertex data of the current frame
+     * @return The vertex data
+     */
+    const vector<float>& getVertexData() const;
+
+    /**
+     * Get the normals data of the current frame
+     * @return The normals data
+     */
+    const vector<float>& getNormalsData() const;
+
+    /**
+     * Get the compact vertex data of the current frame (see VertexQuantisation.hpp)
+     * @return The compact vertex data
+     */
+    const vector<float>& getCompactVertexData() const;
+
+    /**
+     * Get the packed normals data of the current frame (see VertexQuantisation.hpp)
+     * @return The packed normals data
+     */
+    const vector<unsigned int>& getPackedNormalsData() const;
+
+    /**
+     * Get the vertex data of the frame after the current one, towards which
+     * the current frame is blended when frame interpolation is enabled
+     * @return The vertex data
+     */
+    const vector<float>& getNextVertexData() const;
+
+    /**
+     * Get the normals data of the frame after the current one
+     * @return The normals data
+     */
+    const vector<float>& getNextNormalsData() const;
+
+    /**
+     * Get the compact vertex data of the frame after the current one
+     * @return The compact vertex data
+     */
+    const vector<float>& getNextCompactVertexData() const;
+
+    /**
+     * Get the packed normals data of the frame after the current one
+     * @return The packed normals data
+     */
+    const vector<unsigned int>& getNextPackedNormalsData() const;
+
+    /**
+     * Get the frames of the object, if it is animated and its frames have been found
+     * to share the same topology and texture coordinates when loaded. In that case,
+     * these are only stored once, in the first frame, and only the positions and normals
+     * of the other frames are stored separately. Frames loaded through a ModelCache are
+     * kept whole, since they are shared with other objects.
+     * @return The frames (null if they are not stored this way)
+     */
+    shared_ptr<const FrameAnimation> getFrameAnimation() const;
 
     /**
      * Get the object's texture
@@ -156,6 +259,25 @@ namespace small3d
      */
     void setFrameDelay(const int &delay);
 
+    /**
+     * Enable or disable frame interpolation. When enabled, the renderer blends the
+     * positions and normals of the current frame with those of the next one on the
+     * GPU, according to how many game frames have passed since the current frame was
+     * reached (see getFrameBlend), so that the animation looks smooth even with a
+     * large frame delay and few stored frames. It only has an effect if the frames
+     * share their topology (see getFrameAnimation).
+     * @param interpolate Whether to interpolate between frames
+     */
+    void setFrameInterpolation(const bool &interpolate);
+
+    /**
+     * Get the factor by which the current frame is to be blended with the next one
+     * @return The factor, from 0 (only the current frame) up to, but not including,
+     *         1 (only the next frame). It is always 0 if frame interpolation is not
+     *         enabled or not possible.
+     */
+    float getFrameBlend() const;
+
     /**
      * Process animation (progress current frame if necessary)
      */
@@ -0,0 +1,77 @@
+/*
+ *  VertexQuantisation.hpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#pragma once
+
+#include "Model.hpp"
+
+using namespace std;
+
+namespace small3d {
+
+  /**
+   * Packs a normal into a signed 10:10:10:2 integer, in the layout expected by OpenGL
+   * for GL_INT_2_10_10_10_REV attributes: x in the lowest 10 bits, then y, then z, each
+   * one a normalised value (-1 to 1 mapped to -511 to 511). The 2-bit w component is 0.
+   *
+   * @param	x	The x component of the normal
+   * @param	y	The y component of the normal
+   * @param	z	The z component of the normal
+   *
+   * @return	The packed normal
+   */
+
+  unsigned int packNormal(const float &x, const float &y, const float &z);
+
+  /**
+   * Unpacks a normal packed by packNormal, the same way OpenGL (4.2 and later) does it
+   * when passing it to a shader. Earlier versions map the values very slightly differently
+   * (by less than 0.001).
+   *
+   * @param	packed	The packed normal
+   * @param [out]	x	The x component of the normal
+   * @param [out]	y	The y component of the normal
+   * @param [out]	z	The z component of the normal
+   */
+
+  void unpackNormal(const unsigned int &packed, float &x, float &y, float &z);
+
+  /**
+   * Converts a float to a 16-bit (IEEE 754 binary16) half float, rounding to the nearest
+   * representable value. Values too large for a half float become infinite.
+   *
+   * @param	value	The float
+   *
+   * @return	The half float
+   */
+
+  unsigned short floatToHalf(const float &value);
+
+  /**
+   * Converts a 16-bit half float to a float. The conversion is exact.
+   *
+   * @param	value	The half float
+   *
+   * @return	The float
+   */
+
+  float halfToFloat(const unsigned short &value);
+
+  /**
+   * Fills in the compact vertex format of a model (compactVertexData, packedNormalsData
+   * and halfTextureCoordsData) from its vertex, normals and texture coordinates data.
+   * Each vertex then takes up 20 bytes on the GPU instead of 36: 12 for the position,
+   * 4 for the normal and 4 for the texture coordinates. The original data is left intact,
+   * since it is still used on the CPU (e.g. for collision detection) and as a fallback
+   * on OpenGL 2.1.
+   *
+   * @param [in,out]	model	The model
+   */
+
+  void quantiseVertexData(Model &model);
+}
@@ -9,6 +9,7 @@
 
 #include "ModelLoader.hpp"
 #include <vector>
+#include <fstream>
 
 using namespace std;
 
@@ -27,13 +28,60 @@ namespace small3d {
     // The model to which the data is loaded
     Model* model;
 
-    // Data read from .obj file
-    vector< vector<float> > vertices;
-    vector<vector<int> > facesVertexIndices;
-    vector<vector<float> > normals;
-    vector<vector<int> > facesNormalIndices;
-    vector<vector<float> > textureCoords;
-    vector<vector<int> > textureCoordsIndices;
+    // Whether the file is memory mapped and parsed in place, rather than read line by line
+    bool memoryMapped;
+
+    // Whether the loaded model is also saved to, and loaded from, a binary .s3dmesh file
+    bool useMeshCache;
+
+    // The directory of the .s3dmesh files (empty for the directory of each .obj file)
+    string meshCacheDirectory;
+
+    // Whether the triangles and vertices of the loaded model are reordered for the GPU's caches
+    bool optimiseMesh;
+
+    // Whether the compact vertex format of the loaded model is filled in
+    bool quantise;
+
+    // The number of levels of detail generated for the loaded model, including the model itself
+    int levelsOfDetail;
+
+    // The number of chunks into which memory mapped files are split, to be parsed
+    // at the same time (0 to decide based on the file size and the hardware)
+    int parsingThreads;
+
+    // Data read from .obj file, in flat arrays: 3 components per vertex and normal,
+    // 2 per texture coordinates pair and 3 indices per face (still 1-based, as in the file)
+    vector<float> vertices;
+    vector<int> facesVertexIndices;
+    vector<float> normals;
+    vector<int> facesNormalIndices;
+    vector<float> textureCoords;
+    vector<int> textureCoordsIndices;
+
+    // The unique vertices of the model, after welding: 3 indices per vertex, to its position,
+    // texture coordinates and normal in the data read from the file (1-based, 0 if absent)
+    vector<int> weldedVertices;
+
+    // 3 indices per face, to the welded vertices (0-based)
+    vector<unsigned int> weldedIndices;
+
+    // Count the vertices, normals, texture coordinates and faces in the file's contents
+    // and reserve the data arrays accordingly, so that they are only allocated once
+    void reserveData(const char* data, const char* dataEnd);
+
+    // Parse the file line by line, from a stream
+    void parseStream(ifstream &file);
+
+    // Parse the whole contents of a file in place, in a single pass
+    void parseData(const char* data, const char* dataEnd);
+
+    // Split the whole contents of a file into chunks, at line boundaries, parse them
+    // on separate threads and concatenate the results in order
+    void parseDataInParallel(const char* data, const char* dataEnd);
+
+    // Parse a single face ("f") line, with the position right after the "f"
+    void parseFace(const char* pos, const char* lineEnd);
 
     void loadVertexData();
 
@@ -43,10 +91,21 @@ namespace small3d {
 
     void loadTextureCoordsData();
 
-    // Make sure that no texture coordinate information is lost when the data buffers get created (vertexData,
-    // indexData, normalsData and textureCoordsData) by realigning the data vectors, in order to ensure unique
-    // vertex - texture coordinates pairs
-    void correctDataVectors();
+    // Fill in (or clear) the compact vertex format of the model
+    void loadCompactData(Model &model);
+
+    // Generate the lower levels of detail of the model, if it has fewer than requested, or
+    // drop the extra ones, if it has more. Returns true if more levels have been generated.
+    bool loadLevelsOfDetail(Model &model);
+
+    // Save the model to its .s3dmesh file, if possible
+    void saveMeshCache(const string &meshCacheLocation, const Model &model, const string &fileLocation);
+
+    // Create one vertex for each unique position - texture coordinates - normal combination
+    // referenced by the faces, so that no information is lost when the data buffers get
+    // created (vertexData, indexData, normalsData and textureCoordsData), while keeping the
+    // number of vertices to the minimum, and point the faces to these vertices.
+    void weldVertices();
 
     void init();
 
@@ -55,13 +114,92 @@ namespace small3d {
   public:
 
     /**
-     * @fn	WavefrontLoader::WavefrontLoader();
+     * @fn	WavefrontLoader::WavefrontLoader(const bool &memoryMapped, const bool &useMeshCache,
+     * 		const bool &optimiseMesh, const bool &quantise, const int &levelsOfDetail);
+     *
+     * @brief	Constructor.
+     *
+     * @param	memoryMapped	If true (default), each file is mapped into memory and parsed
+     * 						in place, in one pass, without allocating memory per token.
+     * 						Otherwise it is read line by line.
+     * @param	useMeshCache	If true, after a .obj file has been parsed, the resulting model
+     * 						is saved to a binary .s3dmesh file (see BinaryMeshLoader), in the
+     * 						same directory and with the same name, unless another directory
+     * 						is set (see setMeshCacheDirectory). The next time the .obj file is
+     * 						loaded, if it has not changed, the model is read from the .s3dmesh
+     * 						file instead, without any parsing. The default is false, so that
+     * 						nothing is written unless asked for.
+     * @param	optimiseMesh	If true, the triangles of the model are reordered for better use
+     * 						of the post-transform vertex cache and its vertices for sequential
+     * 						fetching (see MeshOptimisation.hpp), and the average cache miss ratio
+     * 						before and after that is logged. Since this happens before the
+     * 						.s3dmesh file is saved, it only costs time the first time a model
+     * 						is loaded, if the mesh cache is used. The default is false, so that
+     * 						the vertices and faces stay in the order of the file.
+     * @param	quantise		If true, the compact vertex format of the model is also filled
+     * 						in (see VertexQuantisation.hpp), so that the Renderer uploads
+     * 						20 instead of 36 bytes per vertex to the GPU. The default is false.
+     * @param	levelsOfDetail	The number of levels of detail of the model, including the model
+     * 						itself (see MeshSimplification.hpp). Each lower level has about half
+     * 						the triangles of the previous one and the Renderer draws the ones
+     * 						with fewer triangles further away from the camera. Like the mesh
+     * 						optimisation, the levels are saved in the .s3dmesh file, so they are
+     * 						only generated once. The default is 1 (no lower levels).
+     */
+
+    WavefrontLoader(const bool &memoryMapped = true, const bool &useMeshCache = false,
+                    const bool &optimiseMesh = false, const bool &quantise = false,
+                    const int &levelsOfDetail = 1);
+
+    /**
+     * @fn	string WavefrontLoader::getMeshCacheLocation(const string &fileLocation,
+     * 		const bool &optimisedMesh, const string &meshCacheDirectory);
+     *
+     * @brief	Get the location of the binary .s3dmesh file corresponding to a .obj file.
+     *
+     * @param	fileLocation	Path to the .obj file.
+     * @param	optimisedMesh	Whether the cached model is optimised (see the constructor).
+     * 						Models which are not are cached in .unoptimised.s3dmesh files.
+     * @param	meshCacheDirectory	The directory of the .s3dmesh files (see setMeshCacheDirectory),
+     * 						or empty for the directory of the .obj file.
+     *
+     * @return	Path to the .s3dmesh file.
+     */
+
+    static string getMeshCacheLocation(const string &fileLocation, const bool &optimisedMesh = true,
+                                       const string &meshCacheDirectory = "");
+
+    /**
+     * @fn	void WavefrontLoader::setMeshCacheDirectory(const string &directory);
+     *
+     * @brief	Set the directory where the .s3dmesh files are saved and looked for, if the
+     * 			mesh cache is used (see the constructor), instead of the directory of each
+     * 			.obj file, e.g. so that nothing is written next to the game's assets. The file
+     * 			of each model is named after the whole path to its .obj file, so models with
+     * 			the same name in different directories do not overwrite each other.
+     *
+     * @param	directory	The directory, relative to the game's execution directory and ending
+     * 					with a slash. It has to exist. Empty (the default) for the directory
+     * 					of each .obj file.
+     */
+
+    void setMeshCacheDirectory(const string &directory);
+
+    /**
+     * @fn	void WavefrontLoader::setParsingThreads(const int &numThreads);
      *
-     * @brief	Default constructor.
+     * @brief	Set the number of threads parsing each memory mapped file. The file is split
+     * 			into that many chunks, at line boundaries, which are parsed at the same time
+     * 			and then joined, producing exactly the same model as parsing it on a single
+     * 			thread. By default (0), large files are split into as many chunks as the
+     * 			hardware threads, as long as each chunk is at least 1MB, and smaller files
+     * 			are parsed on a single thread. Files which are read line by line (see the
+     * 			constructor) are always parsed on a single thread.
      *
+     * @param	numThreads	The number of threads (1 for a single thread, 0 for the default)
      */
 
-    WavefrontLoader();
+    void setParsingThreads(const int &numThreads);
 
     /**
      * @fn	WavefrontLoader::~WavefrontLoader();
@@ -3,41 +3,37 @@
 attribute vec4 position;
 attribute vec3 normal;
 attribute vec2 uvCoords;
+attribute vec4 nextPosition;
+attribute vec3 nextNormal;
 
-uniform vec3 offset;
-uniform mat4 perspectiveMatrix;
-uniform mat4 xRotationMatrix;
-uniform mat4 yRotationMatrix;
-uniform mat4 zRotationMatrix;
+// The object's rotation and offset, the rotation of its normals and its colour,
+// set once per object (or instance)
+attribute mat4 modelMatrix;
+attribute mat3 normalMatrix;
+attribute vec4 colour;
 
-uniform vec3 cameraPosition;
+// How far the animation has progressed from the current frame towards the next one
+uniform float frameBlend;
 
-uniform mat4 xCameraRotationMatrix;
-uniform mat4 yCameraRotationMatrix;
-uniform mat4 zCameraRotationMatrix;
+// The camera's view transformation, combined with the perspective projection
+uniform mat4 viewProjectionMatrix;
 
 uniform vec3 lightDirection;
 
 varying float cosAngIncidence;
 varying vec2 textureCoords;
+varying vec4 objectColour;
 
 void main()
 {
-   vec4 worldPos = position * zRotationMatrix * xRotationMatrix 
-			* yRotationMatrix
-			+ vec4(offset.x, offset.y, offset.z, 0.0);
+    vec4 blendedPosition = mix(position, nextPosition, frameBlend);
+    vec3 blendedNormal = mix(normal, nextNormal, frameBlend);
 
-    // Only turning the camera around the y axis for now
-    vec4 cameraPos = (worldPos - vec4(cameraPosition.x, cameraPosition.y, cameraPosition.z, 0.0))
-			* yCameraRotationMatrix * xCameraRotationMatrix * zCameraRotationMatrix;
+    gl_Position = viewProjectionMatrix * (modelMatrix * blendedPosition);
 
-    gl_Position = perspectiveMatrix * cameraPos;
+    vec3 normalInWorld = normalize(normalMatrix * blendedNormal);
 
-    vec4 normalInWorld = normalize(perspectiveMatrix * (vec4(normal, 1) * zRotationMatrix * xRotationMatrix 
-			* yRotationMatrix));   
-    
-    vec4 lightDirectionWorld = normalize(perspectiveMatrix * vec4(lightDirection, 1));
-
-    cosAngIncidence = clamp(dot(normalInWorld, lightDirectionWorld), 0, 1);
+    cosAngIncidence = clamp(dot(normalInWorld, normalize(lightDirection)), 0.0, 1.0);
     textureCoords = uvCoords; 
+    objectColour = colour;
 }
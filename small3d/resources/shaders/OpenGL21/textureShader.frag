@@ -2,14 +2,14 @@
 
 varying float cosAngIncidence;
 varying vec2 textureCoords;
+varying vec4 objectColour;
 uniform sampler2D textureImage;
-uniform vec4 colour;
 uniform float lightIntensity;
 
 void main()
 {
-  if (colour != vec4(0, 0, 0, 0)) {
-    gl_FragColor = cosAngIncidence * colour;
+  if (objectColour != vec4(0, 0, 0, 0)) {
+    gl_FragColor = cosAngIncidence * objectColour;
 }
 else {
   if (lightIntensity == -1)
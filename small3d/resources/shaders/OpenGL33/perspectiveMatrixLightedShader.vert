@@ -3,41 +3,41 @@
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 uvCoords;
+layout(location = 3) in vec4 nextPosition;
+layout(location = 4) in vec3 nextNormal;
+
+// The object's rotation and offset, the rotation of its normals and its colour. They are
+// set once per object, or read per instance when drawing instances of the same model.
+layout(location = 5) in mat4 modelMatrix;
+layout(location = 9) in mat3 normalMatrix;
+layout(location = 12) in vec4 colour;
 
 smooth out float cosAngIncidence;
 out vec2 textureCoords;
+flat out vec4 objectColour;
 
-uniform vec3 offset;
-uniform mat4 perspectiveMatrix;
-
-uniform mat4 xRotationMatrix;
-uniform mat4 yRotationMatrix;
-uniform mat4 zRotationMatrix;
-
-uniform vec3 cameraPosition;
+// How far the animation has progressed from the current frame towards the next one
+uniform float frameBlend;
 
-uniform mat4 xCameraRotationMatrix;
-uniform mat4 yCameraRotationMatrix;
-uniform mat4 zCameraRotationMatrix;
-
-uniform vec3 lightDirection;
+// The camera and lighting, which are the same for every object in a frame,
+// so they are uploaded once per frame (it is declared in the fragment shader too)
+layout(std140) uniform FrameUniforms
+{
+    mat4 viewProjectionMatrix;
+    vec3 lightDirection;
+    float lightIntensity;
+};
 
 void main()
 {
-    vec4 worldPos = position * zRotationMatrix * xRotationMatrix 
-			* yRotationMatrix
-			+ vec4(offset.x, offset.y, offset.z, 0.0);
-
-    vec4 cameraPos = (worldPos - vec4(cameraPosition.x, cameraPosition.y, cameraPosition.z, 0.0))
-			 * yCameraRotationMatrix * xCameraRotationMatrix * zCameraRotationMatrix;
+    vec4 blendedPosition = mix(position, nextPosition, frameBlend);
+    vec3 blendedNormal = mix(normal, nextNormal, frameBlend);
 
-    gl_Position = perspectiveMatrix * cameraPos;
+    gl_Position = viewProjectionMatrix * (modelMatrix * blendedPosition);
 
-    vec4 normalInWorld = normalize(perspectiveMatrix * (vec4(normal, 1) * zRotationMatrix * xRotationMatrix 
-			* yRotationMatrix));   
-    
-    vec4 lightDirectionWorld = normalize(perspectiveMatrix * vec4(lightDirection, 1));
+    vec3 normalInWorld = normalize(normalMatrix * blendedNormal);
 
-    cosAngIncidence = clamp(dot(normalInWorld, lightDirectionWorld), 0, 1);
+    cosAngIncidence = clamp(dot(normalInWorld, normalize(lightDirection)), 0, 1);
     textureCoords = uvCoords;
+    objectColour = colour;
 }
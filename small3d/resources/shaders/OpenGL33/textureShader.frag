@@ -2,16 +2,23 @@
 
 smooth in float cosAngIncidence;
 in vec2 textureCoords;
+flat in vec4 objectColour;
 uniform sampler2D textureImage;
-uniform vec4 colour;
-uniform float lightIntensity;
+
+// The same block as in the vertex shader
+layout(std140) uniform FrameUniforms
+{
+    mat4 viewProjectionMatrix;
+    vec3 lightDirection;
+    float lightIntensity;
+};
 
 out vec4 outputColour;
 
 void main()
 {
-if (colour != vec4(0, 0, 0, 0)) {
-    outputColour = cosAngIncidence * colour;
+if (objectColour != vec4(0, 0, 0, 0)) {
+    outputColour = cosAngIncidence * objectColour;
 }
 else {
   if (lightIntensity == -1)
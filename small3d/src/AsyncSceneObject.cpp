@@ -0,0 +1,57 @@
+/*
+ *  AsyncSceneObject.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "AsyncSceneObject.hpp"
+#include <chrono>
+
+using namespace std;
+
+namespace small3d {
+
+  // The SceneObject constructor takes references, so the thread gets its own copies
+  static shared_ptr<SceneObject> loadSceneObject(const string name, const string modelPath,
+                                                 const int numFrames, const string texturePath,
+                                                 const string boundingBoxesPath,
+                                                 const shared_ptr<ModelCache> modelCache) {
+    return shared_ptr<SceneObject>(new SceneObject(name, modelPath, numFrames, texturePath,
+                                                   boundingBoxesPath, modelCache));
+  }
+
+  AsyncSceneObject::AsyncSceneObject(const string &name, const string &modelPath,
+                                     const int &numFrames, const string &texturePath,
+                                     const string &boundingBoxesPath,
+                                     const shared_ptr<ModelCache> &modelCache) {
+    // The logger must exist before the loading thread uses it
+    initLogger();
+    this->name = name;
+
+    LOGDEBUG("Loading " + name + " in the background");
+
+    loading = async(launch::async, loadSceneObject, name, modelPath, numFrames, texturePath,
+                    boundingBoxesPath, modelCache).share();
+  }
+
+  AsyncSceneObject::~AsyncSceneObject() {
+    if (loading.valid()) {
+      loading.wait();
+    }
+  }
+
+  bool AsyncSceneObject::isReady() const {
+    return loading.wait_for(chrono::seconds(0)) == future_status::ready;
+  }
+
+  shared_ptr<SceneObject> AsyncSceneObject::get() const {
+    return loading.get();
+  }
+
+  const string AsyncSceneObject::getName() const {
+    return name;
+  }
+
+}
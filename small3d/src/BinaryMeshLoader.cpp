@@ -0,0 +1,281 @@
+/*
+ *  BinaryMeshLoader.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "BinaryMeshLoader.hpp"
+#include "MappedFile.hpp"
+#include "FileFunctions.hpp"
+#include "Exception.hpp"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <SDL.h>
+
+using namespace std;
+
+namespace small3d {
+
+  static const char meshFileMagic[8] = {'S', '3', 'D', 'M', 'E', 'S', 'H', '\0'};
+
+  // Increase whenever the layout of the file changes
+  static const uint32_t meshFileVersion = 5;
+
+  // The header of an .s3dmesh file. It is followed by the vertex data, the index data,
+  // the normals data and the texture coordinates data, in that order, and then by the
+  // number of indices of each lower level of detail and their index data.
+  struct MeshFileHeader {
+    char magic[8];
+    uint32_t version;
+    // Always 4. Files written with 16-bit indices are loaded from their source again.
+    uint32_t indexWidth;
+    uint64_t sourceSize;
+    int64_t sourceModificationTime;
+    uint32_t vertexDataCount;
+    uint32_t indexDataCount;
+    uint32_t normalsDataCount;
+    uint32_t textureCoordsDataCount;
+    uint32_t levelsOfDetailCount;
+    uint32_t reserved;
+    uint64_t checksum;
+  };
+
+  static_assert(sizeof(MeshFileHeader) == 64, "Unexpected .s3dmesh header layout");
+
+  // 64-bit FNV-1a hash
+  static uint64_t calculateChecksum(uint64_t hash, const void* data, const size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t idx = 0; idx != size; ++idx) {
+      hash ^= bytes[idx];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  static const uint64_t checksumSeed = 14695981039346656037ULL;
+
+  // Get the size and modification time of a file. Returns false if the file does not exist.
+  static bool getFileStamp(const string &filePath, uint64_t &size, int64_t &modificationTime) {
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0) {
+      return false;
+    }
+    size = static_cast<uint64_t>(fileStat.st_size);
+    modificationTime = static_cast<int64_t>(fileStat.st_mtime);
+    return true;
+  }
+
+  BinaryMeshLoader::BinaryMeshLoader() {
+
+  }
+
+  BinaryMeshLoader::~BinaryMeshLoader() {
+
+  }
+
+  void BinaryMeshLoader::load(const string &fileLocation, Model &model) {
+    if (!tryLoad(fileLocation, model)) {
+      throw Exception("Could not load binary mesh file " + string(SDL_GetBasePath()) + fileLocation);
+    }
+  }
+
+  bool BinaryMeshLoader::tryLoad(const string &fileLocation, Model &model, const string &sourceFileLocation) {
+    string filePath = SDL_GetBasePath() + fileLocation;
+
+    uint64_t sourceSize = 0;
+    int64_t sourceModificationTime = 0;
+
+    if (sourceFileLocation != "" &&
+        !getFileStamp(SDL_GetBasePath() + sourceFileLocation, sourceSize, sourceModificationTime)) {
+      return false;
+    }
+
+    uint64_t fileSize = 0;
+    int64_t fileModificationTime = 0;
+
+    if (!getFileStamp(filePath, fileSize, fileModificationTime) || fileSize < sizeof(MeshFileHeader)) {
+      return false;
+    }
+
+    unique_ptr<MappedFile> mappedFile;
+
+    try {
+      mappedFile = unique_ptr<MappedFile>(new MappedFile(filePath));
+    }
+    catch (const Exception &) {
+      return false;
+    }
+
+    const MappedFile &file = *mappedFile;
+
+    if (file.getSize() < sizeof(MeshFileHeader)) {
+      return false;
+    }
+
+    MeshFileHeader header;
+    memcpy(&header, file.getData(), sizeof(MeshFileHeader));
+
+    if (memcmp(header.magic, meshFileMagic, sizeof(meshFileMagic)) != 0 || header.version != meshFileVersion) {
+      return false;
+    }
+
+    if (sourceFileLocation != "" &&
+        (header.sourceSize != sourceSize || header.sourceModificationTime != sourceModificationTime)) {
+      return false;
+    }
+
+    if (header.indexWidth != sizeof(unsigned int)) {
+      return false;
+    }
+
+    uint64_t dataSize = (static_cast<uint64_t>(header.vertexDataCount) + header.normalsDataCount +
+                         header.textureCoordsDataCount) * sizeof(float) +
+                        static_cast<uint64_t>(header.indexDataCount) * header.indexWidth +
+                        static_cast<uint64_t>(header.levelsOfDetailCount) * sizeof(uint32_t);
+
+    if (file.getSize() < sizeof(MeshFileHeader) + dataSize) {
+      return false;
+    }
+
+    const char* data = file.getData() + sizeof(MeshFileHeader);
+
+    // The lower levels of detail come after the rest of the data
+    const char* levelsOfDetailData = data + dataSize - header.levelsOfDetailCount * sizeof(uint32_t);
+    vector<uint32_t> levelOfDetailCounts(header.levelsOfDetailCount);
+    if (header.levelsOfDetailCount > 0) {
+      memcpy(levelOfDetailCounts.data(), levelsOfDetailData, header.levelsOfDetailCount * sizeof(uint32_t));
+    }
+
+    for (uint32_t level = 0; level != header.levelsOfDetailCount; ++level) {
+      dataSize += static_cast<uint64_t>(levelOfDetailCounts[level]) * header.indexWidth;
+    }
+
+    if (file.getSize() != sizeof(MeshFileHeader) + dataSize) {
+      return false;
+    }
+
+    if (calculateChecksum(checksumSeed, data, static_cast<size_t>(dataSize)) != header.checksum) {
+      return false;
+    }
+
+    model.vertexData.resize(header.vertexDataCount);
+    model.indexData.resize(header.indexDataCount);
+    model.normalsData.resize(header.normalsDataCount);
+    model.textureCoordsData.resize(header.textureCoordsDataCount);
+
+    size_t vertexDataBytes = header.vertexDataCount * sizeof(float);
+    size_t indexDataBytes = header.indexDataCount * header.indexWidth;
+    size_t normalsDataBytes = header.normalsDataCount * sizeof(float);
+    size_t textureCoordsDataBytes = header.textureCoordsDataCount * sizeof(float);
+
+    if (vertexDataBytes > 0) memcpy(model.vertexData.data(), data, vertexDataBytes);
+    data += vertexDataBytes;
+    if (indexDataBytes > 0) memcpy(model.indexData.data(), data, indexDataBytes);
+    data += indexDataBytes;
+    if (normalsDataBytes > 0) memcpy(model.normalsData.data(), data, normalsDataBytes);
+    data += normalsDataBytes;
+    if (textureCoordsDataBytes > 0) memcpy(model.textureCoordsData.data(), data, textureCoordsDataBytes);
+    data += textureCoordsDataBytes + header.levelsOfDetailCount * sizeof(uint32_t);
+
+    model.lodIndexData.clear();
+    model.lodIndexData.resize(header.levelsOfDetailCount);
+
+    for (uint32_t level = 0; level != header.levelsOfDetailCount; ++level) {
+      size_t levelBytes = levelOfDetailCounts[level] * header.indexWidth;
+      model.lodIndexData[level].resize(levelOfDetailCounts[level]);
+      if (levelBytes > 0) memcpy(model.lodIndexData[level].data(), data, levelBytes);
+      data += levelBytes;
+    }
+
+    model.vertexDataSize = static_cast<int>(vertexDataBytes);
+    model.indexDataSize = static_cast<int>(indexDataBytes);
+    model.normalsDataSize = static_cast<int>(normalsDataBytes);
+    model.textureCoordsDataSize = static_cast<int>(textureCoordsDataBytes);
+
+    model.calculateBoundingVolumes();
+
+    return true;
+  }
+
+  void BinaryMeshLoader::save(const string &fileLocation, const Model &model, const string &sourceFileLocation) {
+    string filePath = SDL_GetBasePath() + fileLocation;
+
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(MeshFileHeader));
+    memcpy(header.magic, meshFileMagic, sizeof(meshFileMagic));
+    header.version = meshFileVersion;
+    header.indexWidth = sizeof(unsigned int);
+
+    if (sourceFileLocation != "" &&
+        !getFileStamp(SDL_GetBasePath() + sourceFileLocation, header.sourceSize, header.sourceModificationTime)) {
+      throw Exception("Could not find file " + string(SDL_GetBasePath()) + sourceFileLocation);
+    }
+
+    header.vertexDataCount = static_cast<uint32_t>(model.vertexData.size());
+    header.indexDataCount = static_cast<uint32_t>(model.getNumIndexes());
+    header.normalsDataCount = static_cast<uint32_t>(model.normalsData.size());
+    header.textureCoordsDataCount = static_cast<uint32_t>(model.textureCoordsData.size());
+    header.levelsOfDetailCount = static_cast<uint32_t>(model.getNumLevelsOfDetail() - 1);
+
+    vector<uint32_t> levelOfDetailCounts(header.levelsOfDetailCount);
+    for (uint32_t level = 0; level != header.levelsOfDetailCount; ++level) {
+      levelOfDetailCounts[level] = static_cast<uint32_t>(model.getNumIndexes(level + 1));
+    }
+
+    size_t vertexDataBytes = model.vertexData.size() * sizeof(float);
+    size_t indexDataBytes = model.indexData.size() * sizeof(unsigned int);
+    size_t normalsDataBytes = model.normalsData.size() * sizeof(float);
+    size_t textureCoordsDataBytes = model.textureCoordsData.size() * sizeof(float);
+
+    uint64_t checksum = checksumSeed;
+    checksum = calculateChecksum(checksum, model.vertexData.data(), vertexDataBytes);
+    checksum = calculateChecksum(checksum, model.indexData.data(), indexDataBytes);
+    checksum = calculateChecksum(checksum, model.normalsData.data(), normalsDataBytes);
+    checksum = calculateChecksum(checksum, model.textureCoordsData.data(), textureCoordsDataBytes);
+    checksum = calculateChecksum(checksum, levelOfDetailCounts.data(), levelOfDetailCounts.size() * sizeof(uint32_t));
+    for (uint32_t level = 0; level != header.levelsOfDetailCount; ++level) {
+      checksum = calculateChecksum(checksum, model.lodIndexData[level].data(),
+                                   levelOfDetailCounts[level] * sizeof(unsigned int));
+    }
+    header.checksum = checksum;
+
+    string temporaryFilePath = getTemporaryFilePath(filePath);
+
+    ofstream file(temporaryFilePath.c_str(), ios::out | ios::binary | ios::trunc);
+
+    if (!file.is_open()) {
+      throw Exception("Could not create file " + temporaryFilePath);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(MeshFileHeader));
+    file.write(reinterpret_cast<const char*>(model.vertexData.data()), static_cast<streamsize>(vertexDataBytes));
+    file.write(reinterpret_cast<const char*>(model.indexData.data()), static_cast<streamsize>(indexDataBytes));
+    file.write(reinterpret_cast<const char*>(model.normalsData.data()), static_cast<streamsize>(normalsDataBytes));
+    file.write(reinterpret_cast<const char*>(model.textureCoordsData.data()),
+               static_cast<streamsize>(textureCoordsDataBytes));
+    file.write(reinterpret_cast<const char*>(levelOfDetailCounts.data()),
+               static_cast<streamsize>(levelOfDetailCounts.size() * sizeof(uint32_t)));
+    for (uint32_t level = 0; level != header.levelsOfDetailCount; ++level) {
+      file.write(reinterpret_cast<const char*>(model.lodIndexData[level].data()),
+                 static_cast<streamsize>(levelOfDetailCounts[level] * sizeof(unsigned int)));
+    }
+    file.close();
+
+    if (file.fail()) {
+      remove(temporaryFilePath.c_str());
+      throw Exception("Could not write file " + temporaryFilePath);
+    }
+
+    // Replacing the file in one step, so that it is never missing for anyone loading it
+    if (!replaceFile(temporaryFilePath, filePath)) {
+      throw Exception("Could not create file " + filePath);
+    }
+  }
+
+}
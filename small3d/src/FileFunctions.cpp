@@ -0,0 +1,53 @@
+/*
+ *  FileFunctions.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "FileFunctions.hpp"
+#include <cstdio>
+#include <sstream>
+#include <atomic>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace small3d {
+
+  string getTemporaryFilePath(const string &filePath) {
+    static atomic<unsigned long> numTemporaryFiles(0);
+    stringstream ss;
+#ifdef _WIN32
+    ss << filePath << "." << _getpid();
+#else
+    ss << filePath << "." << getpid();
+#endif
+    ss << "." << hash<thread::id>()(this_thread::get_id()) << "." << numTemporaryFiles++ << ".tmp";
+    return ss.str();
+  }
+
+  bool replaceFile(const string &temporaryFilePath, const string &filePath) {
+#ifdef _WIN32
+    // rename does not replace existing files on Windows
+    bool renamed = MoveFileExA(temporaryFilePath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = rename(temporaryFilePath.c_str(), filePath.c_str()) == 0;
+#endif
+
+    if (!renamed) {
+      remove(temporaryFilePath.c_str());
+    }
+    return renamed;
+  }
+
+}
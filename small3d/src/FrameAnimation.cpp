@@ -0,0 +1,264 @@
+/*
+ *  FrameAnimation.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "FrameAnimation.hpp"
+#include "MeshOptimisation.hpp"
+#include "VertexQuantisation.hpp"
+#include "Exception.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+namespace small3d {
+
+  // Reorder per-vertex data, with the given number of components per vertex,
+  // after the vertices have been reordered by optimiseVertexFetch
+  static void remapVertices(vector<float> &data, const vector<unsigned int> &vertexRemap,
+                            const size_t &numComponents) {
+    vector<float> remappedData(data.size());
+    for (size_t vertex = 0; vertex != vertexRemap.size(); ++vertex) {
+      for (size_t component = 0; component != numComponents; ++component) {
+        remappedData[numComponents * vertexRemap[vertex] + component] = data[numComponents * vertex + component];
+      }
+    }
+    data.swap(remappedData);
+  }
+
+  FrameAnimation::FrameAnimation(const shared_ptr<const Model> &firstFrame) {
+    this->firstFrame = firstFrame;
+  }
+
+  shared_ptr<FrameAnimation> FrameAnimation::create(const vector<shared_ptr<Model> > &frames,
+                                                    const bool &optimiseMesh) {
+    if (frames.empty()) {
+      return shared_ptr<FrameAnimation>();
+    }
+
+    const Model &model = *frames[0];
+    size_t numIndexes = model.getNumIndexes();
+    bool hasTextureCoords = !model.textureCoordsData.empty();
+
+    for (size_t frame = 1; frame != frames.size(); ++frame) {
+      if (frames[frame]->getNumIndexes() != numIndexes ||
+          frames[frame]->textureCoordsData.empty() == hasTextureCoords) {
+        return shared_ptr<FrameAnimation>();
+      }
+    }
+
+    // Number the vertices of each face corner so that two corners share a vertex
+    // only if they share one in every frame (in order of first use, like the loader)
+    vector<unsigned int> cornerVertices(numIndexes);
+    size_t numVertices = model.vertexData.size() / 4;
+    for (size_t corner = 0; corner != numIndexes; ++corner) {
+      cornerVertices[corner] = model.indexData[corner];
+    }
+
+    for (size_t frame = 1; frame != frames.size(); ++frame) {
+      unordered_map<uint64_t, unsigned int> vertices;
+      vertices.reserve(numVertices);
+      for (size_t corner = 0; corner != numIndexes; ++corner) {
+        uint64_t key = (static_cast<uint64_t>(cornerVertices[corner]) << 32) | frames[frame]->indexData[corner];
+        cornerVertices[corner] = vertices.insert(make_pair(key, static_cast<unsigned int>(vertices.size())))
+            .first->second;
+      }
+      numVertices = vertices.size();
+    }
+
+    // Frames whose faces are connected differently can only be matched by splitting
+    // vertices, which may take up more memory than storing them separately
+    if (numVertices > model.vertexData.size() / 4) {
+      return shared_ptr<FrameAnimation>();
+    }
+
+    // A face corner of each vertex, from which its data is taken in each frame
+    vector<size_t> vertexCorners(numVertices, numIndexes);
+    for (size_t corner = 0; corner != numIndexes; ++corner) {
+      if (vertexCorners[cornerVertices[corner]] == numIndexes) {
+        vertexCorners[cornerVertices[corner]] = corner;
+      }
+    }
+
+    // The texture coordinates have to be the same at every corner in every frame
+    if (hasTextureCoords) {
+      for (size_t frame = 1; frame != frames.size(); ++frame) {
+        for (size_t corner = 0; corner != numIndexes; ++corner) {
+          const float* textureCoords = &model.textureCoordsData[2 * model.indexData[corner]];
+          const float* frameTextureCoords = &frames[frame]->textureCoordsData[2 * frames[frame]->indexData[corner]];
+          if (textureCoords[0] != frameTextureCoords[0] || textureCoords[1] != frameTextureCoords[1]) {
+            return shared_ptr<FrameAnimation>();
+          }
+        }
+      }
+    }
+
+    vector<vector<float> > vertexData(frames.size()), normalsData(frames.size());
+
+    for (size_t frame = 0; frame != frames.size(); ++frame) {
+      vertexData[frame].resize(4 * numVertices);
+      normalsData[frame].resize(3 * numVertices);
+      for (size_t vertex = 0; vertex != numVertices; ++vertex) {
+        unsigned int frameVertex = frames[frame]->indexData[vertexCorners[vertex]];
+        for (size_t component = 0; component != 4; ++component) {
+          vertexData[frame][4 * vertex + component] = frames[frame]->vertexData[4 * frameVertex + component];
+        }
+        for (size_t component = 0; component != 3; ++component) {
+          normalsData[frame][3 * vertex + component] = frames[frame]->normalsData[3 * frameVertex + component];
+        }
+      }
+    }
+
+    shared_ptr<Model> firstFrame(new Model());
+    firstFrame->vertexData.swap(vertexData[0]);
+    firstFrame->vertexDataSize = static_cast<int>(firstFrame->vertexData.size() * sizeof(float));
+    firstFrame->normalsData.swap(normalsData[0]);
+    firstFrame->normalsDataSize = static_cast<int>(firstFrame->normalsData.size() * sizeof(float));
+    firstFrame->indexData.swap(cornerVertices);
+    firstFrame->indexDataSize = static_cast<int>(firstFrame->indexData.size() * sizeof(unsigned int));
+
+    if (hasTextureCoords) {
+      firstFrame->textureCoordsData.resize(2 * numVertices);
+      for (size_t vertex = 0; vertex != numVertices; ++vertex) {
+        unsigned int frameVertex = model.indexData[vertexCorners[vertex]];
+        firstFrame->textureCoordsData[2 * vertex] = model.textureCoordsData[2 * frameVertex];
+        firstFrame->textureCoordsData[2 * vertex + 1] = model.textureCoordsData[2 * frameVertex + 1];
+      }
+      firstFrame->textureCoordsDataSize = static_cast<int>(firstFrame->textureCoordsData.size() * sizeof(float));
+    }
+
+    if (optimiseMesh) {
+      optimiseVertexCache(*firstFrame);
+      vector<unsigned int> vertexRemap;
+      optimiseVertexFetch(*firstFrame, &vertexRemap);
+      for (size_t frame = 1; frame != frames.size(); ++frame) {
+        remapVertices(vertexData[frame], vertexRemap, 4);
+        remapVertices(normalsData[frame], vertexRemap, 3);
+      }
+    }
+
+    // The bounding volumes of the first frame contain every frame, since it is
+    // the model the renderer culls the animation by
+    vector<const vector<float>*> otherFrames;
+    for (size_t frame = 1; frame != frames.size(); ++frame) {
+      otherFrames.push_back(&vertexData[frame]);
+    }
+    firstFrame->calculateBoundingVolumes(otherFrames);
+
+    bool quantised = model.isQuantised();
+    if (quantised) {
+      quantiseVertexData(*firstFrame);
+    }
+
+    shared_ptr<FrameAnimation> frameAnimation(new FrameAnimation(firstFrame));
+
+    // The frames after the first one are only kept in the compact format, if the
+    // animation is quantised
+    for (size_t frame = 1; frame != frames.size(); ++frame) {
+      if (quantised) {
+        Model frameModel;
+        frameModel.vertexData.swap(vertexData[frame]);
+        frameModel.normalsData.swap(normalsData[frame]);
+        quantiseVertexData(frameModel);
+        frameAnimation->compactVertexData.push_back(vector<float>());
+        frameAnimation->compactVertexData.back().swap(frameModel.compactVertexData);
+        frameAnimation->packedNormalsData.push_back(vector<unsigned int>());
+        frameAnimation->packedNormalsData.back().swap(frameModel.packedNormalsData);
+      }
+      else {
+        frameAnimation->vertexData.push_back(vector<float>());
+        frameAnimation->vertexData.back().swap(vertexData[frame]);
+        frameAnimation->normalsData.push_back(vector<float>());
+        frameAnimation->normalsData.back().swap(normalsData[frame]);
+      }
+    }
+
+    return frameAnimation;
+  }
+
+  const shared_ptr<const Model>& FrameAnimation::getFirstFrame() const {
+    return firstFrame;
+  }
+
+  int FrameAnimation::getNumFrames() const {
+    return static_cast<int>(max(vertexData.size(), compactVertexData.size())) + 1;
+  }
+
+  bool FrameAnimation::isQuantised() const {
+    return firstFrame->isQuantised();
+  }
+
+  const vector<float>& FrameAnimation::getVertexData(const int &frame) const {
+    if (frame != 0 && isQuantised()) {
+      throw Exception("The positions of the frames of a quantised animation are only stored in the compact format.");
+    }
+    return frame == 0 ? firstFrame->vertexData : vertexData[frame - 1];
+  }
+
+  const vector<float>& FrameAnimation::getNormalsData(const int &frame) const {
+    if (frame != 0 && isQuantised()) {
+      throw Exception("The normals of the frames of a quantised animation are only stored in the compact format.");
+    }
+    return frame == 0 ? firstFrame->normalsData : normalsData[frame - 1];
+  }
+
+  void FrameAnimation::getFrameData(const int &frame, vector<float> &vertexData,
+                                    vector<float> &normalsData) const {
+    if (frame == 0 || !isQuantised()) {
+      vertexData = getVertexData(frame);
+      normalsData = getNormalsData(frame);
+      return;
+    }
+
+    const vector<float> &compactVertexData = this->compactVertexData[frame - 1];
+    size_t numVertices = compactVertexData.size() / 3;
+    vertexData.resize(4 * numVertices);
+    for (size_t vertex = 0; vertex != numVertices; ++vertex) {
+      vertexData[4 * vertex] = compactVertexData[3 * vertex];
+      vertexData[4 * vertex + 1] = compactVertexData[3 * vertex + 1];
+      vertexData[4 * vertex + 2] = compactVertexData[3 * vertex + 2];
+      vertexData[4 * vertex + 3] = 1.0f;
+    }
+
+    const vector<unsigned int> &packedNormalsData = this->packedNormalsData[frame - 1];
+    normalsData.resize(3 * packedNormalsData.size());
+    for (size_t normal = 0; normal != packedNormalsData.size(); ++normal) {
+      unpackNormal(packedNormalsData[normal], normalsData[3 * normal], normalsData[3 * normal + 1],
+                   normalsData[3 * normal + 2]);
+    }
+  }
+
+  const vector<float>& FrameAnimation::getCompactVertexData(const int &frame) const {
+    return frame == 0 || compactVertexData.empty() ? firstFrame->compactVertexData :
+           compactVertexData[frame - 1];
+  }
+
+  const vector<unsigned int>& FrameAnimation::getPackedNormalsData(const int &frame) const {
+    return frame == 0 || packedNormalsData.empty() ? firstFrame->packedNormalsData :
+           packedNormalsData[frame - 1];
+  }
+
+  size_t FrameAnimation::getDataSize() const {
+    size_t size = (firstFrame->vertexData.size() + firstFrame->normalsData.size() +
+                   firstFrame->textureCoordsData.size() + firstFrame->compactVertexData.size()) * sizeof(float) +
+                  (firstFrame->indexData.size() + firstFrame->packedNormalsData.size()) * sizeof(unsigned int) +
+                  firstFrame->halfTextureCoordsData.size() * sizeof(unsigned short);
+
+    for (size_t frame = 0; frame != vertexData.size(); ++frame) {
+      size += (vertexData[frame].size() + normalsData[frame].size()) * sizeof(float);
+    }
+
+    for (size_t frame = 0; frame != compactVertexData.size(); ++frame) {
+      size += compactVertexData[frame].size() * sizeof(float) +
+              packedNormalsData[frame].size() * sizeof(unsigned int);
+    }
+
+    return size;
+  }
+
+}
@@ -0,0 +1,100 @@
+/*
+ *  Frustum.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "Frustum.hpp"
+#include <cmath>
+
+using namespace std;
+
+namespace small3d {
+
+  Frustum::Frustum() {
+    // Planes which every point is on the inner side of
+    for (int plane = 0; plane != 6; ++plane) {
+      planeX[plane] = 0.0f;
+      planeY[plane] = 0.0f;
+      planeZ[plane] = 0.0f;
+      planeD[plane] = 1.0f;
+    }
+  }
+
+  Frustum::Frustum(const glm::mat4 &viewProjectionMatrix) {
+    // Each plane is the fourth row of the matrix plus or minus one of the other rows
+    for (int plane = 0; plane != 6; ++plane) {
+      int row = plane / 2;
+      float sign = plane % 2 == 0 ? 1.0f : -1.0f;
+      float x = viewProjectionMatrix[0][3] + sign * viewProjectionMatrix[0][row];
+      float y = viewProjectionMatrix[1][3] + sign * viewProjectionMatrix[1][row];
+      float z = viewProjectionMatrix[2][3] + sign * viewProjectionMatrix[2][row];
+      float d = viewProjectionMatrix[3][3] + sign * viewProjectionMatrix[3][row];
+
+      // Normalised, so that distances from the planes can be compared to radii
+      float length = sqrt(x * x + y * y + z * z);
+      if (length > 0.0f) {
+        x /= length;
+        y /= length;
+        z /= length;
+        d /= length;
+      }
+
+      planeX[plane] = x;
+      planeY[plane] = y;
+      planeZ[plane] = z;
+      planeD[plane] = d;
+    }
+  }
+
+  bool Frustum::containsSphere(const glm::vec3 &centre, const float &radius) const {
+    for (int plane = 0; plane != 6; ++plane) {
+      if (centre.x * planeX[plane] + centre.y * planeY[plane] + centre.z * planeZ[plane] + planeD[plane] <
+          -radius) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool Frustum::containsBox(const glm::vec3 &centre, const glm::vec3 &halfExtents) const {
+    for (int plane = 0; plane != 6; ++plane) {
+      // The distance of the box's corner furthest along the plane's normal
+      float distance = centre.x * planeX[plane] + centre.y * planeY[plane] + centre.z * planeZ[plane] +
+                       planeD[plane];
+      float reach = halfExtents.x * fabs(planeX[plane]) + halfExtents.y * fabs(planeY[plane]) +
+                    halfExtents.z * fabs(planeZ[plane]);
+      if (distance < -reach) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t Frustum::cullSpheres(const float *centreX, const float *centreY, const float *centreZ, const float *radii,
+                              const size_t &numSpheres, unsigned char *visible) const {
+    for (size_t sphere = 0; sphere != numSpheres; ++sphere) {
+      visible[sphere] = 1;
+    }
+
+    for (int plane = 0; plane != 6; ++plane) {
+      float x = planeX[plane];
+      float y = planeY[plane];
+      float z = planeZ[plane];
+      float d = planeD[plane];
+      for (size_t sphere = 0; sphere != numSpheres; ++sphere) {
+        visible[sphere] &= static_cast<unsigned char>(
+            centreX[sphere] * x + centreY[sphere] * y + centreZ[sphere] * z + d >= -radii[sphere]);
+      }
+    }
+
+    size_t numVisible = 0;
+    for (size_t sphere = 0; sphere != numSpheres; ++sphere) {
+      numVisible += visible[sphere];
+    }
+    return numVisible;
+  }
+
+}
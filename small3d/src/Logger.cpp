@@ -13,6 +13,13 @@
 
 using namespace std;
 
+namespace small3d {
+
+  // Models can be loaded (and log) on several threads at once. Defined before the
+  // logger, so that it is still there when the logger is destroyed at exit.
+  static mutex initMutex;
+}
+
 shared_ptr<small3d::Logger> logger;
 
 namespace small3d {
@@ -28,7 +35,10 @@ namespace small3d {
   }
 
   void Logger::append(const LogLevel level, const string &message) {
-    if (!logger) return;
+    // Objects can be loaded on background threads, so messages may be
+    // appended from more than one thread at a time.
+    lock_guard<mutex> lock(appendMutex);
+
     ostringstream dateTimeOstringstream;
 
     time_t now;
@@ -41,16 +51,20 @@ namespace small3d {
     t = new tm();
     localtime_s(t, &now);
 
-#else
+#elif defined(_WIN32)
     t = localtime(&now);
+#else
+    // The logger being replaced can still be appending, at the same time as the new
+    // one, so the buffer localtime shares between them cannot be used
+    tm localTime;
+    t = localtime_r(&now, &localTime);
 #endif
     char buf[20];
 
     strftime(buf, 20,"%Y-%m-%d %H:%M:%S", t);
 
-    // localtime (used on Linux) does not allocate memory, but
-    // returns a pointer to a pre-existing location. Hence,
-    // we should not delete it.
+    // localtime and localtime_r (used elsewhere) do not allocate memory, but
+    // return a pointer to a pre-existing location. Hence, we should not delete it.
 #if defined(_WIN32) && !defined(__MINGW32__)
     delete t;
 #endif
@@ -77,14 +91,26 @@ namespace small3d {
   }
 
   void initLogger() {
+    lock_guard<mutex> lock(initMutex);
     if (!logger) logger = shared_ptr<Logger>(new Logger(cout));
   }
 
   void initLogger(ostream &stream) {
+    lock_guard<mutex> lock(initMutex);
     if (!logger) logger = shared_ptr<Logger>(new Logger(stream));
   }
 
   void deleteLogger() {
+    lock_guard<mutex> lock(initMutex);
     logger = NULL;
   }
+
+  void logMessage(const LogLevel level, const string &message) {
+    shared_ptr<Logger> currentLogger;
+    {
+      lock_guard<mutex> lock(initMutex);
+      currentLogger = logger;
+    }
+    if (currentLogger) currentLogger->append(level, message);
+  }
 }
@@ -0,0 +1,127 @@
+/*
+ *  MappedFile.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "MappedFile.hpp"
+#include "Exception.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace small3d {
+
+#ifdef _WIN32
+
+  MappedFile::MappedFile(const string &fileLocation) {
+    data = NULL;
+    size = 0;
+    mappingHandle = NULL;
+
+    fileHandle = CreateFileA(fileLocation.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+      throw Exception("Could not open file " + fileLocation);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+      CloseHandle(fileHandle);
+      throw Exception("Could not determine the size of file " + fileLocation);
+    }
+
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    // Empty files cannot be mapped
+    if (size > 0) {
+      mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mappingHandle == NULL) {
+        CloseHandle(fileHandle);
+        throw Exception("Could not map file " + fileLocation);
+      }
+
+      data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+      if (data == NULL) {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        throw Exception("Could not map file " + fileLocation);
+      }
+    }
+  }
+
+  MappedFile::~MappedFile() {
+    if (data != NULL) {
+      UnmapViewOfFile(data);
+    }
+    if (mappingHandle != NULL) {
+      CloseHandle(mappingHandle);
+    }
+    CloseHandle(fileHandle);
+  }
+
+#else
+
+  MappedFile::MappedFile(const string &fileLocation) {
+    data = NULL;
+    size = 0;
+
+    int fd = open(fileLocation.c_str(), O_RDONLY);
+
+    if (fd == -1) {
+      throw Exception("Could not open file " + fileLocation);
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1) {
+      close(fd);
+      throw Exception("Could not determine the size of file " + fileLocation);
+    }
+
+    size = static_cast<size_t>(fileStat.st_size);
+
+    // Empty files cannot be mapped
+    if (size > 0) {
+      void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+        close(fd);
+        throw Exception("Could not map file " + fileLocation);
+      }
+      // The whole file is read once, from start to end
+      madvise(mapping, size, MADV_SEQUENTIAL);
+      data = static_cast<const char*>(mapping);
+    }
+
+    // The mapping remains valid after the descriptor has been closed
+    close(fd);
+  }
+
+  MappedFile::~MappedFile() {
+    if (data != NULL) {
+      munmap(const_cast<char*>(data), size);
+    }
+  }
+
+#endif
+
+  const char* MappedFile::getData() const {
+    return data;
+  }
+
+  size_t MappedFile::getSize() const {
+    return size;
+  }
+
+}
@@ -38,4 +38,9 @@ namespace small3d {
 		       );
   }
 
+  glm::mat4x4 rotate(const glm::vec3 &rotation)
+  {
+    return rotateY(rotation.y) * rotateX(rotation.x) * rotateZ(rotation.z);
+  }
+
 }
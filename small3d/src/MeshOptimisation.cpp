@@ -0,0 +1,301 @@
+/*
+ *  MeshOptimisation.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "MeshOptimisation.hpp"
+#include "Exception.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace small3d {
+
+  // Parameters of the vertex cache optimisation, as proposed by Tom Forsyth
+  static const int optimisationCacheSize = 32;
+  static const float cacheDecayPower = 1.5f;
+  static const float lastTriangleScore = 0.75f;
+  static const float valenceBoostScale = 2.0f;
+  static const float valenceBoostPower = 0.5f;
+
+  // The score of a vertex, given its position in the simulated cache (-1 if it is not
+  // in the cache) and the number of triangles that still need to use it
+  static float vertexScore(const int &cachePosition, const int &remainingTriangles) {
+    if (remainingTriangles == 0) {
+      // No triangle needs this vertex any more
+      return -1.0f;
+    }
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0) {
+      if (cachePosition < 3) {
+        // The vertex was used by the last triangle. A fixed score is given to all three
+        // vertices, so as not to favour one of them (and the triangles using it).
+        score = lastTriangleScore;
+      }
+      else {
+        float scaler = 1.0f / (optimisationCacheSize - 3);
+        score = pow(1.0f - (cachePosition - 3) * scaler, cacheDecayPower);
+      }
+    }
+
+    // Boost vertices with few remaining triangles, so that they are finished off quickly
+    score += valenceBoostScale * pow(static_cast<float>(remainingTriangles), -valenceBoostPower);
+
+    return score;
+  }
+
+  float calculateACMR(const Model &model, const int &cacheSize) {
+    size_t numIndexes = model.getNumIndexes();
+
+    if (numIndexes < 3) return 0.0f;
+
+    // FIFO cache: a vertex is in the cache if it was added within the last cacheSize misses
+    vector<long> timeAdded(model.vertexData.size() / 4, -1);
+    long misses = 0;
+
+    for (size_t idx = 0; idx != numIndexes; ++idx) {
+      unsigned int vertex = model.indexData[idx];
+      if (vertex >= timeAdded.size()) {
+        throw Exception("Vertex index out of range while calculating ACMR.");
+      }
+      if (timeAdded[vertex] == -1 || misses - timeAdded[vertex] >= cacheSize) {
+        timeAdded[vertex] = misses;
+        ++misses;
+      }
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(numIndexes / 3);
+  }
+
+  void optimiseVertexCache(vector<unsigned int> &triangles, const size_t &vertexCount) {
+    int numVertices = static_cast<int>(vertexCount);
+    int numTriangles = static_cast<int>(triangles.size() / 3);
+
+    if (numTriangles == 0) return;
+
+    const vector<unsigned int> &indexData = triangles;
+
+    // The triangles using each vertex, all in one array, starting at triangleOffsets[vertex]
+    vector<int> remainingTriangles(static_cast<size_t>(numVertices), 0);
+
+    for (int idx = 0; idx != 3 * numTriangles; ++idx) {
+      if (indexData[idx] >= static_cast<unsigned int>(numVertices)) {
+        throw Exception("Vertex index out of range while optimising vertex cache.");
+      }
+      ++remainingTriangles[indexData[idx]];
+    }
+
+    vector<int> triangleOffsets(static_cast<size_t>(numVertices) + 1, 0);
+    for (int vertex = 0; vertex != numVertices; ++vertex) {
+      triangleOffsets[vertex + 1] = triangleOffsets[vertex] + remainingTriangles[vertex];
+    }
+
+    vector<int> vertexTriangles(static_cast<size_t>(3 * numTriangles));
+    vector<int> filled(static_cast<size_t>(numVertices), 0);
+    for (int triangle = 0; triangle != numTriangles; ++triangle) {
+      for (int corner = 0; corner != 3; ++corner) {
+        unsigned int vertex = indexData[3 * triangle + corner];
+        vertexTriangles[triangleOffsets[vertex] + filled[vertex]] = triangle;
+        ++filled[vertex];
+      }
+    }
+
+    vector<int> cachePositions(static_cast<size_t>(numVertices), -1);
+    vector<float> vertexScores(static_cast<size_t>(numVertices));
+    for (int vertex = 0; vertex != numVertices; ++vertex) {
+      vertexScores[vertex] = vertexScore(-1, remainingTriangles[vertex]);
+    }
+
+    vector<float> triangleScores(static_cast<size_t>(numTriangles));
+    vector<bool> triangleAdded(static_cast<size_t>(numTriangles), false);
+
+    int bestTriangle = 0;
+    float bestScore = -1.0f;
+
+    for (int triangle = 0; triangle != numTriangles; ++triangle) {
+      triangleScores[triangle] = vertexScores[indexData[3 * triangle]] +
+                                 vertexScores[indexData[3 * triangle + 1]] +
+                                 vertexScores[indexData[3 * triangle + 2]];
+      if (triangleScores[triangle] > bestScore) {
+        bestScore = triangleScores[triangle];
+        bestTriangle = triangle;
+      }
+    }
+
+    vector<unsigned int> optimisedIndexData;
+    optimisedIndexData.reserve(indexData.size());
+
+    vector<int> cache;
+    cache.reserve(optimisationCacheSize + 3);
+    vector<int> newCache;
+    newCache.reserve(optimisationCacheSize + 3);
+
+    // Position from which to look for a triangle that has not been added yet,
+    // when none of the triangles using the vertices in the cache is left
+    int nextUnaddedTriangle = 0;
+
+    for (int output = 0; output != numTriangles; ++output) {
+
+      if (bestTriangle == -1) {
+        while (triangleAdded[nextUnaddedTriangle]) {
+          ++nextUnaddedTriangle;
+        }
+        bestTriangle = nextUnaddedTriangle;
+      }
+
+      triangleAdded[bestTriangle] = true;
+
+      const unsigned int* triangleVertices = &indexData[3 * bestTriangle];
+      optimisedIndexData.insert(optimisedIndexData.end(), triangleVertices, triangleVertices + 3);
+
+      // The triangle's vertices go to the front of the cache, followed by the
+      // rest of the vertices that were already there, in the same order
+      newCache.clear();
+
+      for (int corner = 0; corner != 3; ++corner) {
+        int vertex = static_cast<int>(triangleVertices[corner]);
+
+        // Remove the triangle from the ones still using the vertex
+        int* triangles = &vertexTriangles[triangleOffsets[vertex]];
+        int numRemaining = remainingTriangles[vertex];
+        for (int idx = 0; idx != numRemaining; ++idx) {
+          if (triangles[idx] == bestTriangle) {
+            triangles[idx] = triangles[numRemaining - 1];
+            break;
+          }
+        }
+        --remainingTriangles[vertex];
+
+        newCache.push_back(vertex);
+      }
+
+      for (vector<int>::iterator vertex = cache.begin(); vertex != cache.end(); ++vertex) {
+        if (*vertex != newCache[0] && *vertex != newCache[1] && *vertex != newCache[2]) {
+          newCache.push_back(*vertex);
+        }
+      }
+
+      cache.swap(newCache);
+
+      // Update the scores of the vertices in the cache and of the ones that have
+      // just dropped out of it, as well as those of their triangles
+      bestTriangle = -1;
+      bestScore = -1.0f;
+
+      for (int position = 0; position != static_cast<int>(cache.size()); ++position) {
+        int vertex = cache[position];
+        cachePositions[vertex] = position < optimisationCacheSize ? position : -1;
+        vertexScores[vertex] = vertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+      }
+
+      for (int position = 0; position != static_cast<int>(cache.size()); ++position) {
+        int vertex = cache[position];
+        const int* triangles = &vertexTriangles[triangleOffsets[vertex]];
+        for (int idx = 0; idx != remainingTriangles[vertex]; ++idx) {
+          int triangle = triangles[idx];
+          triangleScores[triangle] = vertexScores[indexData[3 * triangle]] +
+                                     vertexScores[indexData[3 * triangle + 1]] +
+                                     vertexScores[indexData[3 * triangle + 2]];
+          if (triangleScores[triangle] > bestScore) {
+            bestScore = triangleScores[triangle];
+            bestTriangle = triangle;
+          }
+        }
+      }
+
+      if (cache.size() > static_cast<size_t>(optimisationCacheSize)) {
+        cache.resize(optimisationCacheSize);
+      }
+    }
+
+    triangles.swap(optimisedIndexData);
+  }
+
+  void optimiseVertexCache(Model &model) {
+    size_t numVertices = model.vertexData.size() / 4;
+
+    optimiseVertexCache(model.indexData, numVertices);
+
+    for (size_t level = 0; level != model.lodIndexData.size(); ++level) {
+      optimiseVertexCache(model.lodIndexData[level], numVertices);
+    }
+  }
+
+  void optimiseVertexFetch(Model &model, vector<unsigned int> *vertexRemap) {
+    size_t numVertices = model.vertexData.size() / 4;
+    bool hasNormals = model.normalsData.size() == 3 * numVertices;
+    bool hasTextureCoords = model.textureCoordsData.size() == 2 * numVertices;
+
+    const unsigned int unassigned = static_cast<unsigned int>(-1);
+    vector<unsigned int> newIndexes(numVertices, unassigned);
+    unsigned int nextIndex = 0;
+
+    vector<float> vertexData(model.vertexData.size());
+    vector<float> normalsData(hasNormals ? model.normalsData.size() : 0);
+    vector<float> textureCoordsData(hasTextureCoords ? model.textureCoordsData.size() : 0);
+
+    for (vector<unsigned int>::iterator index = model.indexData.begin(); index != model.indexData.end(); ++index) {
+      if (*index >= numVertices) {
+        throw Exception("Vertex index out of range while optimising vertex fetch.");
+      }
+
+      if (newIndexes[*index] == unassigned) {
+        newIndexes[*index] = nextIndex;
+        for (int component = 0; component != 4; ++component) {
+          vertexData[4 * nextIndex + component] = model.vertexData[4 * *index + component];
+        }
+        if (hasNormals) {
+          for (int component = 0; component != 3; ++component) {
+            normalsData[3 * nextIndex + component] = model.normalsData[3 * *index + component];
+          }
+        }
+        if (hasTextureCoords) {
+          for (int component = 0; component != 2; ++component) {
+            textureCoordsData[2 * nextIndex + component] = model.textureCoordsData[2 * *index + component];
+          }
+        }
+        ++nextIndex;
+      }
+
+      *index = newIndexes[*index];
+    }
+
+    // The lower levels of detail only use vertices of the model itself
+    for (size_t level = 0; level != model.lodIndexData.size(); ++level) {
+      for (vector<unsigned int>::iterator index = model.lodIndexData[level].begin();
+           index != model.lodIndexData[level].end(); ++index) {
+        if (*index >= numVertices || newIndexes[*index] == unassigned) {
+          throw Exception("Level of detail vertex not used by the model while optimising vertex fetch.");
+        }
+        *index = newIndexes[*index];
+      }
+    }
+
+    // Vertices not used by any triangle are dropped
+    vertexData.resize(4 * nextIndex);
+    model.vertexData.swap(vertexData);
+    model.vertexDataSize = static_cast<int>(model.vertexData.size() * sizeof(float));
+
+    if (hasNormals) {
+      normalsData.resize(3 * nextIndex);
+      model.normalsData.swap(normalsData);
+      model.normalsDataSize = static_cast<int>(model.normalsData.size() * sizeof(float));
+    }
+
+    if (hasTextureCoords) {
+      textureCoordsData.resize(2 * nextIndex);
+      model.textureCoordsData.swap(textureCoordsData);
+      model.textureCoordsDataSize = static_cast<int>(model.textureCoordsData.size() * sizeof(float));
+    }
+
+    if (vertexRemap != NULL) {
+      vertexRemap->swap(newIndexes);
+    }
+  }
+}
@@ -0,0 +1,381 @@
+/*
+ *  MeshSimplification.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "MeshSimplification.hpp"
+#include "MeshOptimisation.hpp"
+#include "Exception.hpp"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+namespace small3d {
+
+  // How much more the open borders of a mesh are preserved than its surface
+  static const double borderWeight = 10.0;
+
+  // A level of detail which does not remove more than this proportion of the triangles of
+  // the previous one is not worth keeping, and the model cannot be simplified much further
+  static const float minLevelReduction = 0.9f;
+
+  // How each vertex can be moved by an edge collapse
+  enum VertexKind {
+    // Anywhere on the surface
+    manifoldVertex,
+    // Only along the open border of the mesh
+    borderVertex,
+    // Not at all (the vertex is on a seam or where the mesh is not a manifold)
+    lockedVertex
+  };
+
+  // The sum of the squared distances of a point from a set of planes, as the coefficients of
+  // a symmetric 4x4 matrix: the 3x3 part (a), the rest of the fourth column (b) and its corner (c)
+  struct Quadric {
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+  };
+
+  static void addPlane(Quadric &quadric, const double* normal, const double &distance, const double &weight) {
+    quadric.a00 += weight * normal[0] * normal[0];
+    quadric.a01 += weight * normal[0] * normal[1];
+    quadric.a02 += weight * normal[0] * normal[2];
+    quadric.a11 += weight * normal[1] * normal[1];
+    quadric.a12 += weight * normal[1] * normal[2];
+    quadric.a22 += weight * normal[2] * normal[2];
+    quadric.b0 += weight * normal[0] * distance;
+    quadric.b1 += weight * normal[1] * distance;
+    quadric.b2 += weight * normal[2] * distance;
+    quadric.c += weight * distance * distance;
+  }
+
+  static void addQuadric(Quadric &quadric, const Quadric &other) {
+    quadric.a00 += other.a00;
+    quadric.a01 += other.a01;
+    quadric.a02 += other.a02;
+    quadric.a11 += other.a11;
+    quadric.a12 += other.a12;
+    quadric.a22 += other.a22;
+    quadric.b0 += other.b0;
+    quadric.b1 += other.b1;
+    quadric.b2 += other.b2;
+    quadric.c += other.c;
+  }
+
+  // The error of moving the vertices of two quadrics to a point
+  static double collapseError(const Quadric &first, const Quadric &second, const float* point) {
+    Quadric quadric = first;
+    addQuadric(quadric, second);
+
+    double x = point[0], y = point[1], z = point[2];
+
+    double error = quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z +
+                   2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z) +
+                   2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) + quadric.c;
+
+    // Rounding can make it slightly negative
+    return fabs(error);
+  }
+
+  // The (not normalised) normal of a triangle, whose length is twice its area
+  static void triangleNormal(const float* p0, const float* p1, const float* p2, double* normal) {
+    double edge1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double edge2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+    normal[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+    normal[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+  }
+
+  static uint64_t edgeKey(const unsigned int &from, const unsigned int &to) {
+    return (static_cast<uint64_t>(from) << 32) | to;
+  }
+
+  // A vertex that can be moved onto one of its neighbours
+  struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double error;
+
+    bool operator<(const Collapse &other) const {
+      if (error != other.error) return error < other.error;
+      if (from != other.from) return from < other.from;
+      return to < other.to;
+    }
+  };
+
+  vector<unsigned int> simplifyMesh(const Model &model, const vector<unsigned int> &triangles,
+                                    const size_t &targetNumIndexes) {
+    size_t numVertices = model.vertexData.size() / 4;
+    const float* positions = model.vertexData.data();
+
+    vector<bool> used(numVertices, false);
+    for (vector<unsigned int>::const_iterator index = triangles.begin(); index != triangles.end(); ++index) {
+      if (*index >= numVertices) {
+        throw Exception("Vertex index out of range while simplifying mesh.");
+      }
+      used[*index] = true;
+    }
+
+    // The first of the (used) vertices with each position stands for all of them, since
+    // the mesh is simplified based on the positions of the vertices only
+    vector<unsigned int> sortedVertices;
+    sortedVertices.reserve(numVertices);
+    for (unsigned int vertex = 0; vertex != numVertices; ++vertex) {
+      if (used[vertex]) sortedVertices.push_back(vertex);
+    }
+
+    sort(sortedVertices.begin(), sortedVertices.end(), [&](const unsigned int &first, const unsigned int &second) {
+      const float* p0 = &positions[4 * first];
+      const float* p1 = &positions[4 * second];
+      if (p0[0] != p1[0]) return p0[0] < p1[0];
+      if (p0[1] != p1[1]) return p0[1] < p1[1];
+      if (p0[2] != p1[2]) return p0[2] < p1[2];
+      return first < second;
+    });
+
+    vector<unsigned int> positionVertex(numVertices);
+    vector<int> numWedges(numVertices, 0);
+
+    for (size_t idx = 0; idx != sortedVertices.size(); ++idx) {
+      unsigned int vertex = sortedVertices[idx];
+      if (idx > 0) {
+        unsigned int previous = sortedVertices[idx - 1];
+        const float* p0 = &positions[4 * previous];
+        const float* p1 = &positions[4 * vertex];
+        positionVertex[vertex] = p0[0] == p1[0] && p0[1] == p1[1] && p0[2] == p1[2] ?
+                                 positionVertex[previous] : vertex;
+      }
+      else {
+        positionVertex[vertex] = vertex;
+      }
+      ++numWedges[positionVertex[vertex]];
+    }
+
+    // Find the open borders (edges used by a single triangle) and the edges used by more
+    // than two triangles, in which case the mesh is not a manifold there
+    unordered_map<uint64_t, int> edgeCounts;
+    edgeCounts.reserve(triangles.size());
+
+    for (size_t corner = 0; corner != triangles.size(); ++corner) {
+      size_t nextCorner = corner % 3 == 2 ? corner - 2 : corner + 1;
+      ++edgeCounts[edgeKey(positionVertex[triangles[corner]], positionVertex[triangles[nextCorner]])];
+    }
+
+    vector<unsigned char> kinds(numVertices, manifoldVertex);
+
+    for (unsigned int vertex = 0; vertex != numVertices; ++vertex) {
+      if (numWedges[vertex] > 1) kinds[vertex] = lockedVertex;
+    }
+
+    for (size_t corner = 0; corner != triangles.size(); ++corner) {
+      size_t nextCorner = corner % 3 == 2 ? corner - 2 : corner + 1;
+      unsigned int from = positionVertex[triangles[corner]], to = positionVertex[triangles[nextCorner]];
+
+      int count = edgeCounts[edgeKey(from, to)];
+      unordered_map<uint64_t, int>::const_iterator reverse = edgeCounts.find(edgeKey(to, from));
+
+      if (count > 1 || (reverse != edgeCounts.end() && reverse->second > 1)) {
+        kinds[from] = lockedVertex;
+        kinds[to] = lockedVertex;
+      }
+      else if (reverse == edgeCounts.end()) {
+        if (kinds[from] == manifoldVertex) kinds[from] = borderVertex;
+        if (kinds[to] == manifoldVertex) kinds[to] = borderVertex;
+      }
+    }
+
+    vector<Quadric> quadrics(numVertices);
+
+    for (size_t triangle = 0; triangle != triangles.size() / 3; ++triangle) {
+      unsigned int corners[3];
+      for (int corner = 0; corner != 3; ++corner) {
+        corners[corner] = positionVertex[triangles[3 * triangle + corner]];
+      }
+
+      double normal[3];
+      triangleNormal(&positions[4 * corners[0]], &positions[4 * corners[1]], &positions[4 * corners[2]], normal);
+      double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+      if (length == 0.0) continue;
+      for (int component = 0; component != 3; ++component) normal[component] /= length;
+
+      // The plane of the triangle, weighted by its area
+      const float* p0 = &positions[4 * corners[0]];
+      double distance = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+      for (int corner = 0; corner != 3; ++corner) {
+        addPlane(quadrics[corners[corner]], normal, distance, length / 2.0);
+      }
+
+      // The plane through each border edge, perpendicular to the triangle, keeps the
+      // border vertices from moving away from the border
+      for (int corner = 0; corner != 3; ++corner) {
+        unsigned int from = corners[corner], to = corners[(corner + 1) % 3];
+        if (edgeCounts.find(edgeKey(to, from)) != edgeCounts.end()) continue;
+
+        const float* edgeStart = &positions[4 * from];
+        const float* edgeEnd = &positions[4 * to];
+        double edge[3] = {edgeEnd[0] - edgeStart[0], edgeEnd[1] - edgeStart[1], edgeEnd[2] - edgeStart[2]};
+        double edgeLength = sqrt(edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+        if (edgeLength == 0.0) continue;
+
+        double borderNormal[3] = {edge[1] * normal[2] - edge[2] * normal[1],
+                                  edge[2] * normal[0] - edge[0] * normal[2],
+                                  edge[0] * normal[1] - edge[1] * normal[0]};
+        for (int component = 0; component != 3; ++component) borderNormal[component] /= edgeLength;
+        double borderDistance = -(borderNormal[0] * edgeStart[0] + borderNormal[1] * edgeStart[1] +
+                                  borderNormal[2] * edgeStart[2]);
+        addPlane(quadrics[from], borderNormal, borderDistance, edgeLength * edgeLength * borderWeight);
+        addPlane(quadrics[to], borderNormal, borderDistance, edgeLength * edgeLength * borderWeight);
+      }
+    }
+
+    vector<unsigned int> indexData(triangles);
+
+    // Each pass collapses as many edges as it can, as long as the collapses do not affect
+    // each other, in order of increasing error, and then removes the degenerate triangles
+    while (indexData.size() > targetNumIndexes) {
+      size_t numTriangles = indexData.size() / 3;
+
+      // The triangles around each position, all in one array
+      vector<unsigned int> triangleOffsets(numVertices + 1, 0);
+      for (size_t corner = 0; corner != indexData.size(); ++corner) {
+        ++triangleOffsets[positionVertex[indexData[corner]] + 1];
+      }
+      for (size_t vertex = 0; vertex != numVertices; ++vertex) {
+        triangleOffsets[vertex + 1] += triangleOffsets[vertex];
+      }
+      vector<unsigned int> vertexTriangles(indexData.size());
+      vector<unsigned int> filled(triangleOffsets.begin(), triangleOffsets.end() - 1);
+      for (size_t corner = 0; corner != indexData.size(); ++corner) {
+        vertexTriangles[filled[positionVertex[indexData[corner]]]++] = static_cast<unsigned int>(corner / 3);
+      }
+
+      edgeCounts.clear();
+      for (size_t corner = 0; corner != indexData.size(); ++corner) {
+        size_t nextCorner = corner % 3 == 2 ? corner - 2 : corner + 1;
+        ++edgeCounts[edgeKey(positionVertex[indexData[corner]], positionVertex[indexData[nextCorner]])];
+      }
+
+      vector<Collapse> collapses;
+      collapses.reserve(indexData.size());
+
+      for (size_t corner = 0; corner != indexData.size(); ++corner) {
+        size_t nextCorner = corner % 3 == 2 ? corner - 2 : corner + 1;
+        unsigned int ends[2] = {indexData[corner], indexData[nextCorner]};
+        bool openEdge = edgeCounts.find(edgeKey(positionVertex[ends[1]], positionVertex[ends[0]])) ==
+                        edgeCounts.end();
+
+        for (int direction = 0; direction != 2; ++direction) {
+          Collapse collapse;
+          collapse.from = ends[direction];
+          collapse.to = ends[1 - direction];
+
+          unsigned int from = positionVertex[collapse.from], to = positionVertex[collapse.to];
+          if (from == to) continue;
+
+          // Border vertices can only be moved along the border
+          if (kinds[from] == manifoldVertex || (kinds[from] == borderVertex && openEdge)) {
+            collapse.error = collapseError(quadrics[from], quadrics[to], &positions[4 * collapse.to]);
+            collapses.push_back(collapse);
+          }
+        }
+      }
+
+      sort(collapses.begin(), collapses.end());
+
+      vector<unsigned int> remap(numVertices);
+      for (unsigned int vertex = 0; vertex != numVertices; ++vertex) remap[vertex] = vertex;
+
+      // Positions whose surroundings have already changed in this pass
+      vector<bool> changed(numVertices, false);
+
+      size_t trianglesToRemove = max(static_cast<size_t>(1), (indexData.size() - targetNumIndexes) / 3);
+      size_t trianglesRemoved = 0;
+
+      for (vector<Collapse>::iterator collapse = collapses.begin(); collapse != collapses.end() &&
+                                                                    trianglesRemoved < trianglesToRemove; ++collapse) {
+        unsigned int from = positionVertex[collapse->from], to = positionVertex[collapse->to];
+        if (changed[from] || changed[to]) continue;
+
+        // Check that none of the triangles that remain would be flipped
+        bool flips = false;
+        for (unsigned int idx = triangleOffsets[from]; idx != triangleOffsets[from + 1] && !flips; ++idx) {
+          const unsigned int* triangle = &indexData[3 * vertexTriangles[idx]];
+          const float* corners[3];
+          bool collapsed = false;
+          for (int corner = 0; corner != 3; ++corner) {
+            corners[corner] = &positions[4 * triangle[corner]];
+            if (positionVertex[triangle[corner]] == to) collapsed = true;
+          }
+          if (collapsed) continue;
+
+          double normal[3], movedNormal[3];
+          triangleNormal(corners[0], corners[1], corners[2], normal);
+          for (int corner = 0; corner != 3; ++corner) {
+            if (positionVertex[triangle[corner]] == from) corners[corner] = &positions[4 * collapse->to];
+          }
+          triangleNormal(corners[0], corners[1], corners[2], movedNormal);
+          flips = normal[0] * movedNormal[0] + normal[1] * movedNormal[1] + normal[2] * movedNormal[2] <= 0.0;
+        }
+        if (flips) continue;
+
+        // The vertex being moved is the only one with its position, since it is not locked
+        remap[collapse->from] = collapse->to;
+        addQuadric(quadrics[to], quadrics[from]);
+
+        for (unsigned int idx = triangleOffsets[from]; idx != triangleOffsets[from + 1]; ++idx) {
+          const unsigned int* triangle = &indexData[3 * vertexTriangles[idx]];
+          for (int corner = 0; corner != 3; ++corner) {
+            changed[positionVertex[triangle[corner]]] = true;
+          }
+        }
+
+        trianglesRemoved += kinds[from] == borderVertex ? 1 : 2;
+      }
+
+      if (trianglesRemoved == 0) break;
+
+      size_t numIndexes = 0;
+      for (size_t triangle = 0; triangle != numTriangles; ++triangle) {
+        unsigned int v0 = remap[indexData[3 * triangle]];
+        unsigned int v1 = remap[indexData[3 * triangle + 1]];
+        unsigned int v2 = remap[indexData[3 * triangle + 2]];
+        if (positionVertex[v0] != positionVertex[v1] && positionVertex[v1] != positionVertex[v2] &&
+            positionVertex[v2] != positionVertex[v0]) {
+          indexData[numIndexes++] = v0;
+          indexData[numIndexes++] = v1;
+          indexData[numIndexes++] = v2;
+        }
+      }
+      indexData.resize(numIndexes);
+    }
+
+    return indexData;
+  }
+
+  void generateLevelsOfDetail(Model &model, const int &numLevels, const float &reduction) {
+    vector<vector<unsigned int> >().swap(model.lodIndexData);
+
+    size_t numVertices = model.vertexData.size() / 4;
+
+    for (int level = 1; level < numLevels; ++level) {
+      const vector<unsigned int> &previousLevel = level == 1 ? model.indexData : model.lodIndexData.back();
+
+      size_t targetNumIndexes = 3 * static_cast<size_t>(previousLevel.size() / 3 * reduction);
+      vector<unsigned int> simplified = simplifyMesh(model, previousLevel, targetNumIndexes);
+
+      if (simplified.empty() || simplified.size() > previousLevel.size() * minLevelReduction) break;
+
+      optimiseVertexCache(simplified, numVertices);
+      model.lodIndexData.push_back(vector<unsigned int>());
+      model.lodIndexData.back().swap(simplified);
+    }
+  }
+}
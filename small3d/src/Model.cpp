@@ -7,6 +7,8 @@
  */
 
 #include "Model.hpp"
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 
@@ -21,10 +23,86 @@ namespace small3d {
     normalsDataSize = 0;
     textureCoordsData.clear();
     textureCoordsDataSize = 0;
+    compactVertexData.clear();
+    packedNormalsData.clear();
+    halfTextureCoordsData.clear();
+    lodIndexData.clear();
+    boundingBoxMin = glm::vec3(0.0f);
+    boundingBoxMax = glm::vec3(0.0f);
+    boundingSphereCentre = glm::vec3(0.0f);
+    boundingSphereRadius = -1.0f;
   }
 
   Model::~Model(void) {
 
   }
 
+  size_t Model::getNumIndexes(const size_t &level) const {
+    return getIndexData(level).size();
+  }
+
+  const vector<unsigned int>& Model::getIndexData(const size_t &level) const {
+    return level > 0 ? lodIndexData[level - 1] : indexData;
+  }
+
+  size_t Model::getNumLevelsOfDetail() const {
+    return 1 + lodIndexData.size();
+  }
+
+  bool Model::isQuantised() const {
+    return !vertexData.empty() &&
+           compactVertexData.size() / 3 == vertexData.size() / 4 &&
+           packedNormalsData.size() == normalsData.size() / 3 &&
+           halfTextureCoordsData.size() == textureCoordsData.size();
+  }
+
+  void Model::calculateBoundingVolumes(const vector<const vector<float>*> &otherFrames) {
+    vector<const vector<float>*> frames(1, &vertexData);
+    frames.insert(frames.end(), otherFrames.begin(), otherFrames.end());
+
+    bool empty = true;
+    for (size_t frame = 0; frame != frames.size(); ++frame) {
+      const vector<float> &frameVertexData = *frames[frame];
+      // 4 components per vertex
+      for (size_t vertex = 0; 4 * vertex < frameVertexData.size(); ++vertex) {
+        glm::vec3 position(frameVertexData[4 * vertex], frameVertexData[4 * vertex + 1],
+                           frameVertexData[4 * vertex + 2]);
+        if (empty) {
+          boundingBoxMin = position;
+          boundingBoxMax = position;
+          empty = false;
+        }
+        else {
+          boundingBoxMin = glm::vec3(min(boundingBoxMin.x, position.x), min(boundingBoxMin.y, position.y),
+                                     min(boundingBoxMin.z, position.z));
+          boundingBoxMax = glm::vec3(max(boundingBoxMax.x, position.x), max(boundingBoxMax.y, position.y),
+                                     max(boundingBoxMax.z, position.z));
+        }
+      }
+    }
+
+    if (empty) {
+      boundingBoxMin = glm::vec3(0.0f);
+      boundingBoxMax = glm::vec3(0.0f);
+      boundingSphereCentre = glm::vec3(0.0f);
+      boundingSphereRadius = 0.0f;
+      return;
+    }
+
+    // The sphere around the centre of the box that contains every vertex, which is
+    // tighter than the one around the box itself
+    boundingSphereCentre = (boundingBoxMin + boundingBoxMax) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (size_t frame = 0; frame != frames.size(); ++frame) {
+      const vector<float> &frameVertexData = *frames[frame];
+      for (size_t vertex = 0; 4 * vertex < frameVertexData.size(); ++vertex) {
+        float x = frameVertexData[4 * vertex] - boundingSphereCentre.x;
+        float y = frameVertexData[4 * vertex + 1] - boundingSphereCentre.y;
+        float z = frameVertexData[4 * vertex + 2] - boundingSphereCentre.z;
+        radiusSquared = max(radiusSquared, x * x + y * y + z * z);
+      }
+    }
+    boundingSphereRadius = sqrt(radiusSquared);
+  }
+
 }
@@ -0,0 +1,204 @@
+/*
+ *  ModelCache.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "ModelCache.hpp"
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include "WavefrontLoader.hpp"
+#include <SDL.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <climits>
+#endif
+
+using namespace std;
+
+namespace small3d {
+
+  ModelCache::ModelCache() {
+    hits = 0;
+    misses = 0;
+    numLoads = 0;
+    levelsOfDetail = 1;
+  }
+
+  ModelCache::~ModelCache() {
+
+  }
+
+  string ModelCache::getCanonicalPath(const string &fileLocation) {
+    string filePath = SDL_GetBasePath() + fileLocation;
+
+#ifdef _WIN32
+    char canonicalPath[MAX_PATH];
+    if (_fullpath(canonicalPath, filePath.c_str(), MAX_PATH) != NULL) {
+      return canonicalPath;
+    }
+#else
+    char canonicalPath[PATH_MAX];
+    if (realpath(filePath.c_str(), canonicalPath) != NULL) {
+      return canonicalPath;
+    }
+#endif
+
+    return filePath;
+  }
+
+  int ModelCache::getLevelsOfDetail(const int &frame) const {
+    // The frames of animated models never have lower levels of detail, like the
+    // frames of objects loaded without a cache, whose topology may be shared
+    return frame > 0 ? 1 : levelsOfDetail;
+  }
+
+  string ModelCache::getKey(const string &canonicalPath, const int &levelsOfDetail) {
+    stringstream ss;
+    ss << canonicalPath << "|" << levelsOfDetail;
+    return ss.str();
+  }
+
+  string ModelCache::getFrameLocation(const string &modelPath, const int &frame) {
+    stringstream ss;
+    ss << modelPath << "_" << setfill('0') << setw(6) << frame << ".obj";
+    return ss.str();
+  }
+
+  shared_ptr<const Model> ModelCache::getModel(const string &modelPath, const int &frame) {
+    string fileLocation = frame > 0 ? getFrameLocation(modelPath, frame) : modelPath;
+    string canonicalPath = getCanonicalPath(fileLocation);
+
+    promise<shared_ptr<const Model> > loading;
+    shared_future<shared_ptr<const Model> > cachedModel;
+    string key;
+    unsigned long load = 0;
+    string meshCacheDirectory;
+    int levelsOfDetail;
+
+    {
+      lock_guard<mutex> lock(cacheMutex);
+      meshCacheDirectory = this->meshCacheDirectory;
+      levelsOfDetail = getLevelsOfDetail(frame);
+      key = getKey(canonicalPath, levelsOfDetail);
+      unordered_map<string, CachedModel>::iterator found = models.find(key);
+      if (found != models.end()) {
+        ++hits;
+        cachedModel = found->second.model;
+      }
+      else {
+        ++misses;
+        load = ++numLoads;
+        CachedModel &loadingModel = models[key];
+        loadingModel.model = loading.get_future().share();
+        loadingModel.load = load;
+      }
+    }
+
+    // If the model is still being loaded by another thread, this waits for it
+    // (outside the lock, so that other models can be requested in the meantime)
+    if (cachedModel.valid()) {
+      return cachedModel.get();
+    }
+
+    // Load outside the lock, so that other models can be loaded at the same time
+    try {
+      shared_ptr<Model> model(new Model());
+      WavefrontLoader loader(true, meshCacheDirectory != "", true, false, levelsOfDetail);
+      loader.setMeshCacheDirectory(meshCacheDirectory);
+      loader.load(fileLocation, *model);
+      loading.set_value(model);
+      return model;
+    }
+    catch (...) {
+      // Do not keep the failure in the cache, so that loading can be retried. Threads
+      // already waiting for the model get the exception. If the model has been evicted
+      // in the meantime, another load may have replaced it, which is left alone.
+      {
+        lock_guard<mutex> lock(cacheMutex);
+        unordered_map<string, CachedModel>::iterator found = models.find(key);
+        if (found != models.end() && found->second.load == load) {
+          models.erase(found);
+        }
+      }
+      loading.set_exception(current_exception());
+      throw;
+    }
+  }
+
+  void ModelCache::setMeshCacheDirectory(const string &directory) {
+    lock_guard<mutex> lock(cacheMutex);
+    meshCacheDirectory = directory;
+  }
+
+  void ModelCache::setLevelsOfDetail(const int &levelsOfDetail) {
+    lock_guard<mutex> lock(cacheMutex);
+    this->levelsOfDetail = levelsOfDetail;
+  }
+
+  bool ModelCache::contains(const string &modelPath, const int &frame) {
+    string canonicalPath = getCanonicalPath(frame > 0 ? getFrameLocation(modelPath, frame) : modelPath);
+    lock_guard<mutex> lock(cacheMutex);
+    return models.find(getKey(canonicalPath, getLevelsOfDetail(frame))) != models.end();
+  }
+
+  bool ModelCache::evict(const string &modelPath, const int &frame) {
+    string canonicalPath = getCanonicalPath(frame > 0 ? getFrameLocation(modelPath, frame) : modelPath);
+    lock_guard<mutex> lock(cacheMutex);
+    return models.erase(getKey(canonicalPath, getLevelsOfDetail(frame))) > 0;
+  }
+
+  size_t ModelCache::evictUnused() {
+    lock_guard<mutex> lock(cacheMutex);
+    size_t numEvicted = 0;
+
+    unordered_map<string, CachedModel>::iterator model = models.begin();
+    while (model != models.end()) {
+      // Only loaded models, which nobody else holds, are evicted
+      if (model->second.model.wait_for(chrono::seconds(0)) == future_status::ready &&
+          model->second.model.get().use_count() == 1) {
+        model = models.erase(model);
+        ++numEvicted;
+      }
+      else {
+        ++model;
+      }
+    }
+
+    return numEvicted;
+  }
+
+  void ModelCache::clear() {
+    lock_guard<mutex> lock(cacheMutex);
+    models.clear();
+  }
+
+  size_t ModelCache::getSize() {
+    lock_guard<mutex> lock(cacheMutex);
+    return models.size();
+  }
+
+  long ModelCache::getHits() {
+    lock_guard<mutex> lock(cacheMutex);
+    return hits;
+  }
+
+  long ModelCache::getMisses() {
+    lock_guard<mutex> lock(cacheMutex);
+    return misses;
+  }
+
+  void ModelCache::resetStatistics() {
+    lock_guard<mutex> lock(cacheMutex);
+    hits = 0;
+    misses = 0;
+  }
+
+}
@@ -0,0 +1,330 @@
+/*
+ *  OcclusionBuffer.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "OcclusionBuffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+namespace small3d {
+
+  // A function of the position on the buffer, a * x + b * y + c
+  struct PlaneFunction {
+    float a, b, c;
+  };
+
+  // The barycentric coordinate which is 1 at the vertex opposite the edge from
+  // 'from' to 'to' and 0 along the edge, given the doubled signed area of the triangle
+  static PlaneFunction barycentricFunction(const glm::vec3 &from, const glm::vec3 &to, const float &inverseArea) {
+    PlaneFunction function;
+    function.a = -(to.y - from.y) * inverseArea;
+    function.b = (to.x - from.x) * inverseArea;
+    function.c = ((to.y - from.y) * from.x - (to.x - from.x) * from.y) * inverseArea;
+    return function;
+  }
+
+  // Points behind the near plane (or the camera) cannot be projected onto the buffer
+  static bool isInFrontOfNearPlane(const glm::vec4 &clipPosition) {
+    return clipPosition.w > 0.0f && clipPosition.z >= -clipPosition.w;
+  }
+
+  // A triangle projected onto the buffer. Its edge functions are positive inside it and
+  // its depth function gives the normalised depth. The margins are the amounts by which
+  // they change between the centre of a pixel and any point of it.
+  struct ProjectedTriangle {
+    glm::vec3 positions[3];
+    PlaneFunction edges[3];
+    float margins[3];
+    PlaneFunction depth;
+    float depthMargin;
+  };
+
+  // What a pixel crossing an edge needs from the triangle on the other side of it: the
+  // functions of that triangle's other two edges, which are not negative when the pixel
+  // is entirely inside them, and its farthest depth on the pixel, given the pixel's centre
+  struct EdgeNeighbour {
+    PlaneFunction otherEdges[2];
+    PlaneFunction farthestDepth;
+  };
+
+  // Project a triangle onto a buffer of the given size, returning which way it faces:
+  // 1 or -1, or 0 if it is seen edge on or cannot be projected
+  static int projectTriangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c, const int &width,
+                             const int &height, ProjectedTriangle &triangle) {
+    if (!isInFrontOfNearPlane(a) || !isInFrontOfNearPlane(b) || !isInFrontOfNearPlane(c)) {
+      return 0;
+    }
+
+    // Positions on the buffer, with the normalised depths
+    glm::vec3 *positions = triangle.positions;
+    const glm::vec4 *clipPositions[3] = {&a, &b, &c};
+    for (int vertex = 0; vertex != 3; ++vertex) {
+      const glm::vec4 &clipPosition = *clipPositions[vertex];
+      positions[vertex] = glm::vec3((clipPosition.x / clipPosition.w * 0.5f + 0.5f) * width,
+                                    (clipPosition.y / clipPosition.w * 0.5f + 0.5f) * height,
+                                    clipPosition.z / clipPosition.w);
+    }
+
+    float area = (positions[1].x - positions[0].x) * (positions[2].y - positions[0].y) -
+                 (positions[1].y - positions[0].y) * (positions[2].x - positions[0].x);
+
+    // Seen edge on (or degenerate), so it covers nothing
+    if (fabs(area) < 1e-8f) {
+      return 0;
+    }
+
+    // Dividing by the area makes the functions positive inside the triangle,
+    // whichever way it is facing
+    float inverseArea = 1.0f / area;
+    for (int edge = 0; edge != 3; ++edge) {
+      triangle.edges[edge] = barycentricFunction(positions[(edge + 1) % 3], positions[(edge + 2) % 3], inverseArea);
+      triangle.margins[edge] = 0.5f * (fabs(triangle.edges[edge].a) + fabs(triangle.edges[edge].b));
+    }
+
+    PlaneFunction &depth = triangle.depth;
+    depth.a = depth.b = depth.c = 0.0f;
+    for (int vertex = 0; vertex != 3; ++vertex) {
+      depth.a += triangle.edges[vertex].a * positions[vertex].z;
+      depth.b += triangle.edges[vertex].b * positions[vertex].z;
+      depth.c += triangle.edges[vertex].c * positions[vertex].z;
+    }
+    triangle.depthMargin = 0.5f * (fabs(depth.a) + fabs(depth.b));
+
+    return area > 0.0f ? 1 : -1;
+  }
+
+  // Rasterise a projected triangle into a buffer of the given size, given what its
+  // neighbours across each edge contain, returning false if it is outside the buffer
+  static bool rasteriseTriangle(const ProjectedTriangle &triangle, const EdgeNeighbour neighbours[3],
+                                const int &width, const int &height, vector<float> &depths) {
+    const glm::vec3 *positions = triangle.positions;
+    int minX = max(0, static_cast<int>(floor(min(positions[0].x, min(positions[1].x, positions[2].x)))));
+    int maxX = min(width - 1, static_cast<int>(floor(max(positions[0].x, max(positions[1].x, positions[2].x)))));
+    int minY = max(0, static_cast<int>(floor(min(positions[0].y, min(positions[1].y, positions[2].y)))));
+    int maxY = min(height - 1, static_cast<int>(floor(max(positions[0].y, max(positions[1].y, positions[2].y)))));
+
+    if (minX > maxX || minY > maxY) {
+      return false;
+    }
+
+    const PlaneFunction *edges = triangle.edges;
+    const float *margins = triangle.margins;
+    const PlaneFunction &depth = triangle.depth;
+
+    // A pixel is entirely inside the triangle when each edge function is at least as large
+    // as its margin at the centre, and the triangle is no farther than the centre's depth
+    // plus the depth margin anywhere on the pixel. A pixel whose centre is inside can also
+    // cross an edge, if the neighbouring triangle contains the rest of it, in which case the
+    // neighbour's farthest depth on the pixel is kept, if it is larger.
+    for (int y = minY; y <= maxY; ++y) {
+      float centreY = static_cast<float>(y) + 0.5f;
+      float rowEdges[3], rowOtherEdges[3][2], rowNeighbourDepths[3];
+      for (int edge = 0; edge != 3; ++edge) {
+        rowEdges[edge] = edges[edge].b * centreY + edges[edge].c;
+        for (int other = 0; other != 2; ++other) {
+          rowOtherEdges[edge][other] = neighbours[edge].otherEdges[other].b * centreY +
+                                       neighbours[edge].otherEdges[other].c;
+        }
+        rowNeighbourDepths[edge] = neighbours[edge].farthestDepth.b * centreY + neighbours[edge].farthestDepth.c;
+      }
+      float rowDepth = depth.b * centreY + depth.c + triangle.depthMargin;
+      float *row = &depths[static_cast<size_t>(y) * width];
+
+      // Only pixels entirely inside the triangle (or its neighbours) are covered, so that
+      // the buffer never hides anything that shows through part of a pixel
+      for (int x = minX; x <= maxX; ++x) {
+        float centreX = static_cast<float>(x) + 0.5f;
+        float pixelDepth = depth.a * centreX + rowDepth;
+        bool covered = true;
+        for (int edge = 0; edge != 3; ++edge) {
+          const EdgeNeighbour &neighbour = neighbours[edge];
+          float edgeValue = edges[edge].a * centreX + rowEdges[edge];
+          bool inside = edgeValue >= margins[edge];
+          bool neighbourCovers = (edgeValue >= 0.0f) &
+                                 (neighbour.otherEdges[0].a * centreX + rowOtherEdges[edge][0] >= 0.0f) &
+                                 (neighbour.otherEdges[1].a * centreX + rowOtherEdges[edge][1] >= 0.0f);
+          float neighbourDepth = neighbour.farthestDepth.a * centreX + rowNeighbourDepths[edge];
+          covered &= inside | neighbourCovers;
+          pixelDepth = inside ? pixelDepth : max(pixelDepth, neighbourDepth);
+        }
+        float current = row[x];
+        covered &= pixelDepth < current;
+        row[x] = covered ? pixelDepth : current;
+      }
+    }
+    return true;
+  }
+
+  OcclusionBuffer::OcclusionBuffer(const int &width, const int &height) {
+    this->width = max(width, 0);
+    this->height = max(height, 0);
+    depths.assign(static_cast<size_t>(this->width) * this->height, numeric_limits<float>::max());
+    numTrianglesRasterised = 0;
+  }
+
+  void OcclusionBuffer::clear(const glm::mat4 &viewProjectionMatrix) {
+    fill(depths.begin(), depths.end(), numeric_limits<float>::max());
+    this->viewProjectionMatrix = viewProjectionMatrix;
+    numTrianglesRasterised = 0;
+  }
+
+  void OcclusionBuffer::rasteriseOccluder(const Model &model, const glm::mat4 &modelMatrix) {
+    glm::mat4 modelViewProjectionMatrix = viewProjectionMatrix * modelMatrix;
+
+    // 4 components per vertex
+    size_t numVertices = model.vertexData.size() / 4;
+    vector<glm::vec4> clipPositions(numVertices);
+    for (size_t vertex = 0; vertex != numVertices; ++vertex) {
+      clipPositions[vertex] = modelViewProjectionMatrix *
+                              glm::vec4(model.vertexData[4 * vertex], model.vertexData[4 * vertex + 1],
+                                        model.vertexData[4 * vertex + 2], 1.0f);
+    }
+
+    size_t numTriangles = model.getNumIndexes() / 3;
+    vector<ProjectedTriangle> triangles(numTriangles);
+    vector<int> facings(numTriangles);
+    for (size_t triangle = 0; triangle != numTriangles; ++triangle) {
+      facings[triangle] = projectTriangle(clipPositions[model.indexData[3 * triangle]],
+                                          clipPositions[model.indexData[3 * triangle + 1]],
+                                          clipPositions[model.indexData[3 * triangle + 2]], width, height,
+                                          triangles[triangle]);
+    }
+
+    // Without a neighbour, the other edges never contain the pixel
+    EdgeNeighbour noNeighbour;
+    for (int edge = 0; edge != 2; ++edge) {
+      noNeighbour.otherEdges[edge].a = noNeighbour.otherEdges[edge].b = 0.0f;
+      noNeighbour.otherEdges[edge].c = -1.0f;
+    }
+    noNeighbour.farthestDepth.a = noNeighbour.farthestDepth.b = noNeighbour.farthestDepth.c = 0.0f;
+    vector<EdgeNeighbour> neighbours(3 * numTriangles, noNeighbour);
+
+    // A pixel crossing an edge between two triangles facing the same way can be covered
+    // by the two of them together. The edges are found by sorting them by their vertices.
+    // Edge k of a triangle is the one opposite its vertex k.
+    vector<pair<uint64_t, size_t> > edges(3 * numTriangles);
+    for (size_t triangle = 0; triangle != numTriangles; ++triangle) {
+      for (size_t edge = 0; edge != 3; ++edge) {
+        uint64_t from = model.indexData[3 * triangle + (edge + 1) % 3];
+        uint64_t to = model.indexData[3 * triangle + (edge + 2) % 3];
+        edges[3 * triangle + edge] = make_pair(from < to ? from << 32 | to : to << 32 | from, 3 * triangle + edge);
+      }
+    }
+    sort(edges.begin(), edges.end());
+
+    for (size_t edge = 0; edge + 1 < edges.size(); ++edge) {
+      // Edges shared by more than two triangles are left alone
+      if (edges[edge].first != edges[edge + 1].first ||
+          (edge + 2 != edges.size() && edges[edge + 2].first == edges[edge].first) ||
+          (edge != 0 && edges[edge - 1].first == edges[edge].first)) {
+        continue;
+      }
+      size_t sides[2] = {edges[edge].second, edges[edge + 1].second};
+      int facing = facings[sides[0] / 3];
+      if (facing == 0 || facing != facings[sides[1] / 3]) {
+        continue;
+      }
+
+      // The triangles have to be on either side of the edge (they are not, if they
+      // are wound inconsistently)
+      const glm::vec3 &opposite = triangles[sides[1] / 3].positions[sides[1] % 3];
+      const PlaneFunction &sharedEdge = triangles[sides[0] / 3].edges[sides[0] % 3];
+      if (sharedEdge.a * opposite.x + sharedEdge.b * opposite.y + sharedEdge.c >= 0.0f) {
+        continue;
+      }
+
+      for (int side = 0; side != 2; ++side) {
+        const ProjectedTriangle &neighbour = triangles[sides[1 - side] / 3];
+        size_t neighbourEdge = sides[1 - side] % 3;
+        EdgeNeighbour &edgeNeighbour = neighbours[sides[side]];
+        for (int other = 0; other != 2; ++other) {
+          size_t otherEdge = (neighbourEdge + 1 + other) % 3;
+          edgeNeighbour.otherEdges[other] = neighbour.edges[otherEdge];
+          edgeNeighbour.otherEdges[other].c -= neighbour.margins[otherEdge];
+        }
+        edgeNeighbour.farthestDepth = neighbour.depth;
+        edgeNeighbour.farthestDepth.c += neighbour.depthMargin;
+      }
+    }
+
+    for (size_t triangle = 0; triangle != numTriangles; ++triangle) {
+      if (facings[triangle] != 0 &&
+          rasteriseTriangle(triangles[triangle], &neighbours[3 * triangle], width, height, depths)) {
+        ++numTrianglesRasterised;
+      }
+    }
+  }
+
+  bool OcclusionBuffer::isBoxVisible(const glm::vec3 &boxMin, const glm::vec3 &boxMax,
+                                     const glm::mat4 &modelMatrix) const {
+    glm::mat4 modelViewProjectionMatrix = viewProjectionMatrix * modelMatrix;
+
+    // The rectangle the box covers on the buffer and its nearest depth
+    float minX = numeric_limits<float>::max(), minY = numeric_limits<float>::max();
+    float maxX = -numeric_limits<float>::max(), maxY = -numeric_limits<float>::max();
+    float nearestDepth = numeric_limits<float>::max();
+    for (int corner = 0; corner != 8; ++corner) {
+      glm::vec4 clipPosition = modelViewProjectionMatrix *
+                               glm::vec4(corner & 1 ? boxMax.x : boxMin.x, corner & 2 ? boxMax.y : boxMin.y,
+                                         corner & 4 ? boxMax.z : boxMin.z, 1.0f);
+      if (!isInFrontOfNearPlane(clipPosition)) {
+        return true;
+      }
+      float x = (clipPosition.x / clipPosition.w * 0.5f + 0.5f) * width;
+      float y = (clipPosition.y / clipPosition.w * 0.5f + 0.5f) * height;
+      minX = min(minX, x);
+      maxX = max(maxX, x);
+      minY = min(minY, y);
+      maxY = max(maxY, y);
+      nearestDepth = min(nearestDepth, clipPosition.z / clipPosition.w);
+    }
+
+    int firstX = max(0, static_cast<int>(floor(minX)));
+    int lastX = min(width - 1, static_cast<int>(floor(maxX)));
+    int firstY = max(0, static_cast<int>(floor(minY)));
+    int lastY = min(height - 1, static_cast<int>(floor(maxY)));
+
+    if (firstX > lastX || firstY > lastY) {
+      return true;
+    }
+
+    // Hidden only if every pixel it covers has something nearer in front of it
+    for (int y = firstY; y <= lastY; ++y) {
+      const float *row = &depths[static_cast<size_t>(y) * width];
+      bool hidden = true;
+      for (int x = firstX; x <= lastX; ++x) {
+        hidden &= row[x] < nearestDepth;
+      }
+      if (!hidden) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  int OcclusionBuffer::getNumTrianglesRasterised() const {
+    return numTrianglesRasterised;
+  }
+
+  float OcclusionBuffer::getDepth(const int &x, const int &y) const {
+    return depths[static_cast<size_t>(y) * width + x];
+  }
+
+  int OcclusionBuffer::getWidth() const {
+    return width;
+  }
+
+  int OcclusionBuffer::getHeight() const {
+    return height;
+  }
+
+}
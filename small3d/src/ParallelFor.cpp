@@ -0,0 +1,73 @@
+/*
+ *  ParallelFor.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "ParallelFor.hpp"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <exception>
+#include <system_error>
+
+using namespace std;
+
+namespace small3d {
+
+  void parallelFor(const int &count, const function<void(const int &)> &task) {
+    if (count <= 0) return;
+
+    int numThreads = static_cast<int>(thread::hardware_concurrency());
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > count) numThreads = count;
+
+    atomic<int> nextIndex(0);
+    atomic<bool> failed(false);
+    exception_ptr firstException;
+    mutex exceptionMutex;
+
+    auto worker = [&]() {
+      while (!failed) {
+        int index = nextIndex++;
+        if (index >= count) break;
+        try {
+          task(index);
+        }
+        catch (...) {
+          lock_guard<mutex> lock(exceptionMutex);
+          if (!firstException) {
+            firstException = current_exception();
+          }
+          failed = true;
+        }
+      }
+    };
+
+    vector<thread> threads;
+    threads.reserve(static_cast<size_t>(numThreads - 1));
+
+    for (int idx = 1; idx < numThreads; ++idx) {
+      try {
+        threads.push_back(thread(worker));
+      }
+      catch (const system_error &) {
+        // Could not start another thread. The ones that are running will do the work.
+        break;
+      }
+    }
+
+    worker();
+
+    for (vector<thread>::iterator t = threads.begin(); t != threads.end(); ++t) {
+      t->join();
+    }
+
+    if (firstException) {
+      rethrow_exception(firstException);
+    }
+  }
+}
@@ -0,0 +1,149 @@
+/*
+ *  ParseNumbers.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "ParseNumbers.hpp"
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+namespace small3d {
+
+  // Powers of 10 that can be represented exactly as doubles
+  static const double exactPowersOf10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+      1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+      1e21, 1e22
+  };
+
+  // Beyond this, the mantissa can no longer be represented exactly as a double
+  static const uint64_t maxExactMantissa = 1ULL << 53;
+
+  // Beyond this number of digits, the mantissa could overflow
+  static const int maxMantissaDigits = 19;
+
+  const char* parseFloat(const char* pos, const char* end, float &value) {
+    const char* start = pos;
+    bool negative = false;
+
+    if (pos != end && (*pos == '-' || *pos == '+')) {
+      negative = *pos == '-';
+      ++pos;
+    }
+
+    uint64_t mantissa = 0;
+    int numMantissaDigits = 0;
+    int exponent = 0;
+    bool digitsFound = false;
+
+    // Integer part
+    while (pos != end && *pos >= '0' && *pos <= '9') {
+      digitsFound = true;
+      if (numMantissaDigits < maxMantissaDigits) {
+        mantissa = mantissa * 10 + static_cast<uint64_t>(*pos - '0');
+        if (mantissa != 0) ++numMantissaDigits;
+      }
+      else {
+        // Digits that do not fit in the mantissa only affect the magnitude
+        ++exponent;
+      }
+      ++pos;
+    }
+
+    // Fractional part
+    if (pos != end && *pos == '.') {
+      ++pos;
+      while (pos != end && *pos >= '0' && *pos <= '9') {
+        digitsFound = true;
+        if (numMantissaDigits < maxMantissaDigits) {
+          mantissa = mantissa * 10 + static_cast<uint64_t>(*pos - '0');
+          if (mantissa != 0) ++numMantissaDigits;
+          --exponent;
+        }
+        ++pos;
+      }
+    }
+
+    if (!digitsFound) {
+      value = 0.0f;
+      return start;
+    }
+
+    // Exponent (only consumed if it is well formed)
+    if (pos != end && (*pos == 'e' || *pos == 'E')) {
+      const char* exponentPos = pos + 1;
+      bool negativeExponent = false;
+      if (exponentPos != end && (*exponentPos == '-' || *exponentPos == '+')) {
+        negativeExponent = *exponentPos == '-';
+        ++exponentPos;
+      }
+      if (exponentPos != end && *exponentPos >= '0' && *exponentPos <= '9') {
+        int explicitExponent = 0;
+        while (exponentPos != end && *exponentPos >= '0' && *exponentPos <= '9') {
+          if (explicitExponent < 10000) {
+            explicitExponent = explicitExponent * 10 + (*exponentPos - '0');
+          }
+          ++exponentPos;
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        pos = exponentPos;
+      }
+    }
+
+    double result;
+
+    if (mantissa == 0) {
+      result = 0.0;
+    }
+    else if (mantissa <= maxExactMantissa && exponent >= -22 && exponent <= 22) {
+      // Both operands are exact, so the single multiplication or division
+      // is correctly rounded, like the result of atof.
+      result = static_cast<double>(mantissa);
+      if (exponent < 0) {
+        result /= exactPowersOf10[-exponent];
+      }
+      else {
+        result *= exactPowersOf10[exponent];
+      }
+    }
+    else {
+      // Rare in model files. Close enough, but not necessarily correctly rounded.
+      result = static_cast<double>(static_cast<long double>(mantissa) *
+                                   powl(10.0L, static_cast<long double>(exponent)));
+    }
+
+    value = static_cast<float>(negative ? -result : result);
+    return pos;
+  }
+
+  const char* parseInt(const char* pos, const char* end, int &value) {
+    const char* start = pos;
+    bool negative = false;
+
+    if (pos != end && (*pos == '-' || *pos == '+')) {
+      negative = *pos == '-';
+      ++pos;
+    }
+
+    const char* digitsStart = pos;
+    int result = 0;
+
+    while (pos != end && *pos >= '0' && *pos <= '9') {
+      result = result * 10 + (*pos - '0');
+      ++pos;
+    }
+
+    if (pos == digitsStart) {
+      value = 0;
+      return start;
+    }
+
+    value = negative ? -result : result;
+    return pos;
+  }
+}
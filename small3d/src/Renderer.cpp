@@ -8,7 +8,14 @@
 
 #include "Renderer.hpp"
 #include "Exception.hpp"
+#include "FileFunctions.hpp"
 #include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <chrono>
+#include <sstream>
+#include <cstdint>
 #include "MathFunctions.hpp"
 #include <glm/gtc/type_ptr.hpp>
 
@@ -17,25 +24,57 @@ using namespace std;
 namespace small3d {
   string openglErrorToString(GLenum error);
 
+  // The uniform buffer binding point of the FrameUniforms block and its size, in floats
+  static const GLuint FRAME_UNIFORMS_BINDING = 0;
+  static const size_t FRAME_UNIFORMS_SIZE = 20;
+
+  // The locations of the vertex attributes which are set per object, or per instance
+  // (the model matrix takes up four locations and the normal matrix three)
+  static const GLuint MODEL_MATRIX_ATTRIBUTE = 5;
+  static const GLuint NORMAL_MATRIX_ATTRIBUTE = 9;
+  static const GLuint COLOUR_ATTRIBUTE = 12;
+
+  // The number of floats per instance in the instance buffer (model matrix,
+  // normal matrix and colour)
+  static const size_t INSTANCE_SIZE = 16 + 9 + 4;
+
+  // The width of the occlusion buffer, in pixels (its height follows the window's)
+  static const int OCCLUSION_BUFFER_WIDTH = 256;
+
+  // The number of frames whose GPU timer queries are kept, waiting for their results
+  static const size_t TIMER_QUERY_FRAMES = 4;
+
+  // Written at the start of each program cache file, so that files in another
+  // format are recognised as stale
+  static const string PROGRAM_CACHE_SIGNATURE = "small3d program cache 1";
+
+  // 64-bit FNV-1a, which (unlike std::hash) is the same with every compiler, so
+  // that the program cache keys do not change when the application is rebuilt
+  static uint64_t hashString(const string &text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t idx = 0; idx < text.size(); ++idx) {
+      hash ^= static_cast<unsigned char>(text[idx]);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
   string Renderer::loadShaderFromFile(const string &fileLocation) {
     initLogger();
-    string shaderSource = "";
-    ifstream file((SDL_GetBasePath() + fileLocation).c_str());
-    string line;
-    if (file.is_open()) {
-      while (getline(file, line)) {
-        shaderSource += line + "\n";
-      }
+    ifstream file((SDL_GetBasePath() + fileLocation).c_str(), ios::in | ios::binary);
+    if (!file.is_open()) {
+      return "";
     }
-    return shaderSource;
+    stringstream shaderSource;
+    shaderSource << file.rdbuf();
+    return shaderSource.str();
   }
 
-  GLuint Renderer::compileShader(const string &shaderSourceFile, const GLenum shaderType) {
+  GLuint Renderer::compileShader(const string &shaderSource, const string &shaderSourceFile,
+                                 const GLenum shaderType) {
 
     GLuint shader = glCreateShader(shaderType);
 
-    string shaderSource = this->loadShaderFromFile(shaderSourceFile);
-
     const char *shaderSourceChars = shaderSource.c_str();
     glShaderSource(shader, 1, &shaderSourceChars, NULL);
 
@@ -56,11 +95,203 @@ namespace small3d {
     return shader;
   }
 
+  GLuint Renderer::createProgram(const string &name, const string &vertexShaderPath,
+                                 const string &fragmentShaderPath,
+                                 const vector<pair<GLuint, string> > &attributeLocations) {
+    string vertexShaderSource = loadShaderFromFile(vertexShaderPath);
+    string fragmentShaderSource = loadShaderFromFile(fragmentShaderPath);
+
+    string cacheFile = "";
+    string cacheKey = "";
+    if (!programBinaryFormats.empty() && !programCachePath.empty()) {
+      // The attribute locations are part of the binary too
+      stringstream sources;
+      sources << vertexShaderSource << '\0' << fragmentShaderSource << '\0';
+      for (size_t idx = 0; idx < attributeLocations.size(); ++idx) {
+        sources << attributeLocations[idx].first << " " << attributeLocations[idx].second << "\n";
+      }
+      stringstream key;
+      key << PROGRAM_CACHE_SIGNATURE << "\n"
+          << reinterpret_cast<const char *>(glGetString(GL_VENDOR)) << "\n"
+          << reinterpret_cast<const char *>(glGetString(GL_RENDERER)) << "\n"
+          << reinterpret_cast<const char *>(glGetString(GL_VERSION)) << "\n"
+          << hex << hashString(sources.str());
+      cacheKey = key.str();
+      cacheFile = SDL_GetBasePath() + programCachePath + "small3d_" + name + ".bin";
+
+      GLuint cachedProgram = loadProgramBinary(cacheFile, cacheKey);
+      if (cachedProgram != 0) {
+        ++numProgramsLoadedFromCache;
+        LOGINFO("Loaded the " + name + " program from the program cache");
+        return cachedProgram;
+      }
+    }
+
+    GLuint vertexShader = compileShader(vertexShaderSource, vertexShaderPath, GL_VERTEX_SHADER);
+    GLuint fragmentShader = compileShader(fragmentShaderSource, fragmentShaderPath, GL_FRAGMENT_SHADER);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+
+    for (size_t idx = 0; idx < attributeLocations.size(); ++idx) {
+      glBindAttribLocation(program, attributeLocations[idx].first, attributeLocations[idx].second.c_str());
+    }
+
+    if (!cacheFile.empty()) {
+      glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    glLinkProgram(program);
+
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+      throw Exception("Failed to link program:\n" + this->getProgramInfoLog(program));
+    }
+    LOGINFO("Linked " + name + " program successfully");
+
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    if (!cacheFile.empty()) {
+      saveProgramBinary(program, cacheFile, cacheKey);
+    }
+
+    return program;
+  }
+
+  GLuint Renderer::loadProgramBinary(const string &cacheFile, const string &cacheKey) {
+    ifstream file(cacheFile.c_str(), ios::in | ios::binary | ios::ate);
+    if (!file.is_open()) {
+      return 0;
+    }
+
+    // The length of the binary is checked against the size of the file before it is
+    // read, so that a corrupt file cannot make this allocate gigabytes
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0, ios::beg);
+
+    uint32_t keyLength = 0;
+    file.read(reinterpret_cast<char *>(&keyLength), sizeof(keyLength));
+    if (!file || keyLength != cacheKey.size()) {
+      LOGINFO("Ignoring stale program cache file " + cacheFile);
+      return 0;
+    }
+    string key(keyLength, '\0');
+    file.read(&key[0], keyLength);
+    if (!file || key != cacheKey) {
+      LOGINFO("Ignoring stale program cache file " + cacheFile);
+      return 0;
+    }
+
+    uint32_t format = 0;
+    uint32_t binaryLength = 0;
+    file.read(reinterpret_cast<char *>(&format), sizeof(format));
+    file.read(reinterpret_cast<char *>(&binaryLength), sizeof(binaryLength));
+    if (!file || binaryLength == 0 || binaryLength > fileSize - static_cast<uint64_t>(file.tellg())) {
+      LOGINFO("Ignoring unreadable program cache file " + cacheFile);
+      return 0;
+    }
+    vector<char> binary(binaryLength);
+    file.read(binary.data(), binaryLength);
+
+    // Loading a format the driver does not list would be an OpenGL error, rather
+    // than a failure to link
+    if (!file ||
+        find(programBinaryFormats.begin(), programBinaryFormats.end(), static_cast<GLint>(format)) ==
+        programBinaryFormats.end()) {
+      LOGINFO("Ignoring unreadable program cache file " + cacheFile);
+      return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, static_cast<GLenum>(format), binary.data(), static_cast<GLsizei>(binaryLength));
+
+    // Drivers can reject binaries even if the key matches (e.g. after an update
+    // which kept the version string), in which case the program is compiled again
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+      LOGINFO("The driver rejected program cache file " + cacheFile);
+      glDeleteProgram(program);
+      return 0;
+    }
+
+    return program;
+  }
+
+  void Renderer::saveProgramBinary(const GLuint &program, const string &cacheFile, const string &cacheKey) {
+    GLint binaryLength = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0) {
+      return;
+    }
+
+    vector<char> binary(static_cast<size_t>(binaryLength));
+    GLsizei length = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, binaryLength, &length, &format, binary.data());
+    if (length <= 0) {
+      return;
+    }
+
+    // Written to a temporary file first, so that another instance of the game starting at
+    // the same time never loads a partly written binary
+    string temporaryFile = getTemporaryFilePath(cacheFile);
+    ofstream file(temporaryFile.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!file.is_open()) {
+      LOGINFO("Could not write program cache file " + cacheFile);
+      return;
+    }
+
+    uint32_t keyLength = static_cast<uint32_t>(cacheKey.size());
+    uint32_t binaryFormat = static_cast<uint32_t>(format);
+    uint32_t binarySize = static_cast<uint32_t>(length);
+    file.write(reinterpret_cast<const char *>(&keyLength), sizeof(keyLength));
+    file.write(cacheKey.data(), keyLength);
+    file.write(reinterpret_cast<const char *>(&binaryFormat), sizeof(binaryFormat));
+    file.write(reinterpret_cast<const char *>(&binarySize), sizeof(binarySize));
+    file.write(binary.data(), binarySize);
+    file.close();
+
+    if (file.fail()) {
+      remove(temporaryFile.c_str());
+      LOGINFO("Could not write program cache file " + cacheFile);
+    }
+    else if (!replaceFile(temporaryFile, cacheFile)) {
+      LOGINFO("Could not replace program cache file " + cacheFile);
+    }
+    else {
+      LOGINFO("Saved program cache file " + cacheFile);
+    }
+  }
+
   Renderer::Renderer() {
     isOpenGL33Supported = false;
     sdlWindow = 0;
+    offscreenFramebuffer = 0;
+    offscreenColourBuffer = 0;
+    offscreenDepthBuffer = 0;
+    frameWidth = 0;
+    frameHeight = 0;
     perspectiveProgram = 0;
     orthographicProgram = 0;
+    frameUniformBuffer = 0;
+    frameUniformsUploaded = false;
+    viewProjectionCalculated = false;
+    occlusionBufferReady = false;
+    instanceBuffer = 0;
+    imageVertexBuffer = 0;
+    imageIndexBuffer = 0;
+    imageUvBuffer = 0;
+    orthographicImageVao = 0;
+    perspectiveImageVao = 0;
+    boundProgram = 0;
+    boundTexture = 0;
+    boundVertexArray = 0;
     textures = new unordered_map<string, GLuint>();
     noShaders = false;
     lightDirection = glm::vec3(0.0f, 0.9f, 0.2f);
@@ -71,7 +302,23 @@ namespace small3d {
     cameraPosition = glm::vec3(0, 0, 0);
     cameraRotation = glm::vec3(0, 0, 0);
     lightIntensity = 1.0f;
-
+    frustumCulling = true;
+    occlusionCulling = true;
+    currentFrameTimerQueries = 0;
+    timerQueriesSupported = false;
+    lastGpuMilliseconds = -1.0;
+    numFramesRendered = 0;
+    statisticsLogInterval = 0;
+    debugOutputEnabled = false;
+    debugOutputErrorReported = false;
+    numProgramsLoadedFromCache = 0;
+    timeToFirstFrame = -1.0;
+    programCachePath = "";
+#if defined(DEBUG) || defined(_DEBUG)
+    errorChecking = perCallErrorChecking;
+#else
+    errorChecking = noErrorChecking;
+#endif
   }
 
   Renderer::~Renderer() {
@@ -83,6 +330,12 @@ namespace small3d {
     }
     delete textures;
 
+    for (unordered_map<const Model*, ModelBuffers>::iterator buffersIt = modelBuffers.begin();
+         buffersIt != modelBuffers.end(); ++buffersIt) {
+      deleteModelBuffers(buffersIt->second);
+    }
+    modelBuffers.clear();
+
     if (!noShaders) {
       glUseProgram(0);
     }
@@ -91,23 +344,79 @@ namespace small3d {
       glDeleteProgram(orthographicProgram);
     }
 
+    if (frameUniformBuffer != 0) {
+      glDeleteBuffers(1, &frameUniformBuffer);
+    }
+
+    if (instanceBuffer != 0) {
+      glDeleteBuffers(1, &instanceBuffer);
+    }
+
+    if (imageVertexBuffer != 0) {
+      glDeleteBuffers(1, &imageVertexBuffer);
+      glDeleteBuffers(1, &imageIndexBuffer);
+      glDeleteBuffers(1, &imageUvBuffer);
+    }
+
+    if (orthographicImageVao != 0) {
+      glDeleteVertexArrays(1, &orthographicImageVao);
+      glDeleteVertexArrays(1, &perspectiveImageVao);
+    }
+
     if (perspectiveProgram != 0) {
       glDeleteProgram(perspectiveProgram);
     }
 
+    for (vector<FrameTimerQueries>::iterator queries = frameTimerQueries.begin();
+         queries != frameTimerQueries.end(); ++queries) {
+      glDeleteQueries(2, queries->frameQueries);
+      if (!queries->passQueries.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(queries->passQueries.size()), queries->passQueries.data());
+      }
+    }
+
+    if (debugOutputEnabled) {
+      if (GLEW_KHR_debug) {
+        glDebugMessageCallback(NULL, NULL);
+      }
+      else {
+        glDebugMessageCallbackARB(NULL, NULL);
+      }
+    }
+
+    if (offscreenFramebuffer != 0) {
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      glDeleteFramebuffers(1, &offscreenFramebuffer);
+      glDeleteRenderbuffers(1, &offscreenColourBuffer);
+      glDeleteRenderbuffers(1, &offscreenDepthBuffer);
+    }
+
     if (sdlWindow != 0) {
       SDL_DestroyWindow(sdlWindow);
     }
     SDL_Quit();
   }
 
-  void Renderer::initSDL(int width, int height, bool fullScreen, const string &windowTitle) {
+  void Renderer::initSDL(int width, int height, bool fullScreen, const string &windowTitle,
+                         const bool &headless) {
     sdlWindow = 0;
 
     // initialize SDL video
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-      LOGERROR(SDL_GetError());
-      throw Exception(string("Unable to initialise SDL"));
+      if (!headless) {
+        LOGERROR(SDL_GetError());
+        throw Exception(string("Unable to initialise SDL"));
+      }
+
+      // Without a display, the OpenGL context can still be created through EGL. The
+      // driver is chosen with the hint, rather than SDL_VideoInit, so that SDL counts the
+      // video subsystem as initialised and shuts it down in SDL_Quit.
+      LOGINFO(string("No display available (") + SDL_GetError() + "), using the offscreen video driver");
+      SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+      if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0) {
+        LOGERROR(SDL_GetError());
+        throw Exception(string("Unable to initialise SDL without a display"));
+      }
     }
 
 #ifdef __APPLE__
@@ -121,9 +430,19 @@ namespace small3d {
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 8);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 
+    // Drivers report more problems to the debug message callback in a debug context
+    if (errorChecking == perCallErrorChecking) {
+      SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+    }
+
     Uint32 flags = fullScreen ? SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN | SDL_WINDOW_FULLSCREEN :
                    SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN;
 
+    // In headless mode, the window only holds the OpenGL context
+    if (headless) {
+      flags = SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN;
+    }
+
     sdlWindow = SDL_CreateWindow(windowTitle.c_str(), SDL_WINDOWPOS_CENTERED,
                                  SDL_WINDOWPOS_CENTERED, width, height,
                                  flags);
@@ -206,19 +525,112 @@ namespace small3d {
     }
   }
 
+  void Renderer::checkForRenderingErrors(const string &when, const bool &perCall) {
+    if (errorChecking == noErrorChecking || (perCall && errorChecking != perCallErrorChecking)) {
+      return;
+    }
+
+    if (debugOutputEnabled) {
+      // Already logged by the callback
+      if (debugOutputErrorReported.exchange(false)) {
+        throw Exception("OpenGL error while " + when);
+      }
+      return;
+    }
+
+    checkForOpenGLErrors(when, true);
+  }
+
+  void GLAPIENTRY Renderer::debugMessageCallback(GLenum /*source*/, GLenum type, GLuint /*id*/, GLenum severity,
+                                                 GLsizei /*length*/, const GLchar *message, const void *userParam) {
+    Renderer *renderer = static_cast<Renderer *>(const_cast<void *>(userParam));
+    // The KHR_debug and ARB_debug_output constants have the same values
+    if (type == GL_DEBUG_TYPE_ERROR) {
+      LOGERROR("OpenGL error: " + string(message));
+      renderer->debugOutputErrorReported = true;
+    }
+    else if (severity == GL_DEBUG_SEVERITY_HIGH || severity == GL_DEBUG_SEVERITY_MEDIUM) {
+      LOGINFO("OpenGL warning: " + string(message));
+    }
+  }
+
+  void Renderer::enableDebugOutput() {
+    debugOutputEnabled = false;
+    debugOutputErrorReported = false;
+
+    // Outside a debug context, drivers are not required to report errors to the
+    // callback, so they are queried with glGetError instead
+    GLint contextFlags = 0;
+    if (isOpenGL33Supported) {
+      glGetIntegerv(GL_CONTEXT_FLAGS, &contextFlags);
+    }
+    if ((contextFlags & GL_CONTEXT_FLAG_DEBUG_BIT) == 0) {
+      return;
+    }
+
+    if (GLEW_KHR_debug) {
+      glDebugMessageCallback(debugMessageCallback, this);
+      // Low severity messages and notifications are not even sent to the callback
+      glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+      glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_LOW, 0, NULL, GL_FALSE);
+      glEnable(GL_DEBUG_OUTPUT);
+      debugOutputEnabled = true;
+    }
+    else if (GLEW_ARB_debug_output) {
+      glDebugMessageCallbackARB(debugMessageCallback, this);
+      glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_LOW_ARB, 0, NULL, GL_FALSE);
+      debugOutputEnabled = true;
+    }
+
+    if (debugOutputEnabled) {
+      // Checking every call only finds the error of that call if the callback is made
+      // before the call returns. Otherwise, the driver does not have to wait for it.
+      if (errorChecking == perCallErrorChecking) {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+      }
+      // Anything reported before the callback was set up is still queried once
+      checkForOpenGLErrors("setting up the debug output", false);
+      LOGINFO("OpenGL errors are reported through the debug output");
+    }
+  }
+
   void Renderer::init(const int width, const int height, const bool fullScreen, const string &windowTitle,
                       const float &frustumScale, const float &zNear,
                       const float &zFar, const float &zOffsetFromCamera,
                       const string &shadersPath) {
-    this->initSDL(width, height, fullScreen, windowTitle);
+    initialise(width, height, fullScreen, windowTitle, frustumScale, zNear, zFar, zOffsetFromCamera,
+               shadersPath, false);
+  }
+
+  void Renderer::initHeadless(const int width, const int height, const float &frustumScale,
+                              const float &zNear, const float &zFar, const float &zOffsetFromCamera,
+                              const string &shadersPath) {
+    initialise(width, height, false, "", frustumScale, zNear, zFar, zOffsetFromCamera, shadersPath, true);
+  }
+
+  void Renderer::initialise(const int width, const int height, const bool fullScreen, const string &windowTitle,
+                            const float &frustumScale, const float &zNear, const float &zFar,
+                            const float &zOffsetFromCamera, const string &shadersPath, const bool &headless) {
+    initialisationStart = chrono::high_resolution_clock::now();
+    timeToFirstFrame = -1.0;
+
+    this->initSDL(width, height, fullScreen, windowTitle, headless);
 
     this->frustumScale = frustumScale;
     this->zNear = zNear;
     this->zFar = zFar;
     this->zOffsetFromCamera = zOffsetFromCamera;
+    this->frameWidth = width;
+    this->frameHeight = height;
 
     this->detectOpenGLVersion();
 
+    enableDebugOutput();
+
+    if (headless) {
+      createOffscreenFramebuffer(width, height);
+    }
+
     string vertexShaderPath;
     string fragmentShaderPath;
     string simpleVertexShaderPath;
@@ -251,49 +663,70 @@ namespace small3d {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    GLuint vertexShader = compileShader(vertexShaderPath,
-                                        GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentShaderPath,
-                                          GL_FRAGMENT_SHADER);
-
-    perspectiveProgram = glCreateProgram();
-    glAttachShader(perspectiveProgram, vertexShader);
-    glAttachShader(perspectiveProgram, fragmentShader);
-
-    glLinkProgram(perspectiveProgram);
-
-    GLint status;
-    glGetProgramiv(perspectiveProgram, GL_LINK_STATUS, &status);
-    if (status == GL_FALSE) {
-      throw Exception("Failed to link program:\n" + this->getProgramInfoLog(perspectiveProgram));
+    // Core in OpenGL 4.1, an extension before that
+    programBinaryFormats.clear();
+    numProgramsLoadedFromCache = 0;
+    if (glewIsSupported("GL_VERSION_4_1") || GLEW_ARB_get_program_binary) {
+      GLint numProgramBinaryFormats = 0;
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numProgramBinaryFormats);
+      if (numProgramBinaryFormats > 0) {
+        programBinaryFormats.resize(static_cast<size_t>(numProgramBinaryFormats));
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, programBinaryFormats.data());
+      }
     }
-    else {
-      LOGINFO("Linked main rendering program successfully");
 
-      glUseProgram(perspectiveProgram);
+    // The OpenGL 2.1 shaders cannot declare the attribute locations, which have
+    // to be fixed so that the next frame's positions and normals can be bound
+    vector<pair<GLuint, string> > perspectiveAttributes;
+    perspectiveAttributes.push_back(make_pair(0, "position"));
+    perspectiveAttributes.push_back(make_pair(1, "normal"));
+    perspectiveAttributes.push_back(make_pair(2, "uvCoords"));
+    perspectiveAttributes.push_back(make_pair(3, "nextPosition"));
+    perspectiveAttributes.push_back(make_pair(4, "nextNormal"));
+    perspectiveAttributes.push_back(make_pair(MODEL_MATRIX_ATTRIBUTE, "modelMatrix"));
+    perspectiveAttributes.push_back(make_pair(NORMAL_MATRIX_ATTRIBUTE, "normalMatrix"));
+    perspectiveAttributes.push_back(make_pair(COLOUR_ATTRIBUTE, "colour"));
+
+    perspectiveProgram = createProgram("perspective", vertexShaderPath, fragmentShaderPath,
+                                       perspectiveAttributes);
+    glUseProgram(perspectiveProgram);
+
+    // Perspective (combined with the camera's view transformation when rendering)
 
-      // Perspective
+    perspectiveMatrix = glm::mat4(0.0f);
+    perspectiveMatrix[0][0] = frustumScale;
+    perspectiveMatrix[1][1] = frustumScale * ROUND_2_DECIMAL(width / height);
+    perspectiveMatrix[2][2] = (zNear + zFar) / (zNear - zFar);
+    perspectiveMatrix[3][2] = 2.0f * zNear * zFar / (zNear - zFar);
+    perspectiveMatrix[2][3] = zOffsetFromCamera;
 
-      GLint perspectiveMatrixUniform = glGetUniformLocation(perspectiveProgram,
-                                                            "perspectiveMatrix");
+    // Uniform locations, so that they do not have to be looked up by name when rendering
 
-      float perspectiveMatrix[16];
-      memset(perspectiveMatrix, 0, sizeof(float) * 16);
-      perspectiveMatrix[0] = frustumScale;
-      perspectiveMatrix[5] = frustumScale * ROUND_2_DECIMAL(width / height);
-      perspectiveMatrix[10] = (zNear + zFar) / (zNear - zFar);
-      perspectiveMatrix[14] = 2.0f * zNear * zFar / (zNear - zFar);
-      perspectiveMatrix[11] = zOffsetFromCamera;
+    perspectiveUniforms.frameBlend = glGetUniformLocation(perspectiveProgram, "frameBlend");
+    perspectiveUniforms.viewProjectionMatrix = glGetUniformLocation(perspectiveProgram,
+                                                                    "viewProjectionMatrix");
+    perspectiveUniforms.lightDirection = glGetUniformLocation(perspectiveProgram, "lightDirection");
+    perspectiveUniforms.lightIntensity = glGetUniformLocation(perspectiveProgram, "lightIntensity");
 
-      glUniformMatrix4fv(perspectiveMatrixUniform, 1, GL_FALSE,
-                         perspectiveMatrix);
+    // The camera and lighting uniforms are in a block on OpenGL 3.3, uploaded
+    // to a uniform buffer once per frame
+    if (isOpenGL33Supported) {
+      GLuint frameUniformsIndex = glGetUniformBlockIndex(perspectiveProgram, "FrameUniforms");
+      if (frameUniformsIndex == GL_INVALID_INDEX) {
+        throw Exception("The perspective shaders do not declare the FrameUniforms block.");
+      }
+      glUniformBlockBinding(perspectiveProgram, frameUniformsIndex, FRAME_UNIFORMS_BINDING);
 
-      glUseProgram(0);
+      glGenBuffers(1, &frameUniformBuffer);
+      glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+      glBufferData(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_SIZE * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUniformBuffer);
     }
-    glDetachShader(perspectiveProgram, vertexShader);
-    glDetachShader(perspectiveProgram, fragmentShader);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    frameUniformsUploaded = false;
+    viewProjectionCalculated = false;
+
+    glUseProgram(0);
 
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
@@ -304,25 +737,71 @@ namespace small3d {
 
     // Program (with shaders) for orthographic rendering for text
 
-    GLuint simpleVertexShader = compileShader(simpleVertexShaderPath,
-                                              GL_VERTEX_SHADER);
-    GLuint simpleFragmentShader = compileShader(simpleFragmentShaderPath,
-                                                GL_FRAGMENT_SHADER);
+    orthographicProgram = createProgram("orthographic", simpleVertexShaderPath, simpleFragmentShaderPath,
+                                        vector<pair<GLuint, string> >());
+    glUseProgram(0);
 
-    orthographicProgram = glCreateProgram();
-    glAttachShader(orthographicProgram, simpleVertexShader);
-    glAttachShader(orthographicProgram, simpleFragmentShader);
+    createImageBuffers();
 
-    glLinkProgram(orthographicProgram);
+    occlusionBuffer = OcclusionBuffer(OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_WIDTH * height / width);
+    occlusionBufferReady = false;
 
-    glGetProgramiv(orthographicProgram, GL_LINK_STATUS, &status);
-    if (status == GL_FALSE) {
-      throw Exception("Failed to link program:\n" + this->getProgramInfoLog(orthographicProgram));
+    // Core in OpenGL 3.3, an extension on 2.1
+    timerQueriesSupported = isOpenGL33Supported || GLEW_ARB_timer_query;
+    startFrameTimer();
+  }
+
+  void Renderer::createOffscreenFramebuffer(const int &width, const int &height) {
+    // Core in OpenGL 3.0, an extension on 2.1
+    if (!isOpenGL33Supported && !GLEW_ARB_framebuffer_object) {
+      throw Exception("Headless rendering needs framebuffer objects, which are not supported.");
     }
-    else {
-      LOGINFO("Linked text rendering program successfully");
+
+    glGenRenderbuffers(1, &offscreenColourBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenColourBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &offscreenDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Stays bound, so everything is rendered into it
+    glGenFramebuffers(1, &offscreenFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreenFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColourBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreenDepthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      throw Exception("The offscreen framebuffer could not be created.");
+    }
+
+    checkForOpenGLErrors("creating the offscreen framebuffer", true);
+    LOGINFO("Rendering headless, into an offscreen framebuffer");
+  }
+
+  bool Renderer::isHeadless() const {
+    return offscreenFramebuffer != 0;
+  }
+
+  void Renderer::readFrame(vector<unsigned char> &pixels, int &width, int &height) {
+    width = frameWidth;
+    height = frameHeight;
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    if (pixels.empty()) {
+      return;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    checkForOpenGLErrors("reading the frame", true);
+
+    // OpenGL returns the rows from the bottom up
+    size_t rowSize = static_cast<size_t>(width) * 4;
+    for (int row = 0; row < height / 2; ++row) {
+      swap_ranges(pixels.begin() + row * rowSize, pixels.begin() + (row + 1) * rowSize,
+                  pixels.begin() + (height - 1 - row) * rowSize);
     }
-    glUseProgram(0);
   }
 
   GLuint Renderer::generateTexture(const string &name, const float *texture, const int width, const int height) {
@@ -331,7 +810,7 @@ namespace small3d {
 
     glGenTextures(1, &textureHandle);
 
-    glBindTexture(GL_TEXTURE_2D, textureHandle);
+    bindTexture(textureHandle);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
@@ -339,6 +818,7 @@ namespace small3d {
 
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA,
                  GL_FLOAT, &texture[0]);
+    countUpload(static_cast<size_t>(width) * height * 4 * sizeof(float));
 
     textures->insert(make_pair(name, textureHandle));
 
@@ -349,6 +829,10 @@ namespace small3d {
     unordered_map<string, GLuint>::iterator nameTexturePair = textures->find(name);
 
     if (nameTexturePair != textures->end()) {
+      // Deleting a bound texture unbinds it
+      if (nameTexturePair->second == boundTexture) {
+        boundTexture = 0;
+      }
       glDeleteTextures(1, &(nameTexturePair->second));
       textures->erase(name);
     }
@@ -366,92 +850,114 @@ namespace small3d {
     return handle;
   }
 
-  void Renderer::positionSceneObject(const glm::vec3 &offset, const glm::vec3 &rotation) {
-    // Rotation
+  // Write the model matrix and normal matrix of an object at the given offset and
+  // rotation, in the layout of the vertex attributes (INSTANCE_SIZE - 4 floats)
+  // Rotation, followed by the offset
+  static glm::mat4 composeModelMatrix(const glm::vec3 &offset, const glm::vec3 &rotation) {
+    glm::mat4 modelMatrix = rotate(rotation);
+    modelMatrix[3] = glm::vec4(offset, 1.0f);
+    return modelMatrix;
+  }
+
+  static void writeTransformation(float *transformation, const glm::vec3 &offset, const glm::vec3 &rotation) {
+    glm::mat4 modelMatrix = composeModelMatrix(offset, rotation);
+
+    // Normals are only rotated, but the inverse transpose keeps them perpendicular
+    // to the surface even if the model matrix ever includes scaling
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
 
-    GLint xRotationMatrixUniform = glGetUniformLocation(perspectiveProgram,
-                                                         "xRotationMatrix");
-    GLint yRotationMatrixUniform = glGetUniformLocation(perspectiveProgram,
-                                                         "yRotationMatrix");
-    GLint zRotationMatrixUniform = glGetUniformLocation(perspectiveProgram,
-                                                         "zRotationMatrix");
+    memcpy(transformation, glm::value_ptr(modelMatrix), 16 * sizeof(float));
+    memcpy(transformation + 16, glm::value_ptr(normalMatrix), 9 * sizeof(float));
+  }
 
-    glUniformMatrix4fv(xRotationMatrixUniform, 1, GL_TRUE, glm::value_ptr(rotateX(rotation.x)));
-    glUniformMatrix4fv(yRotationMatrixUniform, 1, GL_TRUE, glm::value_ptr(rotateY(rotation.y)));
-    glUniformMatrix4fv(zRotationMatrixUniform, 1, GL_TRUE, glm::value_ptr(rotateZ(rotation.z)));
+  void Renderer::positionSceneObject(const glm::vec3 &offset, const glm::vec3 &rotation) {
+    // The attribute arrays are disabled when not drawing instances, so the
+    // attributes take these values for every vertex
+    float transformation[INSTANCE_SIZE - 4];
+    writeTransformation(transformation, offset, rotation);
 
-    GLint offsetUniform = glGetUniformLocation(perspectiveProgram, "offset");
-    glUniform3fv(offsetUniform, 1, glm::value_ptr(offset));
+    for (GLuint column = 0; column != 4; ++column) {
+      glVertexAttrib4fv(MODEL_MATRIX_ATTRIBUTE + column, &transformation[4 * column]);
+    }
+    for (GLuint column = 0; column != 3; ++column) {
+      glVertexAttrib3fv(NORMAL_MATRIX_ATTRIBUTE + column, &transformation[16 + 3 * column]);
+    }
   }
 
 
   void Renderer::positionCamera() {
-    // Camera rotation
+    useProgram(perspectiveProgram);
+    frameUniformsUploaded = false;
+    updateFrameUniforms();
+  }
+
+  void Renderer::updateViewProjection() {
+    if (viewProjectionCalculated && viewCameraPosition == cameraPosition &&
+        viewCameraRotation == cameraRotation) {
+      return;
+    }
 
-    GLint xCameraRotationMatrixUniform = glGetUniformLocation(perspectiveProgram,
-                                                               "xCameraRotationMatrix");
-    GLint yCameraRotationMatrixUniform = glGetUniformLocation(perspectiveProgram,
-                                                               "yCameraRotationMatrix");
-    GLint zCameraRotationMatrixUniform = glGetUniformLocation(perspectiveProgram,
-                                                               "zCameraRotationMatrix");
+    // The camera's view transformation: the inverse of its position, followed by
+    // the inverse of its rotation (around the Y axis first, then X, then Z)
+    glm::mat4 cameraTranslation;
+    cameraTranslation[3] = glm::vec4(-cameraPosition, 1.0f);
 
-    glUniformMatrix4fv(xCameraRotationMatrixUniform, 1, GL_TRUE, glm::value_ptr(rotateX(-cameraRotation.x)));
-    glUniformMatrix4fv(yCameraRotationMatrixUniform, 1, GL_TRUE, glm::value_ptr(rotateY(-cameraRotation.y)));
-    glUniformMatrix4fv(zCameraRotationMatrixUniform, 1, GL_TRUE, glm::value_ptr(rotateZ(-cameraRotation.z)));
+    viewProjectionMatrix = perspectiveMatrix * rotateZ(-cameraRotation.z) * rotateX(-cameraRotation.x) *
+                           rotateY(-cameraRotation.y) * cameraTranslation;
 
-    // Camera position
+    frustum = Frustum(viewProjectionMatrix);
+    occlusionBufferReady = false;
 
-    GLint cameraPositionUniform = glGetUniformLocation(perspectiveProgram, "cameraPosition");
-    glUniform3fv(cameraPositionUniform, 1, glm::value_ptr(cameraPosition));
+    viewCameraPosition = cameraPosition;
+    viewCameraRotation = cameraRotation;
+    viewProjectionCalculated = true;
   }
 
+  void Renderer::updateFrameUniforms() {
+    if (frameUniformsUploaded && uploadedCameraPosition == cameraPosition &&
+        uploadedCameraRotation == cameraRotation && uploadedLightDirection == lightDirection &&
+        uploadedLightIntensity == lightIntensity) {
+      return;
+    }
 
-  void Renderer::renderImage(const float *vertices, const string &textureName, const bool &perspective,
-                             const glm::vec3 &offset) {
-
-    glUseProgram(perspective ? perspectiveProgram : orthographicProgram);
+    updateViewProjection();
 
-    GLuint vao = 0;
     if (isOpenGL33Supported) {
-      // Generate VAO
-      glGenVertexArrays(1, &vao);
-      glBindVertexArray(vao);
+      // The layout of the FrameUniforms block (std140)
+      float frameUniforms[FRAME_UNIFORMS_SIZE];
+      memcpy(&frameUniforms[0], glm::value_ptr(viewProjectionMatrix), 16 * sizeof(float));
+      memcpy(&frameUniforms[16], glm::value_ptr(lightDirection), 3 * sizeof(float));
+      frameUniforms[19] = lightIntensity;
+
+      glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frameUniforms), frameUniforms);
+      countUpload(sizeof(frameUniforms));
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
+    else {
+      glUniformMatrix4fv(perspectiveUniforms.viewProjectionMatrix, 1, GL_FALSE,
+                         glm::value_ptr(viewProjectionMatrix));
 
-    glEnableVertexAttribArray(0);
+      // Lighting
+      glUniform3fv(perspectiveUniforms.lightDirection, 1, glm::value_ptr(lightDirection));
+      glUniform1f(perspectiveUniforms.lightIntensity, lightIntensity);
+    }
 
-    GLuint boxBuffer = 0;
-    glGenBuffers(1, &boxBuffer);
+    uploadedCameraPosition = cameraPosition;
+    uploadedCameraRotation = cameraRotation;
+    uploadedLightDirection = lightDirection;
+    uploadedLightIntensity = lightIntensity;
+    frameUniformsUploaded = true;
+  }
 
-    glBindBuffer(GL_ARRAY_BUFFER, boxBuffer);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * 16,
-                 vertices,
-                 GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+  void Renderer::createImageBuffers() {
     unsigned int vertexIndices[6] =
         {
             0, 1, 2,
             2, 3, 0
         };
 
-    GLuint indexBufferObject = 0;
-
-    glGenBuffers(1, &indexBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 sizeof(unsigned int) * 6, vertexIndices, GL_STATIC_DRAW);
-
-    GLuint textureHandle = getTextureHandle(textureName);
-
-    if (textureHandle == 0) {
-      throw Exception("Texture " + textureName + "has not been generated");
-    }
-
-    glBindTexture(GL_TEXTURE_2D, textureHandle);
-
     float textureCoords[8] =
         {
             0.0f, 1.0f,
@@ -460,192 +966,1071 @@ namespace small3d {
             0.0f, 0.0f
         };
 
-    GLuint coordBuffer = 0;
+    // The vertices are replaced for every image
+    glGenBuffers(1, &imageVertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, imageVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 16, NULL, GL_STREAM_DRAW);
 
-    glGenBuffers(1, &coordBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * 8,
-                 textureCoords,
-                 GL_STATIC_DRAW);
-    glEnableVertexAttribArray(perspective ? 2 : 1);
-    glVertexAttribPointer(perspective ? 2 : 1, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glGenBuffers(1, &imageIndexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, imageIndexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(unsigned int) * 6, vertexIndices, GL_STATIC_DRAW);
 
-    if (perspective) {
-      // Find the colour uniform
-      GLint colourUniform = glGetUniformLocation(perspectiveProgram, "colour");
+    glGenBuffers(1, &imageUvBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, imageUvBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 8, textureCoords, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-      // "Disable" colour since there is a texture
-      glUniform4fv(colourUniform, 1, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)));
+    // The texture coordinates are at a different location in each program
+    if (isOpenGL33Supported) {
+      GLuint *vaos[2] = {&orthographicImageVao, &perspectiveImageVao};
+      for (int perspective = 0; perspective != 2; ++perspective) {
+        glGenVertexArrays(1, vaos[perspective]);
+        bindVertexArray(*vaos[perspective]);
 
-      // Lighting
-      GLint lightDirectionUniform = glGetUniformLocation(perspectiveProgram,
-                                                          "lightDirection");
-      glUniform3fv(lightDirectionUniform, 1,
-                   glm::value_ptr(lightDirection));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, imageIndexBuffer);
 
-      GLint lightIntensityUniform = glGetUniformLocation(perspectiveProgram, "lightIntensity");
-      glUniform1f(lightIntensityUniform, lightIntensity);
+        glBindBuffer(GL_ARRAY_BUFFER, imageVertexBuffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
 
-      positionSceneObject(offset, glm::vec3(0.0f, 0.0f, 0.0f));
-      positionCamera();
+        glBindBuffer(GL_ARRAY_BUFFER, imageUvBuffer);
+        glEnableVertexAttribArray(perspective == 1 ? 2 : 1);
+        glVertexAttribPointer(perspective == 1 ? 2 : 1, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+      }
+      bindVertexArray(0);
     }
 
-    glDrawElements(GL_TRIANGLES,
-                   6, GL_UNSIGNED_INT, 0);
-
-    glDeleteBuffers(1, &indexBufferObject);
-    glDeleteBuffers(1, &boxBuffer);
-    glDeleteBuffers(1, &coordBuffer);
+    checkForOpenGLErrors("creating the image buffers", true);
+  }
 
+  void Renderer::renderImage(const float *vertices, const string &textureName, const bool &perspective,
+                             const glm::vec3 &offset) {
 
-    glDisableVertexAttribArray(perspective ? 2 : 1);
-    glDisableVertexAttribArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLuint textureHandle = getTextureHandle(textureName);
 
-    if (isOpenGL33Supported) {
-      glDeleteVertexArrays(1, &vao);
-      glBindVertexArray(0);
+    if (textureHandle == 0) {
+      throw Exception("Texture " + textureName + "has not been generated");
     }
 
-    checkForOpenGLErrors("rendering image", true);
-  }
+    useProgram(perspective ? perspectiveProgram : orthographicProgram);
 
-  void Renderer::renderSceneObject(shared_ptr<SceneObject> sceneObject) {
-    // Use the shaders prepared at initialisation
-    glUseProgram(perspectiveProgram);
+    // A new data store for the vertices, so that the driver does not have to
+    // wait for the previous image using the buffer to be drawn
+    glBindBuffer(GL_ARRAY_BUFFER, imageVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER,
+                 sizeof(float) * 16,
+                 vertices,
+                 GL_STREAM_DRAW);
+    countUpload(sizeof(float) * 16);
 
-    GLuint vao = 0;
     if (isOpenGL33Supported) {
-      // Generate VAO
-      glGenVertexArrays(1, &vao);
-      glBindVertexArray(vao);
+      bindVertexArray(perspective ? perspectiveImageVao : orthographicImageVao);
     }
+    else {
+      glEnableVertexAttribArray(0);
+      glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
 
-    GLuint positionBufferObject = 0;
-    GLuint indexBufferObject = 0;
-    GLuint normalsBufferObject = 0;
-    GLuint texture = 0;
-    GLuint uvBufferObject = 0;
+      glBindBuffer(GL_ARRAY_BUFFER, imageUvBuffer);
+      glEnableVertexAttribArray(perspective ? 2 : 1);
+      glVertexAttribPointer(perspective ? 2 : 1, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
-    // Pass the vertex positions to the shaders
-    glGenBuffers(1, &positionBufferObject);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, imageIndexBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, positionBufferObject);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sceneObject->getModel().vertexDataSize,
-                 sceneObject->getModel().vertexData.data(),
-                 GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    bindTexture(textureHandle);
+
+    if (perspective) {
+      // "Disable" colour since there is a texture
+      glVertexAttrib4fv(COLOUR_ATTRIBUTE, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)));
 
-    // Pass vertex indexes
+      // The quad has no normals of its own, so the normal of its face is used for
+      // all of its vertices, for lighting
+      glm::vec3 corners[3];
+      for (int corner = 0; corner != 3; ++corner) {
+        corners[corner] = glm::vec3(vertices[4 * corner], vertices[4 * corner + 1], vertices[4 * corner + 2]);
+      }
+      glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+      glVertexAttrib3fv(1, glm::value_ptr(glm::length(normal) > 0.0f ? glm::normalize(normal) :
+                                          glm::vec3(0.0f, 1.0f, 0.0f)));
 
-    glGenBuffers(1, &indexBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 sceneObject->getModel().indexDataSize,
-                 sceneObject->getModel().indexData.data(),
-                 GL_STATIC_DRAW);
+      glUniform1f(perspectiveUniforms.frameBlend, 0.0f);
 
-    // Normals
-    glGenBuffers(1, &normalsBufferObject);
-    glBindBuffer(GL_ARRAY_BUFFER, normalsBufferObject);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sceneObject->getModel().normalsDataSize,
-                 sceneObject->getModel().normalsData.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+      positionSceneObject(offset, glm::vec3(0.0f, 0.0f, 0.0f));
+      updateFrameUniforms();
+    }
 
-    // Find the colour uniform
-    GLint colourUniform = glGetUniformLocation(perspectiveProgram, "colour");
+    glDrawElements(GL_TRIANGLES,
+                   6, GL_UNSIGNED_INT, 0);
+    countDraw(6);
 
-    // Add texture if that is contained in the model
-    shared_ptr<Image> textureObj = sceneObject->getTexture();
+    if (!isOpenGL33Supported) {
+      glDisableVertexAttribArray(perspective ? 2 : 1);
+      glDisableVertexAttribArray(0);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
 
-    if (textureObj) {
-      // "Disable" colour since there is a texture
-      glUniform4fv(colourUniform, 1, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)));
+    checkForRenderingErrors("rendering image", true);
+  }
 
-      texture = this->getTextureHandle(sceneObject->getName());
+  Renderer::ModelBuffers& Renderer::getModelBuffers(const shared_ptr<const Model> &model,
+                                                    const shared_ptr<const FrameAnimation> &frameAnimation,
+                                                    const int &frame) {
+    // Use the compact vertex format, if the model has been quantised. Packed normals and
+    // half float attributes are not part of OpenGL 2.1, so the full data is used there.
+    bool compactFormat = isOpenGL33Supported && model->isQuantised();
 
-      if (texture == 0) {
-        texture = generateTexture(sceneObject->getName(), textureObj->getData(), textureObj->getWidth(),
-                                  textureObj->getHeight());
+    unordered_map<const Model*, ModelBuffers>::iterator buffersIt = modelBuffers.find(model.get());
+
+    // A destroyed model, whose address has been reused by this one
+    if (buffersIt != modelBuffers.end() && buffersIt->second.model.expired()) {
+      deleteModelBuffers(buffersIt->second);
+      modelBuffers.erase(buffersIt);
+      buffersIt = modelBuffers.end();
+    }
+
+    if (buffersIt == modelBuffers.end()) {
+      ModelBuffers buffers;
+      buffers.model = model;
+      buffers.vao = 0;
+      buffers.uvBuffer = 0;
+      buffers.boundFrame = -1;
+      buffers.boundNextFrame = -1;
+
+      if (isOpenGL33Supported) {
+        glGenVertexArrays(1, &buffers.vao);
+      }
+
+      // Vertex indexes, of all the levels of detail. They are uploaded through the
+      // array buffer binding, since the element array buffer binding belongs to the
+      // vertex array object, which is only bound when drawing. With fewer than 65536
+      // vertices, they are uploaded as 16-bit ones, halving the memory and bandwidth
+      // they take up on the GPU.
+      bool shortIndices = model->vertexData.size() / 4 < 65536;
+      size_t indexWidth = shortIndices ? sizeof(unsigned short) : sizeof(unsigned int);
+      buffers.indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+      size_t numLevelsOfDetail = model->getNumLevelsOfDetail();
+      size_t indexDataSize = 0;
+      for (size_t level = 0; level != numLevelsOfDetail; ++level) {
+        buffers.indexOffsets.push_back(indexDataSize);
+        indexDataSize += model->getNumIndexes(level) * indexWidth;
       }
 
-      glBindTexture(GL_TEXTURE_2D, texture);
+      glGenBuffers(1, &buffers.indexBuffer);
+      glBindBuffer(GL_ARRAY_BUFFER, buffers.indexBuffer);
+      glBufferData(GL_ARRAY_BUFFER, indexDataSize, NULL, GL_STATIC_DRAW);
+      vector<unsigned short> shortIndexData;
+      for (size_t level = 0; level != numLevelsOfDetail; ++level) {
+        const vector<unsigned int> &levelIndexData = model->getIndexData(level);
+        const void *indexData = levelIndexData.data();
+        if (shortIndices) {
+          shortIndexData.assign(levelIndexData.begin(), levelIndexData.end());
+          indexData = shortIndexData.data();
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, buffers.indexOffsets[level],
+                        model->getNumIndexes(level) * indexWidth, indexData);
+      }
+      countUpload(indexDataSize);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
 
       // UV Coordinates
+      if (!model->textureCoordsData.empty()) {
+        glGenBuffers(1, &buffers.uvBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers.uvBuffer);
+        if (compactFormat) {
+          glBufferData(GL_ARRAY_BUFFER,
+                       model->halfTextureCoordsData.size() * sizeof(unsigned short),
+                       model->halfTextureCoordsData.data(), GL_STATIC_DRAW);
+          countUpload(model->halfTextureCoordsData.size() * sizeof(unsigned short));
+        }
+        else {
+          glBufferData(GL_ARRAY_BUFFER,
+                       model->textureCoordsData.size() * sizeof(float),
+                       model->textureCoordsData.data(), GL_STATIC_DRAW);
+          countUpload(model->textureCoordsData.size() * sizeof(float));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+      }
 
-      glGenBuffers(1, &uvBufferObject);
-      glBindBuffer(GL_ARRAY_BUFFER, uvBufferObject);
-      glBufferData(GL_ARRAY_BUFFER,
-                   sceneObject->getModel().textureCoordsDataSize,
-                   sceneObject->getModel().textureCoordsData.data(), GL_STATIC_DRAW);
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      size_t numFrames = frameAnimation ? static_cast<size_t>(frameAnimation->getNumFrames()) : 1;
+      buffers.positionBuffers.assign(numFrames, 0);
+      buffers.normalsBuffers.assign(numFrames, 0);
 
-    }
-    else {
-      // If there is no texture, use the colour of the object
-      glUniform4fv(colourUniform, 1, glm::value_ptr(*sceneObject->getColour()));
+      buffersIt = modelBuffers.insert(make_pair(model.get(), buffers)).first;
     }
 
-    // Lighting
-    GLint lightDirectionUniform = glGetUniformLocation(perspectiveProgram,
-                                                        "lightDirection");
-    glUniform3fv(lightDirectionUniform, 1,
-                 glm::value_ptr(lightDirection));
+    ModelBuffers &buffers = buffersIt->second;
 
-    GLint lightIntensityUniform = glGetUniformLocation(perspectiveProgram, "lightIntensity");
-    glUniform1f(lightIntensityUniform, lightIntensity);
+    // The positions and normals of the frame
+    size_t frameBuffer = frameAnimation ? static_cast<size_t>(frame) : 0;
 
-    positionSceneObject(*sceneObject->getOffset(), *sceneObject->getRotation());
+    if (buffers.positionBuffers[frameBuffer] == 0) {
+      // The frames of quantised animations are only kept in the compact format, so
+      // they are decoded when that cannot be used
+      vector<float> frameVertexData, frameNormalsData;
+      if (frameAnimation && !compactFormat) {
+        frameAnimation->getFrameData(frame, frameVertexData, frameNormalsData);
+      }
 
-    positionCamera();
+      glGenBuffers(1, &buffers.positionBuffers[frameBuffer]);
+      glBindBuffer(GL_ARRAY_BUFFER, buffers.positionBuffers[frameBuffer]);
+      if (compactFormat) {
+        const vector<float> &compactVertexData = frameAnimation ?
+            frameAnimation->getCompactVertexData(frame) : model->compactVertexData;
+        glBufferData(GL_ARRAY_BUFFER, compactVertexData.size() * sizeof(float),
+                     compactVertexData.data(), GL_STATIC_DRAW);
+        countUpload(compactVertexData.size() * sizeof(float));
+      }
+      else {
+        const vector<float> &vertexData = frameAnimation ? frameVertexData : model->vertexData;
+        glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float),
+                     vertexData.data(), GL_STATIC_DRAW);
+        countUpload(vertexData.size() * sizeof(float));
+      }
 
-    // Throw an exception if there was an error in OpenGL, during
+      glGenBuffers(1, &buffers.normalsBuffers[frameBuffer]);
+      glBindBuffer(GL_ARRAY_BUFFER, buffers.normalsBuffers[frameBuffer]);
+      if (compactFormat) {
+        const vector<unsigned int> &packedNormalsData = frameAnimation ?
+            frameAnimation->getPackedNormalsData(frame) : model->packedNormalsData;
+        glBufferData(GL_ARRAY_BUFFER, packedNormalsData.size() * sizeof(unsigned int),
+                     packedNormalsData.data(), GL_STATIC_DRAW);
+        countUpload(packedNormalsData.size() * sizeof(unsigned int));
+      }
+      else {
+        const vector<float> &normalsData = frameAnimation ? frameNormalsData : model->normalsData;
+        glBufferData(GL_ARRAY_BUFFER, normalsData.size() * sizeof(float),
+                     normalsData.data(), GL_STATIC_DRAW);
+        countUpload(normalsData.size() * sizeof(float));
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+      checkForRenderingErrors("uploading model data", true);
+    }
+
+    return buffers;
+  }
+
+  void Renderer::bindModelBuffers(ModelBuffers &buffers, const bool &compactFormat,
+                                  const int &frame, const int &nextFrame) {
+    size_t frameBuffer = buffers.positionBuffers.size() > 1 ? static_cast<size_t>(frame) : 0;
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+
+    // The missing fourth component of the compact positions defaults to 1.0
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.positionBuffers[frameBuffer]);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, compactFormat ? 3 : 4, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.normalsBuffers[frameBuffer]);
+    glEnableVertexAttribArray(1);
+    if (compactFormat) {
+      glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 0, (void *) 0);
+    }
+    else {
+      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+    }
+
+    if (buffers.uvBuffer != 0) {
+      glBindBuffer(GL_ARRAY_BUFFER, buffers.uvBuffer);
+      glEnableVertexAttribArray(2);
+      glVertexAttribPointer(2, 2, compactFormat ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, 0, 0);
+    }
+
+    // The positions and normals of the next frame, with which the shaders blend those
+    // of the current one. When not blending, the attributes are left disabled and the
+    // shaders ignore their constant values.
+    if (nextFrame >= 0) {
+      glBindBuffer(GL_ARRAY_BUFFER, buffers.positionBuffers[static_cast<size_t>(nextFrame)]);
+      glEnableVertexAttribArray(3);
+      glVertexAttribPointer(3, compactFormat ? 3 : 4, GL_FLOAT, GL_FALSE, 0, 0);
+
+      glBindBuffer(GL_ARRAY_BUFFER, buffers.normalsBuffers[static_cast<size_t>(nextFrame)]);
+      glEnableVertexAttribArray(4);
+      if (compactFormat) {
+        glVertexAttribPointer(4, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 0, (void *) 0);
+      }
+      else {
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+      }
+    }
+    else {
+      glDisableVertexAttribArray(3);
+      glDisableVertexAttribArray(4);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    buffers.boundFrame = frame;
+    buffers.boundNextFrame = nextFrame;
+  }
+
+  void Renderer::deleteModelBuffers(ModelBuffers &buffers) {
+    if (buffers.vao != 0) {
+      // Deleting a bound vertex array object unbinds it
+      if (buffers.vao == boundVertexArray) {
+        boundVertexArray = 0;
+      }
+      glDeleteVertexArrays(1, &buffers.vao);
+    }
+
+    glDeleteBuffers(1, &buffers.indexBuffer);
+
+    if (buffers.uvBuffer != 0) {
+      glDeleteBuffers(1, &buffers.uvBuffer);
+    }
+
+    for (size_t frame = 0; frame != buffers.positionBuffers.size(); ++frame) {
+      if (buffers.positionBuffers[frame] != 0) {
+        glDeleteBuffers(1, &buffers.positionBuffers[frame]);
+        glDeleteBuffers(1, &buffers.normalsBuffers[frame]);
+      }
+    }
+  }
+
+  size_t Renderer::getLevelOfDetail(const Model &model, const glm::vec3 &offset) const {
+    size_t levelOfDetail = 0;
+    float distance = glm::distance(offset, cameraPosition);
+    while (levelOfDetail < levelOfDetailDistances.size() &&
+           levelOfDetail + 1 < model.getNumLevelsOfDetail() &&
+           distance > levelOfDetailDistances[levelOfDetail]) {
+      ++levelOfDetail;
+    }
+    return levelOfDetail;
+  }
+
+  // The bounding sphere of a model, placed in the world: only its centre moves
+  static glm::vec3 worldSphereCentre(const Model &model, const glm::mat3 &rotationMatrix, const glm::vec3 &offset) {
+    return offset + rotationMatrix * model.boundingSphereCentre;
+  }
+
+  // The bounding box of a model, placed in the world, is tested as the (larger) box
+  // aligned to the world's axes which contains it
+  static bool isBoxInFrustum(const Frustum &frustum, const Model &model, const glm::mat3 &rotationMatrix,
+                             const glm::vec3 &offset) {
+    glm::vec3 centre = offset + rotationMatrix * ((model.boundingBoxMin + model.boundingBoxMax) * 0.5f);
+    glm::vec3 halfExtents = (model.boundingBoxMax - model.boundingBoxMin) * 0.5f;
+    glm::vec3 worldHalfExtents(0.0f);
+    for (int column = 0; column != 3; ++column) {
+      for (int row = 0; row != 3; ++row) {
+        worldHalfExtents[row] += fabs(rotationMatrix[column][row]) * halfExtents[column];
+      }
+    }
+    return frustum.containsBox(centre, worldHalfExtents);
+  }
+
+  bool Renderer::isInFrustum(const Model &model, const glm::vec3 &offset, const glm::vec3 &rotation) {
+    if (!frustumCulling || model.boundingSphereRadius < 0.0f) {
+      return true;
+    }
+
+    updateViewProjection();
+
+    glm::mat3 rotationMatrix(rotate(rotation));
+
+    if (!frustum.containsSphere(worldSphereCentre(model, rotationMatrix, offset), model.boundingSphereRadius)) {
+      return false;
+    }
+
+    return isBoxInFrustum(frustum, model, rotationMatrix, offset);
+  }
+
+  size_t Renderer::cullObjects(const vector<const Model*> &models, const vector<glm::vec3> &offsets,
+                               const vector<glm::vec3> &rotations, vector<unsigned char> &visible) {
+    size_t numObjects = models.size();
+    visible.assign(numObjects, 1);
+
+    if (!frustumCulling) {
+      return numObjects;
+    }
+
+    updateViewProjection();
+
+    // One array per component, for Frustum::cullSpheres
+    vector<float> centreX(numObjects), centreY(numObjects), centreZ(numObjects), radii(numObjects);
+    vector<glm::mat3> rotationMatrices(numObjects);
+    for (size_t object = 0; object != numObjects; ++object) {
+      rotationMatrices[object] = glm::mat3(rotate(rotations[object]));
+      glm::vec3 centre = worldSphereCentre(*models[object], rotationMatrices[object], offsets[object]);
+      centreX[object] = centre.x;
+      centreY[object] = centre.y;
+      centreZ[object] = centre.z;
+      // Models whose bounding volumes have not been calculated are never culled
+      radii[object] = models[object]->boundingSphereRadius < 0.0f ? numeric_limits<float>::infinity() :
+                      models[object]->boundingSphereRadius;
+    }
+
+    frustum.cullSpheres(centreX.data(), centreY.data(), centreZ.data(), radii.data(), numObjects, visible.data());
+
+    size_t numVisible = 0;
+    for (size_t object = 0; object != numObjects; ++object) {
+      if (visible[object] && models[object]->boundingSphereRadius >= 0.0f &&
+          !isBoxInFrustum(frustum, *models[object], rotationMatrices[object], offsets[object])) {
+        visible[object] = 0;
+      }
+      numVisible += visible[object];
+    }
+    return numVisible;
+  }
+
+  void Renderer::prepareOcclusionBuffer() {
+    updateViewProjection();
+    if (occlusionBufferReady) {
+      return;
+    }
+
+    occlusionBuffer.clear(viewProjectionMatrix);
+    for (vector<Occluder>::iterator occluder = occluders.begin(); occluder != occluders.end(); ++occluder) {
+      const Model &model = occluder->model ? *occluder->model :
+                           *occluder->sceneObject->getFrameModel(occluder->sceneObject->getCurrentFrame());
+      occlusionBuffer.rasteriseOccluder(model, composeModelMatrix(*occluder->sceneObject->getOffset(),
+                                                                  *occluder->sceneObject->getRotation()));
+    }
+    frameStatistics.occluderTrianglesRasterised += occlusionBuffer.getNumTrianglesRasterised();
+    occlusionBufferReady = true;
+  }
+
+  bool Renderer::isOccluded(const Model &model, const glm::vec3 &offset, const glm::vec3 &rotation,
+                            const SceneObject *sceneObject) {
+    if (!occlusionCulling || occluders.empty() || model.boundingSphereRadius < 0.0f) {
+      return false;
+    }
+
+    for (vector<Occluder>::iterator occluder = occluders.begin(); occluder != occluders.end(); ++occluder) {
+      if (occluder->sceneObject.get() == sceneObject) {
+        return false;
+      }
+    }
+
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+    prepareOcclusionBuffer();
+    bool occluded = !occlusionBuffer.isBoxVisible(model.boundingBoxMin, model.boundingBoxMax,
+                                                  composeModelMatrix(offset, rotation));
+
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    frameStatistics.occlusionMilliseconds += elapsed.count();
+
+    return occluded;
+  }
+
+  void Renderer::addOccluder(shared_ptr<SceneObject> sceneObject, shared_ptr<const Model> occluderModel) {
+    removeOccluder(sceneObject);
+    Occluder occluder;
+    occluder.sceneObject = sceneObject;
+    occluder.model = occluderModel;
+    occluders.push_back(occluder);
+    occlusionBufferReady = false;
+  }
+
+  void Renderer::removeOccluder(shared_ptr<SceneObject> sceneObject) {
+    for (vector<Occluder>::iterator occluder = occluders.begin(); occluder != occluders.end(); ++occluder) {
+      if (occluder->sceneObject == sceneObject) {
+        occluders.erase(occluder);
+        occlusionBufferReady = false;
+        return;
+      }
+    }
+  }
+
+  void Renderer::prepareSceneObject(shared_ptr<SceneObject> sceneObject) {
+    shared_ptr<Image> textureObj = sceneObject->getTexture();
+
+    if (textureObj && this->getTextureHandle(sceneObject->getName()) == 0) {
+      generateTexture(sceneObject->getName(), textureObj->getData(), textureObj->getWidth(),
+                      textureObj->getHeight());
+    }
+
+    for (int frame = 0; frame != sceneObject->getNumFrames(); ++frame) {
+      getModelBuffers(sceneObject->getFrameModel(frame), sceneObject->getFrameAnimation(), frame);
+    }
+  }
+
+  void Renderer::releaseSceneObject(shared_ptr<SceneObject> sceneObject) {
+    for (int frame = 0; frame != sceneObject->getNumFrames(); ++frame) {
+      unordered_map<const Model*, ModelBuffers>::iterator buffersIt =
+          modelBuffers.find(sceneObject->getFrameModel(frame).get());
+      if (buffersIt != modelBuffers.end()) {
+        deleteModelBuffers(buffersIt->second);
+        modelBuffers.erase(buffersIt);
+      }
+    }
+  }
+
+  size_t Renderer::getNumResidentModels() const {
+    return modelBuffers.size();
+  }
+
+  void Renderer::renderSceneObject(shared_ptr<SceneObject> sceneObject) {
+    // The model of an animation contains all of its frames (see FrameAnimation)
+    const Model &model = *sceneObject->getFrameModel(sceneObject->getCurrentFrame());
+    if (!isInFrustum(model, *sceneObject->getOffset(), *sceneObject->getRotation())) {
+      ++frameStatistics.objectsCulled;
+      return;
+    }
+
+    if (isOccluded(model, *sceneObject->getOffset(), *sceneObject->getRotation(),
+                   sceneObject.get())) {
+      ++frameStatistics.objectsOccluded;
+      return;
+    }
+
+    drawSceneObject(sceneObject);
+  }
+
+  void Renderer::drawSceneObject(const shared_ptr<SceneObject> &sceneObject) {
+    // Use the shaders prepared at initialisation
+    useProgram(perspectiveProgram);
+
+    int frame = sceneObject->getCurrentFrame();
+    const Model &model = *sceneObject->getFrameModel(frame);
+    bool compactFormat = isOpenGL33Supported && model.isQuantised();
+
+    // Only frames that share their topology are blended, so the next frame's
+    // buffers belong to the same model as the current one's
+    float frameBlend = sceneObject->getFrameBlend();
+    int nextFrame = frameBlend > 0.0f ? sceneObject->getNextFrame() : -1;
+
+    ModelBuffers &buffers = getModelBuffers(sceneObject->getFrameModel(frame), sceneObject->getFrameAnimation(),
+                                            frame);
+    if (nextFrame >= 0) {
+      getModelBuffers(sceneObject->getFrameModel(nextFrame), sceneObject->getFrameAnimation(), nextFrame);
+    }
+
+    // Without a vertex array object (OpenGL 2.1), the attributes have to be set
+    // up for every draw. Otherwise, only when the frames have changed.
+    if (isOpenGL33Supported) {
+      bindVertexArray(buffers.vao);
+      if (buffers.boundFrame != frame || buffers.boundNextFrame != nextFrame) {
+        bindModelBuffers(buffers, compactFormat, frame, nextFrame);
+      }
+    }
+    else {
+      bindModelBuffers(buffers, compactFormat, frame, nextFrame);
+    }
+
+    // The level of detail corresponding to the object's distance from the camera
+    size_t levelOfDetail = getLevelOfDetail(model, *sceneObject->getOffset());
+
+    glUniform1f(perspectiveUniforms.frameBlend, frameBlend);
+
+    // Add texture if that is contained in the model
+    shared_ptr<Image> textureObj = sceneObject->getTexture();
+
+    if (textureObj) {
+      // "Disable" colour since there is a texture
+      glVertexAttrib4fv(COLOUR_ATTRIBUTE, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)));
+
+      GLuint texture = this->getTextureHandle(sceneObject->getName());
+
+      if (texture == 0) {
+        texture = generateTexture(sceneObject->getName(), textureObj->getData(), textureObj->getWidth(),
+                                  textureObj->getHeight());
+      }
+
+      bindTexture(texture);
+    }
+    else {
+      // If there is no texture, use the colour of the object
+      glVertexAttrib4fv(COLOUR_ATTRIBUTE, glm::value_ptr(*sceneObject->getColour()));
+    }
+
+    positionSceneObject(*sceneObject->getOffset(), *sceneObject->getRotation());
+
+    // Camera and lighting, if they have changed since the previous object
+    updateFrameUniforms();
+
+    // Throw an exception if there was an error in OpenGL, during
     // any of the above.
-    checkForOpenGLErrors("rendering scene", true);
+    checkForRenderingErrors("rendering scene", true);
 
     // Draw
     glDrawElements(GL_TRIANGLES,
-                   (GLsizei) sceneObject->getModel().indexData.size(),
-                   GL_UNSIGNED_INT, 0);
+                   (GLsizei) model.getNumIndexes(levelOfDetail), buffers.indexType,
+                   reinterpret_cast<void *>(buffers.indexOffsets[levelOfDetail]));
+    countDraw(model.getNumIndexes(levelOfDetail));
+
+    ++frameStatistics.objectsDrawn;
+
+    // The buffers are kept for the next frame and the program and vertex array object
+    // stay bound, in case the next object uses them too. Without a vertex array
+    // object, the attributes are cleared for the next object to set up its own.
+    if (!isOpenGL33Supported) {
+      if (buffers.uvBuffer != 0) {
+        glDisableVertexAttribArray(2);
+      }
 
-    // Clear stuff
-    if (textureObj) {
-      glDisableVertexAttribArray(2);
+      if (nextFrame >= 0) {
+        glDisableVertexAttribArray(3);
+        glDisableVertexAttribArray(4);
+      }
+
+      glDisableVertexAttribArray(1);
+      glDisableVertexAttribArray(0);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
-    if (positionBufferObject != 0) {
-      glDeleteBuffers(1, &positionBufferObject);
+  }
+
+  static vector<glm::vec3> offsetsOf(const vector<Instance> &instances) {
+    vector<glm::vec3> offsets(instances.size());
+    for (size_t instance = 0; instance != instances.size(); ++instance) {
+      offsets[instance] = instances[instance].offset;
+    }
+    return offsets;
+  }
+
+  static vector<glm::vec3> rotationsOf(const vector<Instance> &instances) {
+    vector<glm::vec3> rotations(instances.size());
+    for (size_t instance = 0; instance != instances.size(); ++instance) {
+      rotations[instance] = instances[instance].rotation;
+    }
+    return rotations;
+  }
+
+  void Renderer::renderInstances(const shared_ptr<const Model> &model, const vector<Instance> &instances,
+                                 const string &textureName) {
+    if (instances.empty()) {
+      return;
+    }
+
+    GLuint textureHandle = 0;
+    if (textureName != "") {
+      textureHandle = getTextureHandle(textureName);
+
+      if (textureHandle == 0) {
+        throw Exception("Texture " + textureName + " has not been generated");
+      }
+    }
+
+    vector<unsigned char> visible;
+    size_t numVisible = cullObjects(vector<const Model*>(instances.size(), model.get()),
+                                    offsetsOf(instances), rotationsOf(instances), visible);
+
+    frameStatistics.objectsCulled += static_cast<int>(instances.size() - numVisible);
+
+    for (size_t instance = 0; instance != instances.size(); ++instance) {
+      if (visible[instance] && isOccluded(*model, instances[instance].offset, instances[instance].rotation, NULL)) {
+        visible[instance] = 0;
+        --numVisible;
+        ++frameStatistics.objectsOccluded;
+      }
+    }
+
+    frameStatistics.objectsDrawn += static_cast<int>(numVisible);
+
+    if (numVisible == 0) {
+      return;
+    }
+
+    useProgram(perspectiveProgram);
+
+    bool compactFormat = isOpenGL33Supported && model->isQuantised();
+
+    ModelBuffers &buffers = getModelBuffers(model, shared_ptr<const FrameAnimation>(), 0);
+
+    if (isOpenGL33Supported) {
+      bindVertexArray(buffers.vao);
+      if (buffers.boundFrame != 0 || buffers.boundNextFrame != -1) {
+        bindModelBuffers(buffers, compactFormat, 0, -1);
+      }
+    }
+    else {
+      bindModelBuffers(buffers, compactFormat, 0, -1);
+    }
+
+    glUniform1f(perspectiveUniforms.frameBlend, 0.0f);
+
+    if (textureHandle != 0) {
+      bindTexture(textureHandle);
+    }
+
+    updateFrameUniforms();
+
+    // The visible instances, grouped by level of detail
+    size_t numLevelsOfDetail = model->getNumLevelsOfDetail();
+    vector<size_t> instanceLevels(instances.size());
+    vector<size_t> levelStarts(numLevelsOfDetail + 1, 0);
+    for (size_t instance = 0; instance != instances.size(); ++instance) {
+      if (!visible[instance]) continue;
+      instanceLevels[instance] = getLevelOfDetail(*model, instances[instance].offset);
+      ++levelStarts[instanceLevels[instance] + 1];
+    }
+    for (size_t level = 0; level != numLevelsOfDetail; ++level) {
+      levelStarts[level + 1] += levelStarts[level];
+    }
+
+    vector<float> instanceData(numVisible * INSTANCE_SIZE);
+    vector<size_t> levelEnds(levelStarts.begin(), levelStarts.end() - 1);
+    for (size_t instance = 0; instance != instances.size(); ++instance) {
+      if (!visible[instance]) continue;
+      float *data = &instanceData[INSTANCE_SIZE * levelEnds[instanceLevels[instance]]++];
+      writeTransformation(data, instances[instance].offset, instances[instance].rotation);
+      memcpy(data + INSTANCE_SIZE - 4, glm::value_ptr(instances[instance].colour), 4 * sizeof(float));
     }
 
-    if (indexBufferObject != 0) {
-      glDeleteBuffers(1, &indexBufferObject);
+    checkForRenderingErrors("rendering instances", true);
+
+    if (isOpenGL33Supported) {
+      if (instanceBuffer == 0) {
+        glGenBuffers(1, &instanceBuffer);
+      }
+
+      // A new data store every time, so that the driver does not have to wait
+      // for the previous draw using the buffer to finish
+      glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+      glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(float), instanceData.data(), GL_STREAM_DRAW);
+      countUpload(instanceData.size() * sizeof(float));
+
+      for (GLuint attribute = MODEL_MATRIX_ATTRIBUTE; attribute <= COLOUR_ATTRIBUTE; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+      }
+
+      GLsizei stride = static_cast<GLsizei>(INSTANCE_SIZE * sizeof(float));
+
+      for (size_t level = 0; level != numLevelsOfDetail; ++level) {
+        size_t numInstances = levelStarts[level + 1] - levelStarts[level];
+        if (numInstances == 0) {
+          continue;
+        }
+
+        // OpenGL 3.3 cannot offset the instances of a draw call (no base instance),
+        // so the attributes are pointed to the level's first instance instead
+        size_t levelOffset = levelStarts[level] * INSTANCE_SIZE * sizeof(float);
+        for (GLuint column = 0; column != 4; ++column) {
+          glVertexAttribPointer(MODEL_MATRIX_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, stride,
+                                reinterpret_cast<void *>(levelOffset + 4 * column * sizeof(float)));
+        }
+        for (GLuint column = 0; column != 3; ++column) {
+          glVertexAttribPointer(NORMAL_MATRIX_ATTRIBUTE + column, 3, GL_FLOAT, GL_FALSE, stride,
+                                reinterpret_cast<void *>(levelOffset + (16 + 3 * column) * sizeof(float)));
+        }
+        glVertexAttribPointer(COLOUR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<void *>(levelOffset + (INSTANCE_SIZE - 4) * sizeof(float)));
+
+        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei) model->getNumIndexes(level), buffers.indexType,
+                                reinterpret_cast<void *>(buffers.indexOffsets[level]),
+                                (GLsizei) numInstances);
+        countDraw(model->getNumIndexes(level), numInstances);
+      }
+
+      // The vertex array object is also used to render the model as a scene
+      // object, where these attributes are set per object instead
+      for (GLuint attribute = MODEL_MATRIX_ATTRIBUTE; attribute <= COLOUR_ATTRIBUTE; ++attribute) {
+        glDisableVertexAttribArray(attribute);
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
-    if (normalsBufferObject != 0) {
-      glDeleteBuffers(1, &normalsBufferObject);
+    else {
+      for (size_t level = 0; level != numLevelsOfDetail; ++level) {
+        for (size_t instance = levelStarts[level]; instance != levelStarts[level + 1]; ++instance) {
+          const float *data = &instanceData[INSTANCE_SIZE * instance];
+          for (GLuint column = 0; column != 4; ++column) {
+            glVertexAttrib4fv(MODEL_MATRIX_ATTRIBUTE + column, data + 4 * column);
+          }
+          for (GLuint column = 0; column != 3; ++column) {
+            glVertexAttrib3fv(NORMAL_MATRIX_ATTRIBUTE + column, data + 16 + 3 * column);
+          }
+          glVertexAttrib4fv(COLOUR_ATTRIBUTE, data + INSTANCE_SIZE - 4);
+
+          glDrawElements(GL_TRIANGLES, (GLsizei) model->getNumIndexes(level), buffers.indexType,
+                         reinterpret_cast<void *>(buffers.indexOffsets[level]));
+          countDraw(model->getNumIndexes(level));
+        }
+      }
+
+      if (buffers.uvBuffer != 0) {
+        glDisableVertexAttribArray(2);
+      }
+      glDisableVertexAttribArray(1);
+      glDisableVertexAttribArray(0);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
-    if (uvBufferObject != 0) {
-      glDeleteBuffers(1, &uvBufferObject);
+    checkForRenderingErrors("rendering instances", true);
+  }
+
+  void Renderer::useProgram(const GLuint &program) {
+    if (program == boundProgram) {
+      ++frameStatistics.bindsAvoided;
+      return;
     }
+    glUseProgram(program);
+    boundProgram = program;
+    ++frameStatistics.binds;
+    ++frameStatistics.programSwitches;
+  }
 
-    glDisableVertexAttribArray(1);
-    glDisableVertexAttribArray(0);
+  void Renderer::bindTexture(const GLuint &texture) {
+    if (texture == boundTexture) {
+      ++frameStatistics.bindsAvoided;
+      return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    boundTexture = texture;
+    ++frameStatistics.binds;
+    ++frameStatistics.textureBinds;
+  }
+
+  void Renderer::bindVertexArray(const GLuint &vertexArray) {
+    if (vertexArray == boundVertexArray) {
+      ++frameStatistics.bindsAvoided;
+      return;
+    }
+    glBindVertexArray(vertexArray);
+    boundVertexArray = vertexArray;
+    ++frameStatistics.binds;
+  }
 
+  void Renderer::unbindAll() {
+    if (!noShaders) {
+      glUseProgram(0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
     if (isOpenGL33Supported) {
-      glDeleteVertexArrays(1, &vao);
       glBindVertexArray(0);
     }
+    boundProgram = 0;
+    boundTexture = 0;
+    boundVertexArray = 0;
+  }
 
-    glUseProgram(0);
+  // Order of the draws in the render queue: by program, then texture, then model
+  static bool drawsInOrder(const GLuint &program, const GLuint &texture, const void *model,
+                           const GLuint &otherProgram, const GLuint &otherTexture, const void *otherModel) {
+    if (program != otherProgram) return program < otherProgram;
+    if (texture != otherTexture) return texture < otherTexture;
+    return model < otherModel;
+  }
+
+  void Renderer::queueSceneObject(shared_ptr<SceneObject> sceneObject) {
+    QueuedDraw draw;
+    draw.program = perspectiveProgram;
+    draw.texture = sceneObject->getTexture() ? getTextureHandle(sceneObject->getName()) : 0;
+    draw.model = sceneObject->getFrameModel(sceneObject->getCurrentFrame()).get();
+    draw.sceneObject = sceneObject;
+    draw.perspective = true;
+    queuedDraws.push_back(draw);
+  }
+
+  void Renderer::queueImage(const float *vertices, const string &textureName, const bool &perspective,
+                            const glm::vec3 &offset) {
+    QueuedDraw draw;
+    draw.program = perspective ? perspectiveProgram : orthographicProgram;
+    draw.texture = getTextureHandle(textureName);
+    draw.model = NULL;
+    memcpy(draw.imageVertices, vertices, sizeof(draw.imageVertices));
+    draw.textureName = textureName;
+    draw.perspective = perspective;
+    draw.offset = offset;
+    queuedDraws.push_back(draw);
+  }
+
+  void Renderer::renderQueue() {
+    // The scene objects outside the view frustum (all of them tested together) and
+    // those hidden behind the occluders are dropped, before the draws are sorted
+    vector<const Model*> models;
+    vector<glm::vec3> offsets, rotations;
+    for (vector<QueuedDraw>::iterator draw = queuedDraws.begin(); draw != queuedDraws.end(); ++draw) {
+      if (draw->sceneObject) {
+        models.push_back(draw->model);
+        offsets.push_back(*draw->sceneObject->getOffset());
+        rotations.push_back(*draw->sceneObject->getRotation());
+      }
+    }
+
+    if (!models.empty()) {
+      vector<unsigned char> visible;
+      size_t numVisible = cullObjects(models, offsets, rotations, visible);
+      frameStatistics.objectsCulled += static_cast<int>(models.size() - numVisible);
+
+      size_t object = 0;
+      vector<QueuedDraw>::iterator kept = queuedDraws.begin();
+      for (vector<QueuedDraw>::iterator draw = queuedDraws.begin(); draw != queuedDraws.end(); ++draw) {
+        if (draw->sceneObject && visible[object] &&
+            isOccluded(*draw->model, offsets[object], rotations[object], draw->sceneObject.get())) {
+          visible[object] = 0;
+          ++frameStatistics.objectsOccluded;
+        }
+        if (!draw->sceneObject || visible[object++]) {
+          if (kept != draw) *kept = *draw;
+          ++kept;
+        }
+      }
+      queuedDraws.erase(kept, queuedDraws.end());
+    }
+
+    // The orthographic program goes first, since it is mostly used for backgrounds
+    GLuint firstProgram = orthographicProgram;
+    stable_sort(queuedDraws.begin(), queuedDraws.end(),
+                [firstProgram](const QueuedDraw &draw, const QueuedDraw &otherDraw) {
+                  return drawsInOrder(draw.program == firstProgram ? 0 : draw.program, draw.texture, draw.model,
+                                      otherDraw.program == firstProgram ? 0 : otherDraw.program,
+                                      otherDraw.texture, otherDraw.model);
+                });
+
+    // Cleared before rendering, so that an exception does not leave the draws queued
+    vector<QueuedDraw> draws;
+    draws.swap(queuedDraws);
+
+    for (vector<QueuedDraw>::iterator draw = draws.begin(); draw != draws.end(); ++draw) {
+      if (draw->sceneObject) {
+        drawSceneObject(draw->sceneObject);
+      }
+      else {
+        renderImage(draw->imageVertices, draw->textureName, draw->perspective, draw->offset);
+      }
+    }
+  }
+
+  const RenderStatistics& Renderer::getLastFrameStatistics() const {
+    return lastFrameStatistics;
+  }
+
+  double Renderer::getTimeToFirstFrame() const {
+    return timeToFirstFrame;
+  }
+
+  int Renderer::getNumProgramsLoadedFromCache() const {
+    return numProgramsLoadedFromCache;
+  }
+
+  void Renderer::logStatistics() const {
+    const RenderStatistics &statistics = lastFrameStatistics;
+    stringstream ss;
+    ss << "Frame " << numFramesRendered << ": " << statistics.drawCalls << " draw calls, "
+    << statistics.trianglesDrawn << " triangles, " << statistics.objectsDrawn << " objects drawn, "
+    << statistics.objectsCulled << " culled, " << statistics.objectsOccluded << " occluded ("
+    << statistics.occluderTrianglesRasterised << " occluder triangles, " << statistics.occlusionMilliseconds
+    << " ms), " << statistics.bufferUploads << " uploads (" << statistics.bytesUploaded << " bytes), "
+    << statistics.programSwitches << " program switches, " << statistics.textureBinds << " texture binds, "
+    << statistics.binds << " binds (" << statistics.bindsAvoided << " avoided)";
+    if (statistics.gpuMilliseconds >= 0.0) {
+      ss << ", GPU " << statistics.gpuMilliseconds << " ms";
+      for (map<string, double>::const_iterator pass = statistics.passGpuMilliseconds.begin();
+           pass != statistics.passGpuMilliseconds.end(); ++pass) {
+        ss << ", " << pass->first << " " << pass->second << " ms";
+      }
+    }
+    LOGINFO(ss.str());
+  }
+
+  void Renderer::countUpload(const size_t &bytes) {
+    ++frameStatistics.bufferUploads;
+    frameStatistics.bytesUploaded += bytes;
+  }
+
+  void Renderer::countDraw(const size_t &numIndexes, const size_t &numInstances) {
+    ++frameStatistics.drawCalls;
+    frameStatistics.trianglesDrawn += static_cast<int>(numIndexes / 3 * numInstances);
+  }
+
+  void Renderer::startFrameTimer() {
+    if (!timerQueriesSupported) {
+      return;
+    }
+
+    if (frameTimerQueries.empty()) {
+      frameTimerQueries.resize(TIMER_QUERY_FRAMES);
+      for (size_t frame = 0; frame != TIMER_QUERY_FRAMES; ++frame) {
+        glGenQueries(2, frameTimerQueries[frame].frameQueries);
+        frameTimerQueries[frame].numPasses = 0;
+        frameTimerQueries[frame].issued = false;
+      }
+      currentFrameTimerQueries = 0;
+    }
+
+    // Timestamps, rather than GL_TIME_ELAPSED queries, which cannot be nested,
+    // so that the passes can be timed within the frame
+    FrameTimerQueries &queries = frameTimerQueries[currentFrameTimerQueries];
+    queries.numPasses = 0;
+    glQueryCounter(queries.frameQueries[0], GL_TIMESTAMP);
+  }
+
+  void Renderer::finishFrameTimer() {
+    while (!openPasses.empty()) {
+      endPass();
+    }
+
+    if (!timerQueriesSupported || frameTimerQueries.empty()) {
+      return;
+    }
+
+    FrameTimerQueries &queries = frameTimerQueries[currentFrameTimerQueries];
+    glQueryCounter(queries.frameQueries[1], GL_TIMESTAMP);
+    queries.issued = true;
+
+    currentFrameTimerQueries = (currentFrameTimerQueries + 1) % TIMER_QUERY_FRAMES;
+
+    // Read the results of the earlier frames, from the oldest one, if the GPU has
+    // finished them. The oldest frame's queries are reused next, so its results
+    // are dropped if they are still not available.
+    for (size_t age = 0; age != TIMER_QUERY_FRAMES; ++age) {
+      FrameTimerQueries &earlierQueries = frameTimerQueries[(currentFrameTimerQueries + age) % TIMER_QUERY_FRAMES];
+      if (!earlierQueries.issued) {
+        continue;
+      }
+
+      GLint available = 0;
+      glGetQueryObjectiv(earlierQueries.frameQueries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available) {
+        if (age == 0) {
+          earlierQueries.issued = false;
+        }
+        continue;
+      }
+
+      GLuint64 start = 0, end = 0;
+      glGetQueryObjectui64v(earlierQueries.frameQueries[0], GL_QUERY_RESULT, &start);
+      glGetQueryObjectui64v(earlierQueries.frameQueries[1], GL_QUERY_RESULT, &end);
+      lastGpuMilliseconds = static_cast<double>(end - start) / 1000000.0;
+
+      lastPassGpuMilliseconds.clear();
+      for (size_t pass = 0; pass != earlierQueries.numPasses; ++pass) {
+        glGetQueryObjectui64v(earlierQueries.passQueries[2 * pass], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(earlierQueries.passQueries[2 * pass + 1], GL_QUERY_RESULT, &end);
+        lastPassGpuMilliseconds[earlierQueries.passNames[pass]] += static_cast<double>(end - start) / 1000000.0;
+      }
 
+      earlierQueries.issued = false;
+    }
+  }
+
+  void Renderer::beginPass(const string &name) {
+    if (!timerQueriesSupported || frameTimerQueries.empty()) {
+      // Still kept track of, so that the passes are ended consistently
+      openPasses.push_back(0);
+      return;
+    }
+
+    FrameTimerQueries &queries = frameTimerQueries[currentFrameTimerQueries];
+    size_t pass = queries.numPasses++;
+    if (queries.passNames.size() < queries.numPasses) {
+      queries.passNames.resize(queries.numPasses);
+      queries.passQueries.resize(2 * queries.numPasses);
+      glGenQueries(2, &queries.passQueries[2 * pass]);
+    }
+    queries.passNames[pass] = name;
+    glQueryCounter(queries.passQueries[2 * pass], GL_TIMESTAMP);
+    openPasses.push_back(pass);
+  }
+
+  void Renderer::endPass() {
+    if (openPasses.empty()) {
+      throw Exception("There is no pass to end.");
+    }
+
+    if (!timerQueriesSupported || frameTimerQueries.empty()) {
+      openPasses.pop_back();
+      return;
+    }
+
+    FrameTimerQueries &queries = frameTimerQueries[currentFrameTimerQueries];
+    glQueryCounter(queries.passQueries[2 * openPasses.back() + 1], GL_TIMESTAMP);
+    openPasses.pop_back();
   }
 
   void Renderer::clearScreen() {
@@ -654,7 +2039,60 @@ namespace small3d {
   }
 
   void Renderer::swapBuffers() {
-    SDL_GL_SwapWindow(sdlWindow);
+    if (!queuedDraws.empty()) {
+      renderQueue();
+    }
+
+    unbindAll();
+
+    // The occluders may move before the next frame
+    occlusionBufferReady = false;
+
+    checkForRenderingErrors("rendering the frame", false);
+
+    finishFrameTimer();
+    frameStatistics.gpuMilliseconds = lastGpuMilliseconds;
+    frameStatistics.passGpuMilliseconds = lastPassGpuMilliseconds;
+
+    lastFrameStatistics = frameStatistics;
+    frameStatistics = RenderStatistics();
+
+    ++numFramesRendered;
+    if (statisticsLogInterval > 0 && numFramesRendered % statisticsLogInterval == 0) {
+      logStatistics();
+    }
+
+    if (offscreenFramebuffer != 0) {
+      glFlush();
+    }
+    else {
+      SDL_GL_SwapWindow(sdlWindow);
+    }
+
+    if (timeToFirstFrame < 0.0) {
+      // The swap may not have waited for the GPU
+      glFinish();
+      chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - initialisationStart;
+      timeToFirstFrame = elapsed.count();
+      stringstream ss;
+      ss << "Time to first frame: " << timeToFirstFrame << " ms (" << numProgramsLoadedFromCache
+         << " of 2 programs loaded from the program cache)";
+      LOGINFO(ss.str());
+    }
+
+    startFrameTimer();
+
+    // Release the buffers of the models that have been destroyed
+    unordered_map<const Model*, ModelBuffers>::iterator buffersIt = modelBuffers.begin();
+    while (buffersIt != modelBuffers.end()) {
+      if (buffersIt->second.model.expired()) {
+        deleteModelBuffers(buffersIt->second);
+        buffersIt = modelBuffers.erase(buffersIt);
+      }
+      else {
+        ++buffersIt;
+      }
+    }
   }
 
 
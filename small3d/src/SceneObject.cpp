@@ -8,10 +8,11 @@
 
 #include "SceneObject.hpp"
 #include <sstream>
-#include <iomanip>
 #include "Exception.hpp"
 #include "ModelLoader.hpp"
 #include "WavefrontLoader.hpp"
+#include "ParallelFor.hpp"
+#include "FrameAnimation.hpp"
 
 using namespace std;
 
@@ -25,7 +26,8 @@ namespace small3d {
 
   SceneObject::SceneObject(const string &name, const string &modelPath,
                            const int &numFrames, const string &texturePath,
-                           const string &boundingBoxesPath) {
+                           const string &boundingBoxesPath,
+                           const shared_ptr<ModelCache> &modelCache) {
     initLogger();
     this->name = name;
     animating = false;
@@ -33,27 +35,50 @@ namespace small3d {
     frameDelay = 1;
     currentFrame = 0;
     this->numFrames = numFrames;
-
-    unique_ptr<ModelLoader> loader(new WavefrontLoader());
+    interpolateFrames = false;
 
     if (numFrames > 1) {
-      LOGINFO("Loading " + name + " animated model (this may take a while):");
-      for (int idx = 0; idx < numFrames; ++idx) {
-        stringstream lss;
-        lss << "Frame " << idx + 1 << " of " << numFrames << "...";
-        LOGINFO(lss.str());
-        stringstream ss;
-        ss << setfill('0') << setw(6) << idx + 1;
-        string frameNum = ss.str();
-        Model model1;
-        loader->load(modelPath + "_" + frameNum + ".obj", model1);
-        model.push_back(model1);
+      stringstream lss;
+      lss << "Loading " << name << " animated model (" << numFrames << " frames)...";
+      LOGINFO(lss.str());
+
+      if (modelCache) {
+        // The frames are independent of each other, so they are loaded in parallel,
+        // each one straight into its own slot. They are kept whole, since they are
+        // shared with any other objects using the cache.
+        model = vector<shared_ptr<const Model> >(static_cast<size_t>(numFrames));
+
+        parallelFor(numFrames, [&](const int &idx) {
+          model[static_cast<size_t>(idx)] = modelCache->getModel(modelPath, idx + 1);
+        });
+      }
+      else {
+        // The frames are optimised as they are loaded, so that they are ready to be stored
+        // separately if they turn out not to share their topology. Optimisation only depends
+        // on the index data, so frames with the same topology still have their faces in the
+        // same order and can be matched to each other, without being optimised again.
+        vector<shared_ptr<Model> > frames(static_cast<size_t>(numFrames));
+
+        parallelFor(numFrames, [&](const int &idx) {
+          frames[static_cast<size_t>(idx)] = shared_ptr<Model>(new Model());
+          unique_ptr<ModelLoader> loader(new WavefrontLoader(true, false, true));
+          loader->load(ModelCache::getFrameLocation(modelPath, idx + 1), *frames[static_cast<size_t>(idx)]);
+        });
+
+        frameAnimation = FrameAnimation::create(frames, false);
+
+        if (frameAnimation) {
+          // Only the topology and texture coordinates of the first frame are kept
+          model.push_back(frameAnimation->getFirstFrame());
+        }
+        else {
+          LOGINFO("The frames of " + name + " do not share the same topology, so they are stored separately.");
+          model.assign(frames.begin(), frames.end());
+        }
       }
     }
     else {
-      Model model1;
-      loader->load(modelPath, model1);
-      model.push_back(model1);
+      model.push_back(loadModel(modelPath, modelCache));
     }
 
     if (texturePath != "") {
@@ -69,12 +94,79 @@ namespace small3d {
 
   }
 
+  shared_ptr<const Model> SceneObject::loadModel(const string &modelPath,
+                                                const shared_ptr<ModelCache> &modelCache) {
+    if (modelCache) {
+      return modelCache->getModel(modelPath);
+    }
+
+    shared_ptr<Model> loadedModel(new Model());
+    unique_ptr<ModelLoader> loader(new WavefrontLoader(true, false, true));
+    loader->load(modelPath, *loadedModel);
+    return loadedModel;
+  }
+
   SceneObject::~SceneObject() {
 
   }
 
-  Model &SceneObject::getModel() {
-    return model[currentFrame];
+  const Model &SceneObject::getModel() const {
+    return *model[frameAnimation ? 0 : currentFrame];
+  }
+
+  shared_ptr<const Model> SceneObject::getFrameModel(const int &frame) const {
+    return model[frameAnimation ? 0 : frame];
+  }
+
+  int SceneObject::getNumFrames() const {
+    return numFrames;
+  }
+
+  int SceneObject::getCurrentFrame() const {
+    return currentFrame;
+  }
+
+  int SceneObject::getNextFrame() const {
+    return (currentFrame + 1) % numFrames;
+  }
+
+  const vector<float> &SceneObject::getVertexData() const {
+    return frameAnimation ? frameAnimation->getVertexData(currentFrame) : getModel().vertexData;
+  }
+
+  const vector<float> &SceneObject::getNormalsData() const {
+    return frameAnimation ? frameAnimation->getNormalsData(currentFrame) : getModel().normalsData;
+  }
+
+  const vector<float> &SceneObject::getCompactVertexData() const {
+    return frameAnimation ? frameAnimation->getCompactVertexData(currentFrame) : getModel().compactVertexData;
+  }
+
+  const vector<unsigned int> &SceneObject::getPackedNormalsData() const {
+    return frameAnimation ? frameAnimation->getPackedNormalsData(currentFrame) : getModel().packedNormalsData;
+  }
+
+
+  const vector<float> &SceneObject::getNextVertexData() const {
+    return frameAnimation ? frameAnimation->getVertexData(getNextFrame()) : model[getNextFrame()]->vertexData;
+  }
+
+  const vector<float> &SceneObject::getNextNormalsData() const {
+    return frameAnimation ? frameAnimation->getNormalsData(getNextFrame()) : model[getNextFrame()]->normalsData;
+  }
+
+  const vector<float> &SceneObject::getNextCompactVertexData() const {
+    return frameAnimation ? frameAnimation->getCompactVertexData(getNextFrame()) :
+           model[getNextFrame()]->compactVertexData;
+  }
+
+  const vector<unsigned int> &SceneObject::getNextPackedNormalsData() const {
+    return frameAnimation ? frameAnimation->getPackedNormalsData(getNextFrame()) :
+           model[getNextFrame()]->packedNormalsData;
+  }
+
+  shared_ptr<const FrameAnimation> SceneObject::getFrameAnimation() const {
+    return frameAnimation;
   }
 
   const shared_ptr<Image> &SceneObject::getTexture() const {
@@ -120,12 +212,25 @@ namespace small3d {
 
   void SceneObject::resetAnimation() {
     currentFrame = 0;
+    framesWaited = 0;
   }
 
   void SceneObject::setFrameDelay(const int &delay) {
     this->frameDelay = delay;
   }
 
+  void SceneObject::setFrameInterpolation(const bool &interpolate) {
+    interpolateFrames = interpolate;
+  }
+
+  float SceneObject::getFrameBlend() const {
+    // Separately stored frames have their own index data, so their vertices cannot be matched
+    if (!interpolateFrames || !frameAnimation || frameDelay < 2) {
+      return 0.0f;
+    }
+    return static_cast<float>(framesWaited) / static_cast<float>(frameDelay);
+  }
+
   void SceneObject::animate() {
     if (animating) {
       ++framesWaited;
@@ -0,0 +1,146 @@
+/*
+ *  VertexQuantisation.cpp
+ *
+ *  Created on: 2026/10/17
+ *      Author: Dimitri Kourkoulis
+ *     License: BSD 3-Clause License (see LICENSE file)
+ */
+
+#include "VertexQuantisation.hpp"
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+
+namespace small3d {
+
+  // Convert a value between -1 and 1 to a signed, normalised 10-bit integer
+  static unsigned int packSnorm10(const float &value) {
+    float clamped = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    int quantised = static_cast<int>(floor(clamped * 511.0f + 0.5f));
+    return static_cast<unsigned int>(quantised) & 0x3ff;
+  }
+
+  static float unpackSnorm10(const unsigned int &packed) {
+    int quantised = static_cast<int>(packed & 0x3ff);
+
+    // Sign extension
+    if (quantised & 0x200) quantised -= 0x400;
+
+    float value = static_cast<float>(quantised) / 511.0f;
+    return value < -1.0f ? -1.0f : value;
+  }
+
+  unsigned int packNormal(const float &x, const float &y, const float &z) {
+    return packSnorm10(x) | (packSnorm10(y) << 10) | (packSnorm10(z) << 20);
+  }
+
+  void unpackNormal(const unsigned int &packed, float &x, float &y, float &z) {
+    x = unpackSnorm10(packed);
+    y = unpackSnorm10(packed >> 10);
+    z = unpackSnorm10(packed >> 20);
+  }
+
+  unsigned short floatToHalf(const float &value) {
+    unsigned int bits = 0;
+    memcpy(&bits, &value, sizeof(float));
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    int exponent = static_cast<int>((bits >> 23) & 0xff);
+    unsigned int mantissa = bits & 0x7fffff;
+
+    // Infinity and NaN (keeping NaN a NaN)
+    if (exponent == 0xff) {
+      return static_cast<unsigned short>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+    }
+
+    int halfExponent = exponent - 127 + 15;
+
+    // Too large
+    if (halfExponent >= 0x1f) {
+      return static_cast<unsigned short>(sign | 0x7c00);
+    }
+
+    unsigned int half = 0;
+    unsigned int remainder = 0;
+    unsigned int halfway = 0;
+
+    if (halfExponent <= 0) {
+      // Too small, even for a subnormal half float
+      if (halfExponent < -10) {
+        return static_cast<unsigned short>(sign);
+      }
+
+      // Subnormal half float (the implicit leading 1 becomes explicit)
+      mantissa |= 0x800000;
+      unsigned int shift = static_cast<unsigned int>(14 - halfExponent);
+      half = mantissa >> shift;
+      remainder = mantissa & ((1u << shift) - 1);
+      halfway = 1u << (shift - 1);
+    }
+    else {
+      half = (static_cast<unsigned int>(halfExponent) << 10) | (mantissa >> 13);
+      remainder = mantissa & 0x1fff;
+      halfway = 0x1000;
+    }
+
+    // Round to nearest, ties to even. A carry out of the mantissa correctly
+    // increments the exponent (up to infinity).
+    if (remainder > halfway || (remainder == halfway && (half & 1))) {
+      ++half;
+    }
+
+    return static_cast<unsigned short>(sign | half);
+  }
+
+  float halfToFloat(const unsigned short &value) {
+    unsigned int sign = (static_cast<unsigned int>(value) & 0x8000) << 16;
+    unsigned int exponent = (value >> 10) & 0x1f;
+    unsigned int mantissa = value & 0x3ff;
+
+    if (exponent == 0) {
+      // Zero or subnormal (mantissa * 2^-24)
+      float result = ldexp(static_cast<float>(mantissa), -24);
+      return sign != 0 ? -result : result;
+    }
+
+    unsigned int bits = 0;
+
+    if (exponent == 0x1f) {
+      // Infinity or NaN
+      bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else {
+      bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result = 0.0f;
+    memcpy(&result, &bits, sizeof(float));
+    return result;
+  }
+
+  void quantiseVertexData(Model &model) {
+    size_t numVertices = model.vertexData.size() / 4;
+
+    model.compactVertexData.resize(3 * numVertices);
+    for (size_t vertex = 0; vertex != numVertices; ++vertex) {
+      model.compactVertexData[3 * vertex] = model.vertexData[4 * vertex];
+      model.compactVertexData[3 * vertex + 1] = model.vertexData[4 * vertex + 1];
+      model.compactVertexData[3 * vertex + 2] = model.vertexData[4 * vertex + 2];
+    }
+
+    size_t numNormals = model.normalsData.size() / 3;
+
+    model.packedNormalsData.resize(numNormals);
+    for (size_t normal = 0; normal != numNormals; ++normal) {
+      model.packedNormalsData[normal] = packNormal(model.normalsData[3 * normal],
+                                                   model.normalsData[3 * normal + 1],
+                                                   model.normalsData[3 * normal + 2]);
+    }
+
+    model.halfTextureCoordsData.resize(model.textureCoordsData.size());
+    for (size_t coord = 0; coord != model.textureCoordsData.size(); ++coord) {
+      model.halfTextureCoordsData[coord] = floatToHalf(model.textureCoordsData[coord]);
+    }
+  }
+}
@@ -10,81 +10,162 @@
 #include "Exception.hpp"
 #include <fstream>
 #include <unordered_map>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <sstream>
 #include "GetTokens.hpp"
+#include "ParseNumbers.hpp"
+#include "MappedFile.hpp"
+#include "BinaryMeshLoader.hpp"
+#include "MeshOptimisation.hpp"
+#include "VertexQuantisation.hpp"
+#include "MeshSimplification.hpp"
+#include "ParallelFor.hpp"
 #include <SDL.h>
 
 using namespace std;
 
 namespace small3d {
 
-  void WavefrontLoader::loadVertexData() {
-    // 4 components per vertex
-    model->vertexDataSize = static_cast<int>(4 * vertices.size() * sizeof(float));
+  // Smaller files are not worth splitting between threads
+  static const size_t minParsingChunkSize = 1 << 20;
+
+  // A combination of position, texture coordinates and normal indices, identifying a vertex
+  struct VertexKey {
+    int position;
+    int textureCoords;
+    int normal;
+
+    bool operator==(const VertexKey &other) const {
+      return position == other.position && textureCoords == other.textureCoords && normal == other.normal;
+    }
+  };
+
+  struct VertexKeyHash {
+    size_t operator()(const VertexKey &key) const {
+      size_t hash = static_cast<size_t>(key.position) * 73856093u;
+      hash ^= static_cast<size_t>(key.textureCoords) * 19349663u;
+      hash ^= static_cast<size_t>(key.normal) * 83492791u;
+      return hash;
+    }
+  };
+
+  void WavefrontLoader::weldVertices() {
+
+    if (facesNormalIndices.size() != facesVertexIndices.size()) {
+      throw Exception("Normals have not been provided for all faces.");
+    }
+
+    bool hasTextureCoords = !textureCoords.empty();
+
+    if (hasTextureCoords && textureCoordsIndices.size() != facesVertexIndices.size()) {
+      throw Exception("Texture coordinates have not been provided for all faces.");
+    }
 
-    model->vertexData.clear();
+    int numVertices = static_cast<int>(vertices.size() / 3);
+    int numNormals = static_cast<int>(normals.size() / 3);
+    int numTextureCoords = static_cast<int>(textureCoords.size() / 2);
 
-    int idx = 0;
-    for (vector<vector<float> >::iterator vertex = vertices.begin(); vertex != vertices.end(); ++vertex) {
-      for (unsigned long coordIdx = 0; coordIdx != 3; ++coordIdx) {
-        model->vertexData.push_back(vertex->at(coordIdx));
-        ++idx;
+    size_t numIndexes = facesVertexIndices.size();
+
+    unordered_map<VertexKey, unsigned int, VertexKeyHash> vertexIndexes;
+    vertexIndexes.reserve(numIndexes);
+
+    weldedVertices.clear();
+    weldedVertices.reserve(3 * static_cast<size_t>(numVertices));
+    weldedIndices.resize(numIndexes);
+
+    for (size_t idx = 0; idx != numIndexes; ++idx) {
+      VertexKey key;
+      key.position = facesVertexIndices[idx];
+      key.textureCoords = hasTextureCoords ? textureCoordsIndices[idx] : 0;
+      key.normal = facesNormalIndices[idx];
+
+      if (key.position < 1 || key.position > numVertices) {
+        throw Exception("Vertex index out of range while loading Wavefront file.");
+      }
+      if (key.normal < 1 || key.normal > numNormals) {
+        throw Exception("Normal index out of range while loading Wavefront file.");
+      }
+      if (hasTextureCoords && (key.textureCoords < 1 || key.textureCoords > numTextureCoords)) {
+        throw Exception("Texture coordinates index out of range while loading Wavefront file.");
       }
-      model->vertexData.push_back(1.0f);
-      ++idx;
+
+      unsigned int vertexIndex = static_cast<unsigned int>(weldedVertices.size() / 3);
+
+      pair<unordered_map<VertexKey, unsigned int, VertexKeyHash>::iterator, bool> insertion =
+          vertexIndexes.insert(make_pair(key, vertexIndex));
+
+      if (insertion.second) {
+        // First time this combination is encountered, so it becomes a new vertex
+        weldedVertices.push_back(key.position);
+        weldedVertices.push_back(key.textureCoords);
+        weldedVertices.push_back(key.normal);
+      }
+
+      weldedIndices[idx] = insertion.first->second;
     }
   }
 
-  void WavefrontLoader::loadIndexData() {
-    // 3 indices per face
-    int numIndexes = facesVertexIndices.size() * 3;
-    model->indexDataSize = numIndexes * sizeof(int);
+  void WavefrontLoader::loadVertexData() {
+    size_t numVertices = weldedVertices.size() / 3;
 
-    model->indexData.clear();
+    // 4 components per vertex
+    model->vertexDataSize = static_cast<int>(4 * numVertices * sizeof(float));
 
-    for (vector<vector<int> >::iterator face = facesVertexIndices.begin(); face != facesVertexIndices.end(); ++face) {
+    model->vertexData.resize(4 * numVertices);
 
-      for (int indexIdx = 0; indexIdx != 3; ++indexIdx) {
-        model->indexData.push_back(face->at(indexIdx) - 1); // -1 because Wavefront indexes
-        // are not 0 based
+    float* vertexData = model->vertexData.data();
 
-      }
+    for (size_t idx = 0; idx != numVertices; ++idx) {
+      // -1 because Wavefront indexes are not 0 based
+      const float* vertex = &vertices[3 * static_cast<size_t>(weldedVertices[3 * idx] - 1)];
+      vertexData[0] = vertex[0];
+      vertexData[1] = vertex[1];
+      vertexData[2] = vertex[2];
+      vertexData[3] = 1.0f;
+      vertexData += 4;
     }
   }
 
+  void WavefrontLoader::loadIndexData() {
+    // 3 indices per face
+    model->indexDataSize = static_cast<int>(weldedIndices.size() * sizeof(int));
+
+    model->indexData.assign(weldedIndices.begin(), weldedIndices.end());
+    model->lodIndexData.clear();
+  }
+
   void WavefrontLoader::loadNormalsData() {
 
     // Create an array of normal components which corresponds
     // by index to the array of vertex components
 
-
     if (model->vertexData.size() == 0) {
       throw Exception(
           "There are no vertices or vertex data has not yet been created.");
     }
 
+    size_t numVertices = weldedVertices.size() / 3;
+
     // 3 components per vertex (a single index for vertices, normals and texture coordinates
     // is passed to OpenGL, so normals data will be aligned to vertex data according to the
     // vertex index)
 
-    model->normalsDataSize = static_cast<int>(3 * vertices.size() * sizeof(float));
+    model->normalsDataSize = static_cast<int>(3 * numVertices * sizeof(float));
 
-    model->normalsData = vector<float>(3 * vertices.size(), 0.0f);
+    model->normalsData.resize(3 * numVertices);
 
-    int faceVertexArrayIndex = 0;
-    for (vector<vector<int> >::iterator faceVertexIndex = facesVertexIndices.begin();
-         faceVertexIndex != facesVertexIndices.end(); ++faceVertexIndex) {
-      for (int vertexIndex = 0; vertexIndex != 3; ++vertexIndex) {
+    float* normalsData = model->normalsData.data();
 
-        for (int normalsDataComponent = 0; normalsDataComponent != 3;
-             ++normalsDataComponent) {
-          model->normalsData[3 * (faceVertexIndex->at(vertexIndex) - 1)
-                             + normalsDataComponent] =
-              normals.at(
-                  facesNormalIndices.at(faceVertexArrayIndex)[vertexIndex]
-                  - 1)[normalsDataComponent];
-        }
-      }
-      ++faceVertexArrayIndex;
+    for (size_t idx = 0; idx != numVertices; ++idx) {
+      const float* normal = &normals[3 * static_cast<size_t>(weldedVertices[3 * idx + 2] - 1)];
+      normalsData[0] = normal[0];
+      normalsData[1] = normal[1];
+      normalsData[2] = normal[2];
+      normalsData += 3;
     }
   }
 
@@ -98,71 +179,28 @@ namespace small3d {
             "There are no vertices or vertex data has not yet been created.");
       }
 
+      size_t numVertices = weldedVertices.size() / 3;
+
       // 2 components per vertex (a single index for vertices, normals and texture coordinates
       // is passed to OpenGL, so texture coordinates data will be aligned to vertex data according
       // to the vertex index)
-      model->textureCoordsDataSize = 2 * vertices.size() * sizeof(float);
-
-      model->textureCoordsData = vector<float>(2 * vertices.size());
+      model->textureCoordsDataSize = static_cast<int>(2 * numVertices * sizeof(float));
 
-      int faceVertexArrayIndex = 0;
+      model->textureCoordsData.resize(2 * numVertices);
 
-      for (vector<vector<int> >::iterator faceVertexIndex = facesVertexIndices.begin();
-           faceVertexIndex != facesVertexIndices.end();
-           ++faceVertexIndex) {
-        for (int vertexIndex = 0; vertexIndex != 3; ++vertexIndex) {
+      float* textureCoordsData = model->textureCoordsData.data();
 
-          for (int textureCoordsComponent = 0;
-               textureCoordsComponent != 2; ++textureCoordsComponent) {
-            model->textureCoordsData[2 * (faceVertexIndex->at(vertexIndex) - 1)
-                                     + textureCoordsComponent] =
-                textureCoords.at(
-                    static_cast<unsigned long>(textureCoordsIndices.at(faceVertexArrayIndex)[vertexIndex]
-                                     - 1))[textureCoordsComponent];
-          }
-        }
-        ++faceVertexArrayIndex;
+      for (size_t idx = 0; idx != numVertices; ++idx) {
+        const float* textureCoordsItem = &textureCoords[2 * static_cast<size_t>(weldedVertices[3 * idx + 1] - 1)];
+        textureCoordsData[0] = textureCoordsItem[0];
+        textureCoordsData[1] = textureCoordsItem[1];
+        textureCoordsData += 2;
       }
     }
-  }
-
-  void WavefrontLoader::correctDataVectors() {
-
-    unique_ptr<unordered_map<int, int> > vertexUVPairs(new unordered_map<int, int>());
-
-    int numIndexes = static_cast<int>(facesVertexIndices.size());
-
-    for (int idx = 0; idx < numIndexes; ++idx) {
-
-      for (int vertexIndex = 0; vertexIndex != 3; ++vertexIndex) {
-
-        unordered_map<int, int>::iterator vertexUVPair = vertexUVPairs->find(facesVertexIndices[idx][vertexIndex]);
-        if (vertexUVPair != vertexUVPairs->end()) {
-          if (vertexUVPair->second != textureCoordsIndices.at(idx)[vertexIndex]) {
-            // duplicate corresponding vertex data entry and point the vertex index to the new tuple
-            vector<float> v;
-            // -1 because at this stage the indexes are still as exported from Blender, meaning 1-based
-            // and not 0-based
-            v.push_back(vertices[facesVertexIndices[idx][vertexIndex] - 1][0]);
-            v.push_back(vertices[facesVertexIndices[idx][vertexIndex] - 1][1]);
-            v.push_back(vertices[facesVertexIndices[idx][vertexIndex] - 1][2]);
-            vertices.push_back(v);
-
-            facesVertexIndices[idx][vertexIndex] = static_cast<int>(vertices.size());
-
-            vertexUVPairs->insert(
-                make_pair(facesVertexIndices[idx][vertexIndex], textureCoordsIndices[idx][vertexIndex]));
-          }
-          // So we don't add a pair if the exact same pair already exists. We do if it does not (see below) or if
-          // the vertex index number exists in a pair with a different texture coordinates index number (see above)
-        }
-        else {
-          vertexUVPairs->insert(
-              make_pair(facesVertexIndices[idx][vertexIndex], textureCoordsIndices[idx][vertexIndex]));
-        }
-      }
+    else {
+      model->textureCoordsDataSize = 0;
+      model->textureCoordsData.clear();
     }
-
   }
 
   void WavefrontLoader::init() {
@@ -172,173 +210,487 @@ namespace small3d {
     facesNormalIndices.clear();
     textureCoords.clear();
     textureCoordsIndices.clear();
+    weldedVertices.clear();
+    weldedIndices.clear();
     this->model = NULL;
   }
 
   void WavefrontLoader::clear() {
-    vertices.clear();
-    facesVertexIndices.clear();
-    normals.clear();
-    facesNormalIndices.clear();
-    textureCoords.clear();
-    textureCoordsIndices.clear();
+    // Release the memory too, not just the contents
+    vector<float>().swap(vertices);
+    vector<int>().swap(facesVertexIndices);
+    vector<float>().swap(normals);
+    vector<int>().swap(facesNormalIndices);
+    vector<float>().swap(textureCoords);
+    vector<int>().swap(textureCoordsIndices);
+    vector<int>().swap(weldedVertices);
+    vector<unsigned int>().swap(weldedIndices);
 
     this->model = NULL;
   }
 
 
-  WavefrontLoader::WavefrontLoader() {
+  WavefrontLoader::WavefrontLoader(const bool &memoryMapped, const bool &useMeshCache,
+                                   const bool &optimiseMesh, const bool &quantise,
+                                   const int &levelsOfDetail) {
+    initLogger();
     init();
-
+    this->memoryMapped = memoryMapped;
+    this->useMeshCache = useMeshCache;
+    this->optimiseMesh = optimiseMesh;
+    this->quantise = quantise;
+    this->levelsOfDetail = levelsOfDetail;
+    this->parsingThreads = 0;
   }
 
   WavefrontLoader::~WavefrontLoader() {
     clear();
   }
 
-  void WavefrontLoader::load(const string &fileLocation, Model &model) {
+  // Skip spaces and tabs (and carriage returns, for files with Windows line endings)
+  static const char* skipBlanks(const char* pos, const char* end) {
+    while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+      ++pos;
+    }
+    return pos;
+  }
 
-    ifstream file((SDL_GetBasePath() + fileLocation).c_str());
-    string line;
-    if (file.is_open()) {
-      init();
-      this->model = &model;
+  // Read a given number of floats, separated by blanks
+  static const char* readFloats(const char* pos, const char* end, float* values, const int numValues) {
+    for (int idx = 0; idx != numValues; ++idx) {
+      pos = skipBlanks(pos, end);
+      const char* numberEnd = parseFloat(pos, end, values[idx]);
+      if (numberEnd == pos) {
+        throw Exception("Expected a number while parsing Wavefront file.");
+      }
+      pos = numberEnd;
+    }
+    return pos;
+  }
 
-      while (getline(file, line)) {
-        if (line[0] == 'v' || line[0] == 'f') {
-          string tokens[4]; // Max 4 such tokens in the specific kind of Wavefront file
+  void WavefrontLoader::parseStream(ifstream &file) {
+    string line;
+    while (getline(file, line)) {
+      if (line[0] == 'v' || line[0] == 'f') {
+        string tokens[4]; // Max 4 such tokens in the specific kind of Wavefront file
 
-          int numTokens = getTokens(line, ' ', tokens);
+        int numTokens = getTokens(line, ' ', tokens);
 
-          int idx = 0;
+        if (line[0] == 'v' && line[1] == 'n') {
+          // get vertex normal (the first token is the vertex normal indicator)
+          for (int tokenIdx = 1; tokenIdx != 4; ++tokenIdx) {
+            normals.push_back(tokenIdx < numTokens ? static_cast<float>(atof(tokens[tokenIdx].c_str())) : 0.0f);
+          }
+        }
+        else if (line[0] == 'v' && line[1] == 't') {
+          // The first token is the vertex texture coordinate indicator
+          float vt[2] = {0.0f, 0.0f};
 
-          if (line[0] == 'v' && line[1] == 'n') {
-            // get vertex normal
-            vector<float> vn;
+          for (int tokenIdx = 1; tokenIdx < numTokens && tokenIdx != 3; ++tokenIdx) {
+            vt[tokenIdx - 1] = static_cast<float>(atof(tokens[tokenIdx].c_str()));
+          }
 
-            for (int tokenIdx = 0; tokenIdx < numTokens; ++tokenIdx) {
-              string t = tokens[tokenIdx];
-              if (idx > 0)   // The first token is the vertex normal indicator
-              {
-                vn.push_back(static_cast<float>(atof(t.c_str())));
-              }
-              ++idx;
-            }
-            normals.push_back(vn);
+          textureCoords.push_back(vt[0]);
+          textureCoords.push_back(1.0f - vt[1]); // OpenGL's y direction for textures is the opposite of that
+          // of Blender's, so an inversion is needed
+        }
+        else if (line[0] == 'v') {
+          // get vertex (the first token is the vertex indicator)
+          for (int tokenIdx = 1; tokenIdx != 4; ++tokenIdx) {
+            vertices.push_back(tokenIdx < numTokens ? static_cast<float>(atof(tokens[tokenIdx].c_str())) : 0.0f);
           }
-          else if (line[0] == 'v' && line[1] == 't') {
-            vector<float> vt;
-
-            for (int tokenIdx = 0; tokenIdx < numTokens; ++tokenIdx) {
-              string t = tokens[tokenIdx];
-              if (idx > 0)   // The first token is the vertex texture coordinate indicator
-              {
-                vt.push_back(static_cast<float>(atof(t.c_str())));
+        }
+        else {
+          // get vertex index
+          int v[3] = {0, 0, 0};
+          int n[3] = {0, 0, 0};
+          int textC[3] = {0, 0, 0};
+          bool hasNormals = false;
+          bool hasTextureCoords = false;
+
+          for (int tokenIdx = 1; tokenIdx < numTokens; ++tokenIdx) { // The first token is face indicator
+            string t = tokens[tokenIdx];
+            int idx = tokenIdx - 1;
+
+            if (t.find("//") != string::npos)   // normal index contained in the string
+            {
+              v[idx] = atoi(
+                  t.substr(0, t.find("//")).c_str());
+              n[idx] = atoi(
+                  t.substr(t.find("//") + 2).c_str());
+              hasNormals = true;
+            }
+            else if (t.find("/") != string::npos)   // normal and texture coordinate index are
+              // contained in the string
+            {
+              string components[3]; // Max 3 such components in Wavefront files
+              int numComponents = getTokens(t, '/', components);
+
+              for (int compIdx = 0; compIdx < numComponents; ++compIdx) {
+                string component = components[compIdx];
+                switch (compIdx) {
+                  case 0:
+                    v[idx] = atoi(component.c_str());
+                    break;
+                  case 1:
+                    textC[idx] = atoi(component.c_str());
+                    hasTextureCoords = true;
+                    break;
+                  case 2:
+                    n[idx] = atoi(component.c_str());
+                    hasNormals = true;
+                    break;
+                  default:
+                    throw Exception("Unexpected component index number while parsing Wavefront file.");
+                    break;
+                }
               }
-              ++idx;
+
+            }
+
+            else   // just the vertex index is contained in the string
+            {
+              v[idx] = atoi(t.c_str());
             }
+          }
+          facesVertexIndices.insert(facesVertexIndices.end(), v, v + 3);
+          if (hasNormals)
+            facesNormalIndices.insert(facesNormalIndices.end(), n, n + 3);
+          if (hasTextureCoords)
+            textureCoordsIndices.insert(textureCoordsIndices.end(), textC, textC + 3);
+        }
+
+      }
+    }
+  }
+
+  void WavefrontLoader::parseFace(const char* pos, const char* lineEnd) {
+    int v[3] = {0, 0, 0};
+    int n[3] = {0, 0, 0};
+    int textC[3] = {0, 0, 0};
+    bool hasNormals = false;
+    bool hasTextureCoords = false;
+
+    for (int vertexIdx = 0; vertexIdx != 3; ++vertexIdx) {
+      pos = skipBlanks(pos, lineEnd);
 
+      const char* indexEnd = parseInt(pos, lineEnd, v[vertexIdx]);
+      if (indexEnd == pos) {
+        throw Exception("Expected a vertex index while parsing Wavefront file.");
+      }
+      pos = indexEnd;
+
+      if (pos != lineEnd && *pos == '/') {
+        ++pos;
+        if (pos != lineEnd && *pos == '/') {
+          // vertex//normal
+          ++pos;
+          pos = parseInt(pos, lineEnd, n[vertexIdx]);
+          hasNormals = true;
+        }
+        else {
+          // vertex/texture coordinates[/normal]
+          pos = parseInt(pos, lineEnd, textC[vertexIdx]);
+          hasTextureCoords = true;
+          if (pos != lineEnd && *pos == '/') {
+            ++pos;
+            pos = parseInt(pos, lineEnd, n[vertexIdx]);
+            hasNormals = true;
+          }
+        }
+      }
+    }
+
+    if (skipBlanks(pos, lineEnd) != lineEnd) {
+      throw Exception("Only triangulated faces are supported in Wavefront files.");
+    }
+
+    facesVertexIndices.insert(facesVertexIndices.end(), v, v + 3);
+    if (hasNormals)
+      facesNormalIndices.insert(facesNormalIndices.end(), n, n + 3);
+    if (hasTextureCoords)
+      textureCoordsIndices.insert(textureCoordsIndices.end(), textC, textC + 3);
+  }
+
+  void WavefrontLoader::reserveData(const char* data, const char* dataEnd) {
+    size_t numVertices = 0, numNormals = 0, numTextureCoords = 0, numFaces = 0;
+    const char* pos = data;
+
+    while (pos != dataEnd) {
+      if (dataEnd - pos > 1) {
+        if (pos[0] == 'v') {
+          if (pos[1] == 'n') ++numNormals;
+          else if (pos[1] == 't') ++numTextureCoords;
+          else ++numVertices;
+        }
+        else if (pos[0] == 'f') {
+          ++numFaces;
+        }
+      }
+      const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(dataEnd - pos)));
+      pos = lineEnd == NULL ? dataEnd : lineEnd + 1;
+    }
+
+    vertices.reserve(3 * numVertices);
+    normals.reserve(3 * numNormals);
+    textureCoords.reserve(2 * numTextureCoords);
+    facesVertexIndices.reserve(3 * numFaces);
+    if (numNormals > 0) facesNormalIndices.reserve(3 * numFaces);
+    if (numTextureCoords > 0) textureCoordsIndices.reserve(3 * numFaces);
+  }
+
+  void WavefrontLoader::parseData(const char* data, const char* dataEnd) {
+    reserveData(data, dataEnd);
+
+    const char* pos = data;
+
+    while (pos != dataEnd) {
+      const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(dataEnd - pos)));
+      if (lineEnd == NULL) {
+        lineEnd = dataEnd;
+      }
+
+      if (lineEnd - pos > 1) {
+        if (pos[0] == 'v') {
+          if (pos[1] == 'n') {
+            // get vertex normal
+            float vn[3];
+            readFloats(pos + 2, lineEnd, vn, 3);
+            normals.insert(normals.end(), vn, vn + 3);
+          }
+          else if (pos[1] == 't') {
+            float vt[2];
+            readFloats(pos + 2, lineEnd, vt, 2);
             vt[1] = 1.0f - vt[1]; // OpenGL's y direction for textures is the opposite of that
             // of Blender's, so an inversion is needed
-            textureCoords.push_back(vt);
+            textureCoords.insert(textureCoords.end(), vt, vt + 2);
           }
-          else if (line[0] == 'v') {
+          else if (pos[1] == ' ' || pos[1] == '\t') {
             // get vertex
-            vector<float> v;
-
-            for (int tokenIdx = 0; tokenIdx < numTokens; ++tokenIdx) {
-              string t = tokens[tokenIdx];
-              if (idx > 0)   // The first token is the vertex indicator
-              {
-                v.push_back(static_cast<float>(atof(t.c_str())));
-              }
-              ++idx;
-            }
-            vertices.push_back(v);
+            float v[3];
+            readFloats(pos + 1, lineEnd, v, 3);
+            vertices.insert(vertices.end(), v, v + 3);
           }
-          else {
-            // get vertex index
-            vector<int> v = vector<int>(3, 0);
-            vector<int> n;
-            vector<int> textC;
-
-            for (int tokenIdx = 0; tokenIdx < numTokens; ++tokenIdx) {
-              string t = tokens[tokenIdx];
-
-              if (idx > 0)   // The first token is face indicator
-              {
-                if (t.find("//") != string::npos)   // normal index contained in the string
-                {
-                  v[idx - 1] = atoi(
-                      t.substr(0, t.find("//")).c_str());
-                  n.push_back(atoi(
-                      t.substr(t.find("//") + 2).c_str()));
-                }
-                else if (t.find("/") != string::npos
-                         && t.find("//") == string::npos)   // normal and texture coordinate index are
-                  // contained in the string
-                {
-                  string components[3]; // Max 3 such components in Wavefront files
-                  int numComponents = getTokens(t, '/', components);
-
-                  int componentIdx = 0;
-
-                  for (int compIdx = 0; compIdx < numComponents; ++compIdx) {
-                    string component = components[compIdx];
-                    switch (componentIdx) {
-                      case 0:
-                        v[idx - 1] = atoi(component.c_str());
-                        break;
-                      case 1:
-                        textC.push_back(atoi(
-                            component.c_str()));
-                        break;
-                      case 2:
-                        n.push_back(atoi(component.c_str()));
-                        break;
-                      default:
-                        throw Exception("Unexpected component index number while parsing Wavefront file.");
-                        break;
-                    }
-                    ++componentIdx;
-                  }
+        }
+        else if (pos[0] == 'f' && (pos[1] == ' ' || pos[1] == '\t')) {
+          parseFace(pos + 1, lineEnd);
+        }
+      }
 
-                }
+      pos = lineEnd == dataEnd ? dataEnd : lineEnd + 1;
+    }
+  }
 
-                else   // just the vertex index is contained in the string
-                {
-                  v[idx - 1] = atoi(t.c_str());
-                }
-              }
-              ++idx;
-            }
-            facesVertexIndices.push_back(v);
-            if (!n.empty())
-              facesNormalIndices.push_back(n);
-            if (!textC.empty())
-              textureCoordsIndices.push_back(textC);
-          }
+  void WavefrontLoader::parseDataInParallel(const char* data, const char* dataEnd) {
+    size_t dataSize = static_cast<size_t>(dataEnd - data);
+    size_t numChunks = static_cast<size_t>(parsingThreads);
+
+    if (numChunks == 0) {
+      numChunks = min(static_cast<size_t>(thread::hardware_concurrency()), dataSize / minParsingChunkSize);
+    }
+    numChunks = min(numChunks, dataSize);
+
+    if (numChunks < 2) {
+      parseData(data, dataEnd);
+      return;
+    }
+
+    // Each chunk ends right after a line feed, so that no line is split
+    vector<const char*> chunkStarts(numChunks + 1);
+    chunkStarts[0] = data;
+    chunkStarts[numChunks] = dataEnd;
+
+    for (size_t chunk = 1; chunk != numChunks; ++chunk) {
+      const char* pos = max(data + dataSize * chunk / numChunks, chunkStarts[chunk - 1]);
+      const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(dataEnd - pos)));
+      chunkStarts[chunk] = lineEnd == NULL ? dataEnd : lineEnd + 1;
+    }
 
+    // Each chunk is parsed by a loader of its own, into its own data arrays
+    vector<unique_ptr<WavefrontLoader> > chunkLoaders(numChunks);
+
+    parallelFor(static_cast<int>(numChunks), [&](const int &chunk) {
+      chunkLoaders[static_cast<size_t>(chunk)] = unique_ptr<WavefrontLoader>(new WavefrontLoader());
+      chunkLoaders[static_cast<size_t>(chunk)]->parseData(chunkStarts[static_cast<size_t>(chunk)],
+                                                          chunkStarts[static_cast<size_t>(chunk) + 1]);
+    });
+
+    size_t numVertices = 0, numNormals = 0, numTextureCoords = 0;
+    size_t numFaceVertices = 0, numFaceNormals = 0, numFaceTextureCoords = 0;
+
+    for (size_t chunk = 0; chunk != numChunks; ++chunk) {
+      numVertices += chunkLoaders[chunk]->vertices.size();
+      numNormals += chunkLoaders[chunk]->normals.size();
+      numTextureCoords += chunkLoaders[chunk]->textureCoords.size();
+      numFaceVertices += chunkLoaders[chunk]->facesVertexIndices.size();
+      numFaceNormals += chunkLoaders[chunk]->facesNormalIndices.size();
+      numFaceTextureCoords += chunkLoaders[chunk]->textureCoordsIndices.size();
+    }
+
+    vertices.reserve(numVertices);
+    normals.reserve(numNormals);
+    textureCoords.reserve(numTextureCoords);
+    facesVertexIndices.reserve(numFaceVertices);
+    facesNormalIndices.reserve(numFaceNormals);
+    textureCoordsIndices.reserve(numFaceTextureCoords);
+
+    // The indices in the faces of Wavefront files are counted from the start of the
+    // file, not of the chunk, so the chunks are joined as they are, in order
+    for (size_t chunk = 0; chunk != numChunks; ++chunk) {
+      WavefrontLoader &chunkLoader = *chunkLoaders[chunk];
+      vertices.insert(vertices.end(), chunkLoader.vertices.begin(), chunkLoader.vertices.end());
+      normals.insert(normals.end(), chunkLoader.normals.begin(), chunkLoader.normals.end());
+      textureCoords.insert(textureCoords.end(), chunkLoader.textureCoords.begin(), chunkLoader.textureCoords.end());
+      facesVertexIndices.insert(facesVertexIndices.end(), chunkLoader.facesVertexIndices.begin(),
+                                chunkLoader.facesVertexIndices.end());
+      facesNormalIndices.insert(facesNormalIndices.end(), chunkLoader.facesNormalIndices.begin(),
+                                chunkLoader.facesNormalIndices.end());
+      textureCoordsIndices.insert(textureCoordsIndices.end(), chunkLoader.textureCoordsIndices.begin(),
+                                  chunkLoader.textureCoordsIndices.end());
+      chunkLoaders[chunk].reset();
+    }
+  }
+
+  void WavefrontLoader::setParsingThreads(const int &numThreads) {
+    parsingThreads = numThreads > 0 ? numThreads : 0;
+  }
+
+  void WavefrontLoader::setMeshCacheDirectory(const string &directory) {
+    meshCacheDirectory = directory;
+  }
+
+  string WavefrontLoader::getMeshCacheLocation(const string &fileLocation, const bool &optimisedMesh,
+                                               const string &meshCacheDirectory) {
+    // Models which have not been optimised are cached separately, so that loaders
+    // with different settings do not keep overwriting each other's files
+    string extension = optimisedMesh ? ".s3dmesh" : ".unoptimised.s3dmesh";
+
+    string location = fileLocation;
+    size_t extensionPos = location.rfind('.');
+    size_t directoryPos = location.find_last_of("/\\");
+    if (extensionPos != string::npos && (directoryPos == string::npos || extensionPos > directoryPos)) {
+      location = location.substr(0, extensionPos);
+    }
+
+    if (meshCacheDirectory != "") {
+      // Flattened into a single name, within the cache directory
+      replace(location.begin(), location.end(), '/', '_');
+      replace(location.begin(), location.end(), '\\', '_');
+      replace(location.begin(), location.end(), ':', '_');
+      location = meshCacheDirectory + location;
+    }
+
+    return location + extension;
+  }
+
+  void WavefrontLoader::loadCompactData(Model &model) {
+    if (quantise) {
+      quantiseVertexData(model);
+    }
+    else {
+      // Do not leave data from a previously loaded model behind
+      vector<float>().swap(model.compactVertexData);
+      vector<unsigned int>().swap(model.packedNormalsData);
+      vector<unsigned short>().swap(model.halfTextureCoordsData);
+    }
+  }
+
+  bool WavefrontLoader::loadLevelsOfDetail(Model &model) {
+    size_t numLevels = levelsOfDetail > 1 ? static_cast<size_t>(levelsOfDetail) : 1;
+    size_t numLoadedLevels = model.getNumLevelsOfDetail();
+
+    if (numLoadedLevels > numLevels) {
+      // Only drop the extra ones from the model, not from the .s3dmesh file, from
+      // which other loaders may still want them
+      model.lodIndexData.resize(numLevels - 1);
+      return false;
+    }
+
+    if (numLoadedLevels < numLevels) {
+      // Simplification may stop before reaching the requested number of levels, in
+      // which case the same levels are generated again and there is nothing to save
+      generateLevelsOfDetail(model, levelsOfDetail);
+      return model.getNumLevelsOfDetail() != numLoadedLevels;
+    }
+
+    return false;
+  }
+
+  void WavefrontLoader::saveMeshCache(const string &meshCacheLocation, const Model &model,
+                                      const string &fileLocation) {
+    try {
+      BinaryMeshLoader binaryMeshLoader;
+      binaryMeshLoader.save(meshCacheLocation, model, fileLocation);
+    }
+    catch (const Exception &) {
+      // The cache is only an optimisation (the directory may well be read-only),
+      // so the model is still usable if it cannot be written.
+    }
+  }
+
+  void WavefrontLoader::load(const string &fileLocation, Model &model) {
+
+    string meshCacheLocation;
+
+    if (useMeshCache) {
+      meshCacheLocation = getMeshCacheLocation(fileLocation, optimiseMesh, meshCacheDirectory);
+      BinaryMeshLoader binaryMeshLoader;
+      if (binaryMeshLoader.tryLoad(meshCacheLocation, model, fileLocation)) {
+        // The cached model may have been saved by a loader which generated a different number
+        // of levels of detail
+        if (loadLevelsOfDetail(model)) {
+          saveMeshCache(meshCacheLocation, model, fileLocation);
         }
+        loadCompactData(model);
+        return;
       }
-      file.close();
+    }
 
-      if (textureCoords.size() > 0) {
-        this->correctDataVectors();
+    string filePath = SDL_GetBasePath() + fileLocation;
+
+    init();
+    this->model = &model;
+
+    if (memoryMapped) {
+      MappedFile file(filePath);
+      parseDataInParallel(file.getData(), file.getData() + file.getSize());
+    }
+    else {
+      ifstream file(filePath.c_str());
+      if (!file.is_open()) {
+        throw Exception("Could not open file " + filePath);
       }
+      parseStream(file);
+      file.close();
+    }
 
-      // Generate the data and delete the initial buffers
-      this->loadVertexData();
-      this->loadIndexData();
-      this->loadNormalsData();
-      this->loadTextureCoordsData();
-      this->clear();
+    this->weldVertices();
+
+    // Generate the data and delete the initial buffers
+    this->loadVertexData();
+    this->loadIndexData();
+    this->loadNormalsData();
+    this->loadTextureCoordsData();
+    this->clear();
+
+    if (optimiseMesh) {
+      float acmr = calculateACMR(model);
+      optimiseVertexCache(model);
+      optimiseVertexFetch(model);
+      stringstream ss;
+      ss << "Optimised " << fileLocation << ": ACMR " << acmr << " before, " << calculateACMR(model) << " after";
+      LOGINFO(ss.str());
+    }
+
+    loadLevelsOfDetail(model);
+
+    model.calculateBoundingVolumes();
 
+    if (useMeshCache) {
+      saveMeshCache(meshCacheLocation, model, fileLocation);
     }
-    else
-      throw Exception(
-          "Could not open file " + string(SDL_GetBasePath())
-          + fileLocation);
+
+    loadCompactData(model);
   }
 
 }
@@ -14,14 +14,38 @@
 #endif
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <set>
+#include <limits>
+#include <thread>
 #include "Logger.hpp"
 #include "Image.hpp"
 #include "Model.hpp"
 #include "BoundingBoxes.hpp"
 #include "ModelLoader.hpp"
 #include "WavefrontLoader.hpp"
+#include "BinaryMeshLoader.hpp"
+#include "MeshOptimisation.hpp"
+#include "MeshSimplification.hpp"
+#include "VertexQuantisation.hpp"
+#include "ParseNumbers.hpp"
 #include "SceneObject.hpp"
+#include "AsyncSceneObject.hpp"
+#include "ModelCache.hpp"
+#include "FrameAnimation.hpp"
+#include "Exception.hpp"
+#include "MathFunctions.hpp"
 #include "Renderer.hpp"
+#include "Frustum.hpp"
+#include "OcclusionBuffer.hpp"
 
 
 
@@ -54,6 +78,29 @@ TEST(LoggerTest, LogSomething) {
   EXPECT_TRUE(oss.str().find("Error test") != (string::npos));
   deleteLogger();
 
+  // Nothing is logged without a logger
+  LOGINFO("Not logged");
+  EXPECT_TRUE(oss.str().find("Not logged") == (string::npos));
+
+  // Messages can be logged on several threads while the logger is replaced
+  ostringstream firstStream, secondStream;
+  initLogger(firstStream);
+  vector<thread> threads;
+  for (int idx = 0; idx < 4; ++idx) {
+    threads.push_back(thread([]() {
+      for (int message = 0; message < 1000; ++message) {
+        LOGINFO("Logged on a thread");
+      }
+    }));
+  }
+  deleteLogger();
+  initLogger(secondStream);
+  for (size_t idx = 0; idx < threads.size(); ++idx) {
+    threads[idx].join();
+  }
+  EXPECT_TRUE(firstStream.str().find("Logger getting destroyed") != (string::npos));
+  deleteLogger();
+
 }
 
 TEST(ImageTest, LoadImage) {
@@ -131,6 +178,1122 @@ TEST(ModelTest, LoadModel) {
 
 }
 
+TEST(ModelTest, WeldVertices) {
+
+  Model model;
+  unique_ptr<ModelLoader> loader(new WavefrontLoader(true, false));
+
+  // The cube has 8 positions, but 24 unique position - texture coordinates - normal
+  // combinations are referenced by its faces (and 36 face corners)
+  loader->load("resources/models/Cube/Cube.obj", model);
+
+  EXPECT_EQ(24 * 4, model.vertexData.size());
+  EXPECT_EQ(24 * 3, model.normalsData.size());
+  EXPECT_EQ(24 * 2, model.textureCoordsData.size());
+  EXPECT_EQ(36, model.getNumIndexes());
+
+  // Every vertex is unique and referenced by at least one face
+  vector<bool> referenced(24, false);
+  for (size_t idx = 0; idx < model.getNumIndexes(); ++idx) {
+    ASSERT_LT(model.indexData[idx], 24u);
+    referenced[model.indexData[idx]] = true;
+  }
+
+  for (size_t vertex = 0; vertex < 24; ++vertex) {
+    EXPECT_TRUE(referenced[vertex]);
+    for (size_t otherVertex = vertex + 1; otherVertex < 24; ++otherVertex) {
+      EXPECT_FALSE(equal(&model.vertexData[4 * vertex], &model.vertexData[4 * vertex + 4],
+                         &model.vertexData[4 * otherVertex]) &&
+                   equal(&model.normalsData[3 * vertex], &model.normalsData[3 * vertex + 3],
+                         &model.normalsData[3 * otherVertex]) &&
+                   equal(&model.textureCoordsData[2 * vertex], &model.textureCoordsData[2 * vertex + 2],
+                         &model.textureCoordsData[2 * otherVertex]));
+    }
+  }
+}
+
+TEST(ModelTest, OptimiseMesh) {
+
+  const char* models[] = {"resources/models/Goat/goatAnim_000001.obj",
+                          "resources/models/Bug/bugAnim_000001.obj",
+                          "resources/models/Tree/tree.obj"};
+
+  unique_ptr<ModelLoader> loader(new WavefrontLoader(true, false, false));
+  unique_ptr<ModelLoader> optimisingLoader(new WavefrontLoader(true, false, true));
+
+  for (int idx = 0; idx < 3; ++idx) {
+    Model model, optimisedModel;
+    loader->load(models[idx], model);
+    optimisingLoader->load(models[idx], optimisedModel);
+
+    float acmr = calculateACMR(model);
+    float optimisedAcmr = calculateACMR(optimisedModel);
+
+    cout << models[idx] << " ACMR before optimisation: " << acmr << ", after: " << optimisedAcmr << endl;
+
+    EXPECT_LE(optimisedAcmr, acmr);
+    EXPECT_EQ(model.vertexData.size(), optimisedModel.vertexData.size());
+    ASSERT_EQ(model.getNumIndexes(), optimisedModel.getNumIndexes());
+
+    // The vertices are referenced in order
+    unsigned int nextVertex = 0;
+    for (size_t index = 0; index < optimisedModel.getNumIndexes(); ++index) {
+      EXPECT_LE(optimisedModel.indexData[index], nextVertex);
+      if (optimisedModel.indexData[index] == nextVertex) ++nextVertex;
+    }
+
+    // The same triangles are drawn, with the same vertices
+    multiset<vector<float> > triangles, optimisedTriangles;
+    for (size_t index = 0; index < model.getNumIndexes(); index += 3) {
+      vector<float> triangle, optimisedTriangle;
+      for (size_t corner = 0; corner < 3; ++corner) {
+        unsigned int vertex = model.indexData[index + corner];
+        unsigned int optimisedVertex = optimisedModel.indexData[index + corner];
+        triangle.insert(triangle.end(), &model.vertexData[4 * vertex], &model.vertexData[4 * vertex + 4]);
+        triangle.insert(triangle.end(), &model.normalsData[3 * vertex], &model.normalsData[3 * vertex + 3]);
+        optimisedTriangle.insert(optimisedTriangle.end(), &optimisedModel.vertexData[4 * optimisedVertex],
+                                 &optimisedModel.vertexData[4 * optimisedVertex + 4]);
+        optimisedTriangle.insert(optimisedTriangle.end(), &optimisedModel.normalsData[3 * optimisedVertex],
+                                 &optimisedModel.normalsData[3 * optimisedVertex + 3]);
+      }
+      triangles.insert(triangle);
+      optimisedTriangles.insert(optimisedTriangle);
+    }
+    EXPECT_TRUE(triangles == optimisedTriangles);
+  }
+}
+
+TEST(ModelTest, QuantiseVertexData) {
+
+  // Half floats
+  EXPECT_EQ(0.0f, halfToFloat(floatToHalf(0.0f)));
+  EXPECT_EQ(1.0f, halfToFloat(floatToHalf(1.0f)));
+  EXPECT_EQ(-2.5f, halfToFloat(floatToHalf(-2.5f)));
+  EXPECT_EQ(65504.0f, halfToFloat(floatToHalf(65504.0f)));
+  EXPECT_EQ(0x7c00, floatToHalf(100000.0f));
+  EXPECT_EQ(0x0001, floatToHalf(1.0f / 16777216.0f));
+  EXPECT_EQ(1.0f / 16777216.0f, halfToFloat(0x0001));
+  EXPECT_EQ(0x3c00, floatToHalf(1.0f + 1.0f / 4096.0f)); // Tie, rounded to even
+  EXPECT_EQ(0x3c01, floatToHalf(1.0f + 3.0f / 4096.0f)); // Tie, rounded to even
+
+  // Packed normals
+  float x, y, z;
+  unpackNormal(packNormal(1.0f, -1.0f, 0.0f), x, y, z);
+  EXPECT_EQ(1.0f, x);
+  EXPECT_EQ(-1.0f, y);
+  EXPECT_EQ(0.0f, z);
+
+  Model model;
+  unique_ptr<ModelLoader> loader(new WavefrontLoader(true, false, true, true));
+  loader->load("resources/models/Goat/goatAnim_000001.obj", model);
+
+  ASSERT_TRUE(model.isQuantised());
+
+  size_t numVertices = model.vertexData.size() / 4;
+  size_t fullSize = model.vertexData.size() * sizeof(float) + model.normalsData.size() * sizeof(float) +
+                    model.textureCoordsData.size() * sizeof(float);
+  size_t compactSize = model.compactVertexData.size() * sizeof(float) +
+                       model.packedNormalsData.size() * sizeof(unsigned int) +
+                       model.halfTextureCoordsData.size() * sizeof(unsigned short);
+  EXPECT_EQ(36 * numVertices, fullSize);
+  EXPECT_EQ(20 * numVertices, compactSize);
+
+  float maxNormalAngle = 0.0f, maxUvError = 0.0f;
+
+  for (size_t vertex = 0; vertex < numVertices; ++vertex) {
+    for (size_t component = 0; component < 3; ++component) {
+      EXPECT_EQ(model.vertexData[4 * vertex + component], model.compactVertexData[3 * vertex + component]);
+    }
+
+    // The angle between the original and the decoded normal
+    unpackNormal(model.packedNormalsData[vertex], x, y, z);
+    const float* normal = &model.normalsData[3 * vertex];
+    float cosAngle = (x * normal[0] + y * normal[1] + z * normal[2]) /
+                     sqrt((x * x + y * y + z * z) * (normal[0] * normal[0] + normal[1] * normal[1] +
+                                                     normal[2] * normal[2]));
+    maxNormalAngle = max(maxNormalAngle, acos(min(cosAngle, 1.0f)) * 180.0f / 3.14159265f);
+
+    for (size_t component = 0; component < 2; ++component) {
+      float uv = model.textureCoordsData[2 * vertex + component];
+      float error = abs(halfToFloat(model.halfTextureCoordsData[2 * vertex + component]) - uv);
+      // Half floats have an 11-bit significand
+      EXPECT_LE(error, max(abs(uv), 1.0f / 16384.0f) / 2048.0f);
+      maxUvError = max(maxUvError, error);
+    }
+  }
+
+  cout << "Quantised goat: " << compactSize << " bytes instead of " << fullSize << ", maximum normal error "
+  << maxNormalAngle << " degrees, maximum texture coordinate error " << maxUvError << endl;
+
+  EXPECT_LT(maxNormalAngle, 0.25f);
+
+  // Loaders that do not quantise leave no compact data behind
+  unique_ptr<ModelLoader> fullLoader(new WavefrontLoader(true, false));
+  fullLoader->load("resources/models/Goat/goatAnim_000001.obj", model);
+  EXPECT_FALSE(model.isQuantised());
+  EXPECT_EQ(0, model.compactVertexData.size());
+}
+
+TEST(ParseNumbersTest, ParseFloatAndInt) {
+
+  const char* numbers[] = {"0.310413", "-0.175515", "1.000000", "0.000001", "-0", "42",
+                           "3.4028234e38", "1.5E-3", "123456789012345678901234", ".5"};
+
+  for (int idx = 0; idx < 10; ++idx) {
+    float value = -1.0f;
+    const char* end = numbers[idx] + strlen(numbers[idx]);
+    EXPECT_EQ(end, parseFloat(numbers[idx], end, value));
+    EXPECT_EQ(static_cast<float>(atof(numbers[idx])), value) << numbers[idx];
+  }
+
+  const char notANumber[] = "abc";
+  float value = 0.0f;
+  EXPECT_EQ(notANumber, parseFloat(notANumber, notANumber + 3, value));
+
+  const char index[] = "-12/3";
+  int intValue = 0;
+  EXPECT_EQ(index + 3, parseInt(index, index + 5, intValue));
+  EXPECT_EQ(-12, intValue);
+}
+
+TEST(ModelTest, MemoryMappedLoadMatchesStreamedLoad) {
+
+  const char* models[] = {"resources/models/Cube/Cube.obj",
+                          "resources/models/Cube/CubeNoTexture.obj",
+                          "resources/models/Goat/goatAnim_000001.obj",
+                          "resources/models/Bug/bugAnim_000001.obj",
+                          "resources/models/Tree/tree.obj"};
+
+  unique_ptr<ModelLoader> mappedLoader(new WavefrontLoader(true, false));
+  unique_ptr<ModelLoader> streamedLoader(new WavefrontLoader(false, false));
+
+  for (int idx = 0; idx < 5; ++idx) {
+    Model mappedModel, streamedModel;
+    mappedLoader->load(models[idx], mappedModel);
+    streamedLoader->load(models[idx], streamedModel);
+
+    EXPECT_EQ(streamedModel.vertexData, mappedModel.vertexData) << models[idx];
+    EXPECT_EQ(streamedModel.indexData, mappedModel.indexData) << models[idx];
+    EXPECT_EQ(streamedModel.normalsData, mappedModel.normalsData) << models[idx];
+    EXPECT_EQ(streamedModel.textureCoordsData, mappedModel.textureCoordsData) << models[idx];
+    EXPECT_EQ(streamedModel.vertexDataSize, mappedModel.vertexDataSize);
+    EXPECT_EQ(streamedModel.indexDataSize, mappedModel.indexDataSize);
+    EXPECT_EQ(streamedModel.normalsDataSize, mappedModel.normalsDataSize);
+    EXPECT_EQ(streamedModel.textureCoordsDataSize, mappedModel.textureCoordsDataSize);
+  }
+
+  // Benchmark, loading the goat and bug animations and the tree
+  for (int mapped = 0; mapped < 2; ++mapped) {
+    unique_ptr<ModelLoader> loader(new WavefrontLoader(mapped == 1, false));
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    for (int frame = 1; frame <= 19; ++frame) {
+      stringstream ss;
+      ss << setfill('0') << setw(6) << frame;
+      Model model;
+      loader->load("resources/models/Goat/goatAnim_" + ss.str() + ".obj", model);
+      if (frame <= 9) {
+        Model bugModel;
+        loader->load("resources/models/Bug/bugAnim_" + ss.str() + ".obj", bugModel);
+      }
+    }
+    Model treeModel;
+    loader->load("resources/models/Tree/tree.obj", treeModel);
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    cout << (mapped == 1 ? "Memory mapped" : "Streamed") << " loading of goat, bug and tree: "
+    << elapsed.count() << " ms" << endl;
+  }
+}
+
+// Write a square grid of the given number of faces (rounded up) to a Wavefront file,
+// with one position, normal and texture coordinates pair per grid point
+static void writeGridModel(const string &fileLocation, const int &numFaces) {
+  int numQuads = 1;
+  while (2 * numQuads * numQuads < numFaces) ++numQuads;
+  int numPoints = numQuads + 1;
+
+  ofstream gridFile((SDL_GetBasePath() + fileLocation).c_str());
+  for (int row = 0; row < numPoints; ++row) {
+    for (int column = 0; column < numPoints; ++column) {
+      gridFile << "v " << column * 0.01f << " " << sin(row * 0.1f + column * 0.2f) << " " << row * -0.01f << "\n";
+    }
+  }
+  for (int row = 0; row < numPoints; ++row) {
+    for (int column = 0; column < numPoints; ++column) {
+      gridFile << "vt " << static_cast<float>(column) / numQuads << " " << static_cast<float>(row) / numQuads << "\n";
+    }
+  }
+  for (int row = 0; row < numPoints; ++row) {
+    for (int column = 0; column < numPoints; ++column) {
+      gridFile << "vn " << cos(column * 0.3f) << " " << sin(row * 0.3f) << " 0.5\n";
+    }
+  }
+  for (int row = 0; row < numQuads; ++row) {
+    for (int column = 0; column < numQuads; ++column) {
+      int corners[4] = {row * numPoints + column + 1, row * numPoints + column + 2,
+                        (row + 1) * numPoints + column + 2, (row + 1) * numPoints + column + 1};
+      gridFile << "f " << corners[0] << "/" << corners[0] << "/" << corners[0] << " "
+      << corners[1] << "/" << corners[1] << "/" << corners[1] << " "
+      << corners[2] << "/" << corners[2] << "/" << corners[2] << "\n";
+      gridFile << "f " << corners[2] << "/" << corners[2] << "/" << corners[2] << " "
+      << corners[3] << "/" << corners[3] << "/" << corners[3] << " "
+      << corners[0] << "/" << corners[0] << "/" << corners[0] << "\n";
+    }
+  }
+}
+
+TEST(ModelTest, ParallelParsingMatchesSerialParsing) {
+
+  const char* models[] = {"resources/models/Cube/Cube.obj",
+                          "resources/models/Goat/goatAnim_000001.obj",
+                          "resources/models/Tree/tree.obj"};
+
+  WavefrontLoader serialLoader(true, false, false);
+  serialLoader.setParsingThreads(1);
+
+  for (int idx = 0; idx < 3; ++idx) {
+    Model serialModel;
+    serialLoader.load(models[idx], serialModel);
+
+    // More chunks than lines, too, for the cube
+    int numThreads[] = {2, 3, 7, 100};
+
+    for (int threadsIdx = 0; threadsIdx < 4; ++threadsIdx) {
+      WavefrontLoader parallelLoader(true, false, false);
+      parallelLoader.setParsingThreads(numThreads[threadsIdx]);
+      Model parallelModel;
+      parallelLoader.load(models[idx], parallelModel);
+
+      EXPECT_EQ(serialModel.vertexData, parallelModel.vertexData) << models[idx];
+      EXPECT_EQ(serialModel.indexData, parallelModel.indexData) << models[idx];
+      EXPECT_EQ(serialModel.normalsData, parallelModel.normalsData) << models[idx];
+      EXPECT_EQ(serialModel.textureCoordsData, parallelModel.textureCoordsData) << models[idx];
+    }
+  }
+
+  // Benchmark, on generated models of increasing size, with as many threads as the
+  // hardware supports. The models take long to generate and parse (the largest one takes
+  // up more than 600MB), so this only runs if the SMALL3D_LARGE_BENCHMARKS environment
+  // variable is set.
+  if (getenv("SMALL3D_LARGE_BENCHMARKS") == NULL) {
+    return;
+  }
+
+  int numFaces[] = {100000, 1000000, 10000000};
+  int maxThreads = max(2, static_cast<int>(thread::hardware_concurrency()));
+
+  for (int sizeIdx = 0; sizeIdx < 3; ++sizeIdx) {
+    string gridLocation = "resources/models/grid.obj";
+    writeGridModel(gridLocation, numFaces[sizeIdx]);
+
+    Model serialModel;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+      WavefrontLoader loader(true, false, false);
+      loader.setParsingThreads(threads);
+      Model model;
+      chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+      loader.load(gridLocation, model);
+      chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+      cout << numFaces[sizeIdx] << " faces, " << threads << " thread(s): " << elapsed.count() << " ms" << endl;
+
+      if (threads == 1) {
+        serialModel = model;
+      }
+      else {
+        EXPECT_TRUE(serialModel.vertexData == model.vertexData);
+        EXPECT_TRUE(serialModel.indexData == model.indexData);
+        EXPECT_TRUE(serialModel.normalsData == model.normalsData);
+        EXPECT_TRUE(serialModel.textureCoordsData == model.textureCoordsData);
+      }
+    }
+
+    remove((SDL_GetBasePath() + gridLocation).c_str());
+  }
+}
+
+// The area of the triangles of a level of detail of a model, projected on the xz plane
+static float projectedArea(const Model &model, const size_t &level) {
+  float area = 0.0f;
+  for (size_t index = 0; index < model.getNumIndexes(level); index += 3) {
+    const float* corners[3];
+    for (size_t corner = 0; corner < 3; ++corner) {
+      unsigned int vertex = model.getIndexData(level)[index + corner];
+      corners[corner] = &model.vertexData[4 * vertex];
+    }
+    area += ((corners[1][0] - corners[0][0]) * (corners[2][2] - corners[0][2]) -
+             (corners[2][0] - corners[0][0]) * (corners[1][2] - corners[0][2])) / 2.0f;
+  }
+  return area;
+}
+
+TEST(ModelTest, GenerateLevelsOfDetail) {
+
+  string gridLocation = "resources/models/grid.obj";
+  writeGridModel(gridLocation, 20000);
+
+  const char* models[] = {"resources/models/Goat/goatAnim_000001.obj",
+                          "resources/models/Tree/tree.obj",
+                          gridLocation.c_str()};
+
+  WavefrontLoader loader(true, false, true, false, 4);
+
+  for (int idx = 0; idx < 3; ++idx) {
+    Model model;
+    loader.load(models[idx], model);
+
+    ASSERT_GT(model.getNumLevelsOfDetail(), 1u) << models[idx];
+    cout << models[idx] << " levels of detail:";
+
+    for (size_t level = 0; level < model.getNumLevelsOfDetail(); ++level) {
+      cout << " " << model.getNumIndexes(level) / 3;
+      EXPECT_EQ(0u, model.getNumIndexes(level) % 3);
+      if (level > 0) {
+        EXPECT_LT(model.getNumIndexes(level), model.getNumIndexes(level - 1) * 9 / 10);
+      }
+
+      // The levels use the model's vertices and have no degenerate triangles
+      const vector<unsigned int> &indices = model.getIndexData(level);
+      for (size_t index = 0; index < model.getNumIndexes(level); index += 3) {
+        ASSERT_LT(indices[index], model.vertexData.size() / 4);
+        ASSERT_LT(indices[index + 1], model.vertexData.size() / 4);
+        ASSERT_LT(indices[index + 2], model.vertexData.size() / 4);
+        EXPECT_FALSE(indices[index] == indices[index + 1] || indices[index + 1] == indices[index + 2] ||
+                     indices[index + 2] == indices[index]);
+      }
+    }
+    cout << " triangles" << endl;
+  }
+
+  // The grid keeps its outline and its triangles are not flipped, so the area it covers,
+  // seen from above, stays the same at every level
+  Model grid;
+  loader.load(gridLocation, grid);
+  EXPECT_EQ(4u, grid.getNumLevelsOfDetail());
+  EXPECT_LT(grid.getNumIndexes(3), grid.getNumIndexes() / 6);
+  for (size_t level = 1; level < grid.getNumLevelsOfDetail(); ++level) {
+    EXPECT_NEAR(projectedArea(grid, 0), projectedArea(grid, level), fabs(projectedArea(grid, 0)) * 0.01f);
+  }
+
+  // The levels of detail are kept in the .s3dmesh file and optimised along with the model
+  BinaryMeshLoader binaryMeshLoader;
+  binaryMeshLoader.save("resources/models/gridExport.s3dmesh", grid);
+  Model exportedGrid;
+  binaryMeshLoader.load("resources/models/gridExport.s3dmesh", exportedGrid);
+  EXPECT_EQ(grid.lodIndexData, exportedGrid.lodIndexData);
+  remove((SDL_GetBasePath() + string("resources/models/gridExport.s3dmesh")).c_str());
+
+  EXPECT_EQ(3u, exportedGrid.lodIndexData.size());
+  optimiseVertexFetch(exportedGrid);
+  EXPECT_NEAR(projectedArea(grid, 3), projectedArea(exportedGrid, 3), fabs(projectedArea(grid, 3)) * 0.0001f);
+
+  // Loaders which do not want the levels of detail drop them
+  WavefrontLoader plainLoader(true, false);
+  plainLoader.load(gridLocation, grid);
+  EXPECT_EQ(1u, grid.getNumLevelsOfDetail());
+
+  // Loaders which want a different number of levels than the .s3dmesh file has
+  // generate the missing ones or drop the extra ones
+  WavefrontLoader twoLevelLoader(true, true, false, false, 2);
+  twoLevelLoader.setMeshCacheDirectory("resources/");
+  WavefrontLoader fourLevelLoader(true, true, false, false, 4);
+  fourLevelLoader.setMeshCacheDirectory("resources/");
+  string cachedLocation = WavefrontLoader::getMeshCacheLocation(gridLocation, false, "resources/");
+
+  twoLevelLoader.load(gridLocation, grid);
+  EXPECT_EQ(2u, grid.getNumLevelsOfDetail());
+  fourLevelLoader.load(gridLocation, grid);
+  EXPECT_EQ(4u, grid.getNumLevelsOfDetail());
+  twoLevelLoader.load(gridLocation, grid);
+  EXPECT_EQ(2u, grid.getNumLevelsOfDetail());
+  Model cachedGrid;
+  binaryMeshLoader.load(cachedLocation, cachedGrid);
+  EXPECT_EQ(4u, cachedGrid.getNumLevelsOfDetail());
+  remove((SDL_GetBasePath() + cachedLocation).c_str());
+
+  remove((SDL_GetBasePath() + gridLocation).c_str());
+}
+
+TEST(ModelTest, CalculateBoundingVolumes) {
+
+  // Not calculated until the model is loaded
+  Model model;
+  EXPECT_LT(model.boundingSphereRadius, 0.0f);
+
+  WavefrontLoader loader;
+  loader.load("resources/models/Goat/goatAnim_000001.obj", model);
+  EXPECT_GT(model.boundingSphereRadius, 0.0f);
+
+  glm::vec3 boxCentre = (model.boundingBoxMin + model.boundingBoxMax) * 0.5f;
+  for (int component = 0; component < 3; ++component) {
+    EXPECT_LT(model.boundingBoxMin[component], model.boundingBoxMax[component]);
+    EXPECT_NEAR(boxCentre[component], model.boundingSphereCentre[component], 1e-5f);
+  }
+
+  // Every vertex is in both volumes and some touch each side of the box
+  bool touchesMin[3] = {false, false, false}, touchesMax[3] = {false, false, false};
+  for (size_t vertex = 0; vertex < model.vertexData.size() / 4; ++vertex) {
+    glm::vec3 position(model.vertexData[4 * vertex], model.vertexData[4 * vertex + 1],
+                       model.vertexData[4 * vertex + 2]);
+    for (int component = 0; component < 3; ++component) {
+      EXPECT_GE(position[component], model.boundingBoxMin[component]);
+      EXPECT_LE(position[component], model.boundingBoxMax[component]);
+      touchesMin[component] |= position[component] == model.boundingBoxMin[component];
+      touchesMax[component] |= position[component] == model.boundingBoxMax[component];
+    }
+    EXPECT_LE(glm::distance(position, model.boundingSphereCentre), model.boundingSphereRadius + 1e-5f);
+  }
+  for (int component = 0; component < 3; ++component) {
+    EXPECT_TRUE(touchesMin[component]);
+    EXPECT_TRUE(touchesMax[component]);
+  }
+
+  // Models loaded from .s3dmesh files get the same bounding volumes
+  BinaryMeshLoader binaryMeshLoader;
+  binaryMeshLoader.save("resources/models/goatExport.s3dmesh", model);
+  Model exportedModel;
+  binaryMeshLoader.load("resources/models/goatExport.s3dmesh", exportedModel);
+  remove((SDL_GetBasePath() + string("resources/models/goatExport.s3dmesh")).c_str());
+  EXPECT_EQ(model.boundingSphereRadius, exportedModel.boundingSphereRadius);
+  for (int component = 0; component < 3; ++component) {
+    EXPECT_EQ(model.boundingBoxMin[component], exportedModel.boundingBoxMin[component]);
+    EXPECT_EQ(model.boundingBoxMax[component], exportedModel.boundingBoxMax[component]);
+  }
+}
+
+TEST(BinaryMeshLoaderTest, SaveAndLoad) {
+
+  Model model;
+  unique_ptr<ModelLoader> loader(new WavefrontLoader(true, false));
+  loader->load("resources/models/Cube/Cube.obj", model);
+
+  BinaryMeshLoader binaryMeshLoader;
+  binaryMeshLoader.save("resources/models/Cube/CubeExport.s3dmesh", model);
+
+  Model exportedModel;
+  binaryMeshLoader.load("resources/models/Cube/CubeExport.s3dmesh", exportedModel);
+
+  EXPECT_EQ(model.vertexData, exportedModel.vertexData);
+  EXPECT_EQ(model.indexData, exportedModel.indexData);
+  EXPECT_EQ(model.normalsData, exportedModel.normalsData);
+  EXPECT_EQ(model.textureCoordsData, exportedModel.textureCoordsData);
+  EXPECT_EQ(model.vertexDataSize, exportedModel.vertexDataSize);
+  EXPECT_EQ(model.indexDataSize, exportedModel.indexDataSize);
+  EXPECT_EQ(model.normalsDataSize, exportedModel.normalsDataSize);
+  EXPECT_EQ(model.textureCoordsDataSize, exportedModel.textureCoordsDataSize);
+
+  // Outdated (saved from another file) and corrupt files are rejected
+  EXPECT_FALSE(binaryMeshLoader.tryLoad("resources/models/Cube/CubeExport.s3dmesh", exportedModel,
+                                        "resources/models/Cube/Cube.obj"));
+
+  string exportPath = string(SDL_GetBasePath()) + "resources/models/Cube/CubeExport.s3dmesh";
+  fstream exportFile(exportPath.c_str(), ios::in | ios::out | ios::binary);
+  exportFile.seekp(100);
+  exportFile.put('x');
+  exportFile.close();
+  EXPECT_FALSE(binaryMeshLoader.tryLoad("resources/models/Cube/CubeExport.s3dmesh", exportedModel));
+  EXPECT_THROW(binaryMeshLoader.load("resources/models/Cube/CubeExport.s3dmesh", exportedModel), Exception);
+  remove(exportPath.c_str());
+
+  // Saving the same model from several threads at once, which must still leave a valid file
+  vector<thread> writers;
+  for (int writer = 0; writer < 8; ++writer) {
+    writers.push_back(thread([&model]() {
+      BinaryMeshLoader writerLoader;
+      for (int save = 0; save < 10; ++save) {
+        writerLoader.save("resources/models/Cube/CubeExport.s3dmesh", model);
+      }
+    }));
+  }
+  for (size_t writer = 0; writer < writers.size(); ++writer) {
+    writers[writer].join();
+  }
+  EXPECT_TRUE(binaryMeshLoader.tryLoad("resources/models/Cube/CubeExport.s3dmesh", exportedModel));
+  EXPECT_EQ(model.vertexData, exportedModel.vertexData);
+  remove(exportPath.c_str());
+
+  // Benchmark, comparing parsing the goat animation, parsing it and saving the
+  // .s3dmesh files (cold start) and reading the .s3dmesh files (warm start),
+  // which are kept in their own directory
+  for (int frame = 1; frame <= 19; ++frame) {
+    remove((string(SDL_GetBasePath()) + WavefrontLoader::getMeshCacheLocation(
+        ModelCache::getFrameLocation("resources/models/Goat/goatAnim", frame), true, "resources/")).c_str());
+  }
+
+  const char* runs[] = {"Parsing only", "Cold start", "Warm start"};
+
+  for (int run = 0; run < 3; ++run) {
+    unique_ptr<WavefrontLoader> goatLoader(new WavefrontLoader(true, run > 0, true));
+    goatLoader->setMeshCacheDirectory("resources/");
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    for (int frame = 1; frame <= 19; ++frame) {
+      stringstream ss;
+      ss << setfill('0') << setw(6) << frame;
+      Model goatModel;
+      goatLoader->load("resources/models/Goat/goatAnim_" + ss.str() + ".obj", goatModel);
+    }
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    cout << runs[run] << ", goat animation: " << elapsed.count() << " ms" << endl;
+  }
+
+  Model parsedModel, cachedModel;
+  unique_ptr<ModelLoader> parsingLoader(new WavefrontLoader(true, false, true));
+  parsingLoader->load("resources/models/Goat/goatAnim_000001.obj", parsedModel);
+  string cachedLocation = WavefrontLoader::getMeshCacheLocation("resources/models/Goat/goatAnim_000001.obj",
+                                                                true, "resources/");
+  EXPECT_EQ("resources/resources_models_Goat_goatAnim_000001.s3dmesh", cachedLocation);
+  EXPECT_TRUE(binaryMeshLoader.tryLoad(cachedLocation, cachedModel, "resources/models/Goat/goatAnim_000001.obj"));
+  EXPECT_FALSE(ifstream((string(SDL_GetBasePath()) + "resources/models/Goat/goatAnim_000001.s3dmesh").c_str()));
+  EXPECT_EQ(parsedModel.vertexData, cachedModel.vertexData);
+  EXPECT_EQ(parsedModel.indexData, cachedModel.indexData);
+  EXPECT_EQ(parsedModel.normalsData, cachedModel.normalsData);
+  EXPECT_EQ(parsedModel.textureCoordsData, cachedModel.textureCoordsData);
+}
+
+TEST(SceneObjectTest, LoadAnimationFrames) {
+
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+  shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim", 19));
+  chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+  cout << "Loaded 19 goat animation frames in " << elapsed.count() << " ms" << endl;
+
+  unique_ptr<ModelLoader> loader(new WavefrontLoader(true, false, true));
+  goat->startAnimating();
+
+  // The frames must be in order
+  for (int frame = 1; frame <= 19; ++frame) {
+    stringstream ss;
+    ss << setfill('0') << setw(6) << frame;
+    Model model;
+    loader->load("resources/models/Goat/goatAnim_" + ss.str() + ".obj", model);
+
+    EXPECT_EQ(model.vertexData, goat->getVertexData());
+    EXPECT_EQ(model.indexData, goat->getModel().indexData);
+    EXPECT_EQ(model.normalsData, goat->getNormalsData());
+    EXPECT_EQ(model.textureCoordsData, goat->getModel().textureCoordsData);
+
+    goat->animate();
+  }
+
+  // There is no 20th frame
+  EXPECT_THROW(SceneObject("goat", "resources/models/Goat/goatAnim", 20), Exception);
+}
+
+TEST(SceneObjectTest, ShareFrameTopology) {
+
+  // Generate an animation from the first frame of the goat, moving its vertices
+  // differently in each frame, but keeping its faces and texture coordinates
+  const int numFrames = 8;
+  string basePath = SDL_GetBasePath();
+  ifstream goatFile((basePath + "resources/models/Goat/goatAnim_000001.obj").c_str());
+  vector<string> lines;
+  string line;
+  while (getline(goatFile, line)) lines.push_back(line);
+  goatFile.close();
+
+  for (int frame = 1; frame <= numFrames; ++frame) {
+    ofstream frameFile((basePath + ModelCache::getFrameLocation("resources/models/Goat/goatWave", frame)).c_str());
+    for (size_t idx = 0; idx < lines.size(); ++idx) {
+      if (lines[idx].compare(0, 2, "v ") == 0) {
+        float x, y, z;
+        sscanf(lines[idx].c_str(), "v %f %f %f", &x, &y, &z);
+        frameFile << "v " << x << " " << y + 0.05f * frame * x << " " << z << endl;
+      }
+      else {
+        frameFile << lines[idx] << endl;
+      }
+    }
+  }
+
+  shared_ptr<SceneObject> wave(new SceneObject("wave", "resources/models/Goat/goatWave", numFrames));
+
+  shared_ptr<const FrameAnimation> frameAnimation = wave->getFrameAnimation();
+  ASSERT_TRUE(frameAnimation != nullptr);
+  EXPECT_EQ(numFrames, frameAnimation->getNumFrames());
+  EXPECT_EQ(&wave->getModel(), frameAnimation->getFirstFrame().get());
+  EXPECT_EQ(numFrames, wave->getNumFrames());
+  EXPECT_EQ(frameAnimation->getFirstFrame(), wave->getFrameModel(numFrames - 1));
+
+  const Model &topology = *wave->getFrameModel(0);
+  size_t frameSize = 0;
+  wave->startAnimating();
+
+  for (int frame = 1; frame <= numFrames; ++frame) {
+    string frameLocation = ModelCache::getFrameLocation("resources/models/Goat/goatWave", frame);
+    Model model;
+    WavefrontLoader loader(true, false);
+    loader.load(frameLocation, model);
+    frameSize += (model.vertexData.size() + model.normalsData.size() + model.textureCoordsData.size()) *
+                 sizeof(float) + model.getNumIndexes() * sizeof(unsigned int);
+
+    // Each frame draws the same triangles as when loaded on its own
+    multiset<vector<float> > triangles, sharedTriangles;
+    for (size_t index = 0; index < model.getNumIndexes(); index += 3) {
+      vector<float> triangle, sharedTriangle;
+      for (size_t corner = 0; corner < 3; ++corner) {
+        unsigned int vertex = model.indexData[index + corner];
+        unsigned int sharedVertex = topology.indexData[index + corner];
+        triangle.insert(triangle.end(), &model.vertexData[4 * vertex], &model.vertexData[4 * vertex + 4]);
+        triangle.insert(triangle.end(), &model.normalsData[3 * vertex], &model.normalsData[3 * vertex + 3]);
+        triangle.insert(triangle.end(), &model.textureCoordsData[2 * vertex], &model.textureCoordsData[2 * vertex + 2]);
+        sharedTriangle.insert(sharedTriangle.end(), &wave->getVertexData()[4 * sharedVertex],
+                              &wave->getVertexData()[4 * sharedVertex + 4]);
+        sharedTriangle.insert(sharedTriangle.end(), &wave->getNormalsData()[3 * sharedVertex],
+                              &wave->getNormalsData()[3 * sharedVertex + 3]);
+        sharedTriangle.insert(sharedTriangle.end(), &topology.textureCoordsData[2 * sharedVertex],
+                              &topology.textureCoordsData[2 * sharedVertex + 2]);
+      }
+      triangles.insert(triangle);
+      sharedTriangles.insert(sharedTriangle);
+    }
+    EXPECT_TRUE(triangles == sharedTriangles) << "Frame " << frame;
+
+    // The model of the object is the shared topology, whatever the current frame
+    EXPECT_EQ(&topology, &wave->getModel());
+
+    // The bounding volumes of the shared topology contain every frame
+    const vector<float> &vertexData = wave->getVertexData();
+    for (size_t vertex = 0; vertex < vertexData.size() / 4; ++vertex) {
+      glm::vec3 position(vertexData[4 * vertex], vertexData[4 * vertex + 1], vertexData[4 * vertex + 2]);
+      for (int component = 0; component < 3; ++component) {
+        EXPECT_GE(position[component], topology.boundingBoxMin[component]);
+        EXPECT_LE(position[component], topology.boundingBoxMax[component]);
+      }
+      EXPECT_LE(glm::distance(position, topology.boundingSphereCentre), topology.boundingSphereRadius + 1e-5f);
+    }
+
+    wave->animate();
+
+    remove((basePath + frameLocation).c_str());
+  }
+
+  cout << "Generated animation: " << frameAnimation->getDataSize() << " bytes with shared topology, "
+  << frameSize << " bytes with separate frames" << endl;
+
+  EXPECT_LT(frameAnimation->getDataSize(), frameSize * 3 / 4);
+
+  // Blending the current frame with the next one
+  wave->resetAnimation();
+  wave->setFrameDelay(4);
+  wave->animate();
+  EXPECT_EQ(0.0f, wave->getFrameBlend());
+
+  wave->setFrameInterpolation(true);
+  EXPECT_FLOAT_EQ(0.25f, wave->getFrameBlend());
+  EXPECT_TRUE(wave->getVertexData() == frameAnimation->getVertexData(0));
+  EXPECT_TRUE(wave->getNextVertexData() == frameAnimation->getVertexData(1));
+  EXPECT_TRUE(wave->getNextNormalsData() == frameAnimation->getNormalsData(1));
+
+  for (int frame = 0; frame < 3; ++frame) wave->animate();
+  EXPECT_EQ(0.0f, wave->getFrameBlend());
+  EXPECT_EQ(1, wave->getCurrentFrame());
+  EXPECT_EQ(2, wave->getNextFrame());
+  EXPECT_TRUE(wave->getVertexData() == frameAnimation->getVertexData(1));
+  EXPECT_TRUE(wave->getNextVertexData() == frameAnimation->getVertexData(2));
+
+  for (int frame = 0; frame < 4 * (numFrames - 2) + 2; ++frame) wave->animate();
+  EXPECT_FLOAT_EQ(0.5f, wave->getFrameBlend());
+  EXPECT_TRUE(wave->getNextVertexData() == frameAnimation->getVertexData(0));
+
+  // Some quads of the goat have been triangulated differently in each of its frames,
+  // so they do not share the same topology and are stored separately.
+  shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim", 19));
+  EXPECT_TRUE(goat->getFrameAnimation() == nullptr);
+  EXPECT_NE(goat->getFrameModel(0), goat->getFrameModel(1));
+  EXPECT_EQ(&goat->getModel(), goat->getFrameModel(goat->getCurrentFrame()).get());
+
+  // Separately stored frames have their own index data, so they are not blended
+  goat->setFrameInterpolation(true);
+  goat->setFrameDelay(4);
+  goat->startAnimating();
+  goat->animate();
+  EXPECT_EQ(0.0f, goat->getFrameBlend());
+
+  // Frames with different texture coordinates do not share the same topology either
+  vector<shared_ptr<Model> > cubeFrames;
+  cubeFrames.push_back(shared_ptr<Model>(new Model()));
+  cubeFrames.push_back(shared_ptr<Model>(new Model()));
+  WavefrontLoader loader(true, false, false);
+  loader.load("resources/models/Cube/Cube.obj", *cubeFrames[0]);
+  loader.load("resources/models/Cube/CubeNoTexture.obj", *cubeFrames[1]);
+  EXPECT_TRUE(FrameAnimation::create(cubeFrames) == nullptr);
+
+  loader.load("resources/models/Cube/Cube.obj", *cubeFrames[1]);
+  shared_ptr<FrameAnimation> cubeAnimation = FrameAnimation::create(cubeFrames);
+  ASSERT_TRUE(cubeAnimation != nullptr);
+  EXPECT_EQ(2, cubeAnimation->getNumFrames());
+  EXPECT_EQ(cubeFrames[0]->vertexData.size(), cubeAnimation->getVertexData(1).size());
+
+  // Quantised animations only keep the compact format of the frames after the first one
+  loader.load("resources/models/Cube/Cube.obj", *cubeFrames[1]);
+  quantiseVertexData(*cubeFrames[0]);
+  quantiseVertexData(*cubeFrames[1]);
+  shared_ptr<FrameAnimation> quantisedAnimation = FrameAnimation::create(cubeFrames);
+  ASSERT_TRUE(quantisedAnimation != nullptr);
+  EXPECT_TRUE(quantisedAnimation->isQuantised());
+  EXPECT_EQ(2, quantisedAnimation->getNumFrames());
+  EXPECT_TRUE(quantisedAnimation->vertexData.empty());
+  EXPECT_EQ(1u, quantisedAnimation->compactVertexData.size());
+  EXPECT_THROW(quantisedAnimation->getVertexData(1), Exception);
+  vector<float> frameVertexData, frameNormalsData;
+  quantisedAnimation->getFrameData(1, frameVertexData, frameNormalsData);
+  EXPECT_EQ(cubeAnimation->getVertexData(1), frameVertexData);
+  ASSERT_EQ(cubeAnimation->getNormalsData(1).size(), frameNormalsData.size());
+  for (size_t idx = 0; idx < frameNormalsData.size(); ++idx) {
+    EXPECT_NEAR(cubeAnimation->getNormalsData(1)[idx], frameNormalsData[idx], 0.01f);
+  }
+
+  // A quad, split along a different diagonal in each frame, would need more vertices
+  // to share its topology than to store its frames separately
+  vector<shared_ptr<Model> > quadFrames;
+  float quadVertices[16] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+                            1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f};
+  float quadNormals[12] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f};
+  unsigned int quadIndexes[2][6] = {{0, 1, 2, 2, 3, 0}, {0, 1, 3, 1, 2, 3}};
+  for (int frame = 0; frame < 2; ++frame) {
+    quadFrames.push_back(shared_ptr<Model>(new Model()));
+    quadFrames.back()->vertexData.assign(quadVertices, quadVertices + 16);
+    quadFrames.back()->normalsData.assign(quadNormals, quadNormals + 12);
+    quadFrames.back()->indexData.assign(quadIndexes[frame], quadIndexes[frame] + 6);
+  }
+  EXPECT_TRUE(FrameAnimation::create(quadFrames) == nullptr);
+  quadFrames[1]->indexData = quadFrames[0]->indexData;
+  EXPECT_TRUE(FrameAnimation::create(quadFrames) != nullptr);
+}
+
+TEST(SceneObjectTest, LoadAsynchronously) {
+
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+  AsyncSceneObject goatLoading("goat", "resources/models/Goat/goatAnim", 19,
+                               "resources/models/Cube/CubeTexture.png");
+  AsyncSceneObject missingLoading("missing", "resources/models/Missing/missing.obj");
+
+  chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+  cout << "Started loading the goat in the background in " << elapsed.count() << " ms" << endl;
+
+  // The main thread keeps running while the objects are being loaded
+  int polls = 0;
+  while (!goatLoading.isReady()) {
+    ++polls;
+    this_thread::sleep_for(chrono::milliseconds(1));
+  }
+
+  elapsed = chrono::high_resolution_clock::now() - start;
+  cout << "The goat was ready after " << elapsed.count() << " ms (" << polls << " polls)" << endl;
+
+  shared_ptr<SceneObject> goat = goatLoading.get();
+  EXPECT_EQ("goat", goat->getName());
+  ASSERT_TRUE(goat->getTexture() != nullptr);
+  EXPECT_NE(0, goat->getTexture()->getWidth());
+
+  shared_ptr<SceneObject> syncGoat(new SceneObject("goat", "resources/models/Goat/goatAnim", 19));
+  goat->startAnimating();
+  syncGoat->startAnimating();
+  for (int frame = 0; frame < 19; ++frame) {
+    EXPECT_EQ(syncGoat->getVertexData(), goat->getVertexData());
+    EXPECT_EQ(syncGoat->getNormalsData(), goat->getNormalsData());
+    goat->animate();
+    syncGoat->animate();
+  }
+
+  // Loading errors are reported when the object is retrieved
+  EXPECT_THROW(missingLoading.get(), Exception);
+  EXPECT_TRUE(missingLoading.isReady());
+  EXPECT_THROW(missingLoading.get(), Exception);
+}
+
+TEST(ModelCacheTest, ShareModels) {
+
+  shared_ptr<ModelCache> modelCache(new ModelCache());
+
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+  shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim", 19, "", "", modelCache));
+  chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+  cout << "First goat loaded through the cache in " << elapsed.count() << " ms" << endl;
+
+  EXPECT_EQ(0, modelCache->getHits());
+  EXPECT_EQ(19, modelCache->getMisses());
+  EXPECT_EQ(19, modelCache->getSize());
+
+  start = chrono::high_resolution_clock::now();
+  vector<shared_ptr<SceneObject> > goats;
+  for (int idx = 0; idx < 10; ++idx) {
+    goats.push_back(shared_ptr<SceneObject>(
+        new SceneObject("goat", "resources/models/Goat/goatAnim", 19, "", "", modelCache)));
+  }
+  elapsed = chrono::high_resolution_clock::now() - start;
+  cout << "10 more goats loaded through the cache in " << elapsed.count() << " ms" << endl;
+
+  EXPECT_EQ(190, modelCache->getHits());
+  EXPECT_EQ(19, modelCache->getMisses());
+  EXPECT_EQ(19, modelCache->getSize());
+
+  // The same model is shared, rather than copied
+  EXPECT_EQ(&goat->getModel(), &goats[9]->getModel());
+
+  // Different paths to the same file hit the cache too
+  shared_ptr<const Model> tree = modelCache->getModel("resources/models/Tree/tree.obj");
+  EXPECT_EQ(tree, modelCache->getModel("resources/models/../models/Tree/./tree.obj"));
+  EXPECT_EQ(191, modelCache->getHits());
+  EXPECT_EQ(20, modelCache->getMisses());
+  EXPECT_TRUE(modelCache->contains("resources/models/Goat/goatAnim", 19));
+  EXPECT_FALSE(modelCache->contains("resources/models/Goat/goatAnim", 20));
+
+  // Failures are not cached
+  EXPECT_THROW(modelCache->getModel("resources/models/Missing/missing.obj"), Exception);
+  EXPECT_FALSE(modelCache->contains("resources/models/Missing/missing.obj"));
+
+  // Evicted models stay alive for as long as they are in use
+  EXPECT_TRUE(modelCache->evict("resources/models/Tree/tree.obj"));
+  EXPECT_FALSE(modelCache->evict("resources/models/Tree/tree.obj"));
+  EXPECT_NE(0, tree->vertexData.size());
+  EXPECT_NE(tree, modelCache->getModel("resources/models/Tree/tree.obj"));
+
+  // Only the tree is not being used by an object
+  EXPECT_EQ(1, modelCache->evictUnused());
+
+  // Models are loaded again for a different number of levels of detail, except for
+  // the frames of animated models, which never have any
+  EXPECT_EQ(1u, tree->getNumLevelsOfDetail());
+  modelCache->setLevelsOfDetail(3);
+  EXPECT_TRUE(modelCache->contains("resources/models/Goat/goatAnim", 19));
+  shared_ptr<const Model> detailedTree = modelCache->getModel("resources/models/Tree/tree.obj");
+  EXPECT_GT(detailedTree->getNumLevelsOfDetail(), 1u);
+  EXPECT_EQ(detailedTree, modelCache->getModel("resources/models/Tree/tree.obj"));
+  modelCache->setLevelsOfDetail(1);
+  EXPECT_FALSE(modelCache->contains("resources/models/Tree/tree.obj"));
+  EXPECT_NE(detailedTree, modelCache->getModel("resources/models/Tree/tree.obj"));
+  detailedTree.reset();
+  EXPECT_EQ(2, modelCache->evictUnused());
+  goats.clear();
+  EXPECT_EQ(0, modelCache->evictUnused());
+  goat.reset();
+  EXPECT_EQ(19, modelCache->evictUnused());
+  EXPECT_EQ(0, modelCache->getSize());
+
+  modelCache->resetStatistics();
+  EXPECT_EQ(0, modelCache->getHits());
+  EXPECT_EQ(0, modelCache->getMisses());
+}
+
+TEST(MathFunctionsTest, ComposeRotations) {
+
+  // The composed rotation rotates points the same way as the separate rotations
+  // around the z, x and y axes, applied one after the other
+  glm::vec3 rotation(0.3f, -1.2f, 2.1f);
+  glm::mat4 composed = rotate(rotation);
+  glm::vec4 point(0.5f, -1.5f, 2.0f, 1.0f);
+
+  glm::vec4 rotated = rotateY(rotation.y) * (rotateX(rotation.x) * (rotateZ(rotation.z) * point));
+  glm::vec4 composedRotated = composed * point;
+
+  for (int component = 0; component < 4; ++component) {
+    EXPECT_NEAR(rotated[component], composedRotated[component], 1e-5f);
+  }
+
+  // Rotations do not change lengths, so the inverse transpose (the normal matrix) is the same
+  glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(composed)));
+  for (int column = 0; column < 3; ++column) {
+    for (int row = 0; row < 3; ++row) {
+      EXPECT_NEAR(composed[column][row], normalMatrix[column][row], 1e-5f);
+    }
+  }
+}
+
+TEST(FrustumTest, CullSpheres) {
+
+  // The default frustum of the Renderer, for a 640x480 window, with the camera
+  // at (0, 0, 1), looking down the z axis
+  const float zNear = 1.0f, zFar = 24.0f;
+  glm::mat4 perspectiveMatrix(0.0f);
+  perspectiveMatrix[0][0] = 1.0f;
+  perspectiveMatrix[1][1] = 1.33f;
+  perspectiveMatrix[2][2] = (zNear + zFar) / (zNear - zFar);
+  perspectiveMatrix[3][2] = 2.0f * zNear * zFar / (zNear - zFar);
+  perspectiveMatrix[2][3] = -1.0f;
+  glm::mat4 cameraTranslation;
+  cameraTranslation[3] = glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+  Frustum frustum(perspectiveMatrix * cameraTranslation);
+
+  EXPECT_TRUE(frustum.containsSphere(glm::vec3(0.0f, 0.0f, -5.0f), 0.5f));
+  EXPECT_FALSE(frustum.containsSphere(glm::vec3(0.0f, 0.0f, 5.0f), 0.5f));  // Behind the camera
+  EXPECT_FALSE(frustum.containsSphere(glm::vec3(0.0f, 0.0f, -30.0f), 0.5f));  // Beyond zFar
+  EXPECT_TRUE(frustum.containsSphere(glm::vec3(0.0f, 0.0f, -23.5f), 1.0f));  // Crossing zFar
+  EXPECT_FALSE(frustum.containsSphere(glm::vec3(-10.0f, 0.0f, -5.0f), 0.5f));  // Left of the frustum
+  EXPECT_TRUE(frustum.containsSphere(glm::vec3(-6.5f, 0.0f, -5.0f), 1.5f));  // Crossing its left side
+  EXPECT_FALSE(frustum.containsSphere(glm::vec3(0.0f, 6.0f, -5.0f), 0.5f));  // Above it
+
+  EXPECT_TRUE(frustum.containsBox(glm::vec3(-6.5f, 0.0f, -5.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
+  EXPECT_FALSE(frustum.containsBox(glm::vec3(-8.5f, 0.0f, -5.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
+
+  // Everything is in the default frustum
+  EXPECT_TRUE(Frustum().containsSphere(glm::vec3(0.0f, 0.0f, 1000.0f), 0.0f));
+
+  // Testing spheres together gives the same results as testing them one by one.
+  // Benchmark, with 100000 spheres scattered around the camera.
+  const size_t numSpheres = 100000;
+  vector<float> centreX(numSpheres), centreY(numSpheres), centreZ(numSpheres), radii(numSpheres);
+  srand(1);
+  for (size_t sphere = 0; sphere < numSpheres; ++sphere) {
+    centreX[sphere] = static_cast<float>(rand() % 6000) * 0.01f - 30.0f;
+    centreY[sphere] = static_cast<float>(rand() % 6000) * 0.01f - 30.0f;
+    centreZ[sphere] = static_cast<float>(rand() % 6000) * 0.01f - 30.0f;
+    radii[sphere] = static_cast<float>(rand() % 100) * 0.01f;
+  }
+
+  vector<unsigned char> visible(numSpheres);
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+  size_t numVisible = frustum.cullSpheres(centreX.data(), centreY.data(), centreZ.data(), radii.data(),
+                                          numSpheres, visible.data());
+  chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+
+  start = chrono::high_resolution_clock::now();
+  size_t numContained = 0;
+  for (size_t sphere = 0; sphere < numSpheres; ++sphere) {
+    bool contained = frustum.containsSphere(glm::vec3(centreX[sphere], centreY[sphere], centreZ[sphere]),
+                                            radii[sphere]);
+    EXPECT_EQ(contained ? 1 : 0, visible[sphere]);
+    numContained += contained ? 1 : 0;
+  }
+  chrono::duration<double, milli> elapsedOneByOne = chrono::high_resolution_clock::now() - start;
+
+  EXPECT_EQ(numContained, numVisible);
+  EXPECT_GT(numVisible, 0u);
+  EXPECT_LT(numVisible, numSpheres);
+
+  cout << numVisible << " of " << numSpheres << " spheres in the frustum, tested in " << elapsed.count()
+  << " ms together (" << elapsedOneByOne.count() << " ms one by one, with the checks)" << endl;
+}
+
+TEST(OcclusionBufferTest, HideBoxes) {
+
+  // The default perspective of the Renderer, with the camera at the origin
+  const float zNear = 1.0f, zFar = 24.0f;
+  glm::mat4 viewProjectionMatrix(0.0f);
+  viewProjectionMatrix[0][0] = 1.0f;
+  viewProjectionMatrix[1][1] = 1.0f;
+  viewProjectionMatrix[2][2] = (zNear + zFar) / (zNear - zFar);
+  viewProjectionMatrix[3][2] = 2.0f * zNear * zFar / (zNear - zFar);
+  viewProjectionMatrix[2][3] = -1.0f;
+
+  // A wall, 4 units wide and high, 5 units in front of the camera
+  Model wall;
+  float wallVertices[16] = {
+      -2.0f, -2.0f, -5.0f, 1.0f,
+      2.0f, -2.0f, -5.0f, 1.0f,
+      2.0f, 2.0f, -5.0f, 1.0f,
+      -2.0f, 2.0f, -5.0f, 1.0f
+  };
+  unsigned int wallIndexes[6] = {0, 1, 2, 2, 3, 0};
+  wall.vertexData.assign(wallVertices, wallVertices + 16);
+  wall.indexData.assign(wallIndexes, wallIndexes + 6);
+
+  OcclusionBuffer occlusionBuffer(64, 64);
+  occlusionBuffer.clear(viewProjectionMatrix);
+  glm::mat4 identity;
+
+  // Nothing is hidden in an empty buffer
+  EXPECT_TRUE(occlusionBuffer.isBoxVisible(glm::vec3(-0.5f, -0.5f, -10.5f), glm::vec3(0.5f, 0.5f, -9.5f), identity));
+
+  occlusionBuffer.rasteriseOccluder(wall, identity);
+  EXPECT_EQ(2, occlusionBuffer.getNumTrianglesRasterised());
+
+  // The wall covers the middle fifth of the buffer (from -0.4 to 0.4, i.e. from pixel
+  // 19.2 to 44.8), including the pixels along its diagonal, but not the pixels it only
+  // partly covers
+  EXPECT_LT(occlusionBuffer.getDepth(32, 32), 1.0f);
+  EXPECT_LT(occlusionBuffer.getDepth(20, 43), 1.0f);
+  EXPECT_EQ(numeric_limits<float>::max(), occlusionBuffer.getDepth(19, 32));
+  EXPECT_EQ(numeric_limits<float>::max(), occlusionBuffer.getDepth(20, 44));
+  EXPECT_EQ(numeric_limits<float>::max(), occlusionBuffer.getDepth(15, 32));
+  EXPECT_EQ(numeric_limits<float>::max(), occlusionBuffer.getDepth(0, 0));
+
+  // Behind the wall
+  EXPECT_FALSE(occlusionBuffer.isBoxVisible(glm::vec3(-0.5f, -0.5f, -10.5f), glm::vec3(0.5f, 0.5f, -9.5f),
+                                            identity));
+  // The same box, moved by the model matrix
+  glm::mat4 moveBack;
+  moveBack[3] = glm::vec4(0.0f, 0.0f, -10.0f, 1.0f);
+  EXPECT_FALSE(occlusionBuffer.isBoxVisible(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.5f, 0.5f, 0.5f), moveBack));
+  // In front of the wall
+  EXPECT_TRUE(occlusionBuffer.isBoxVisible(glm::vec3(-0.5f, -0.5f, -3.5f), glm::vec3(0.5f, 0.5f, -2.5f), identity));
+  // Going through the wall
+  EXPECT_TRUE(occlusionBuffer.isBoxVisible(glm::vec3(-0.5f, -0.5f, -6.0f), glm::vec3(0.5f, 0.5f, -4.0f), identity));
+  // Sticking out from behind the wall
+  EXPECT_TRUE(occlusionBuffer.isBoxVisible(glm::vec3(3.5f, -0.5f, -10.5f), glm::vec3(4.5f, 0.5f, -9.5f), identity));
+  // Crossing the near plane
+  EXPECT_TRUE(occlusionBuffer.isBoxVisible(glm::vec3(-0.5f, -0.5f, -1.5f), glm::vec3(0.5f, 0.5f, 0.5f), identity));
+
+  // Clearing the buffer reveals everything again
+  occlusionBuffer.clear(viewProjectionMatrix);
+  EXPECT_EQ(0, occlusionBuffer.getNumTrianglesRasterised());
+  EXPECT_TRUE(occlusionBuffer.isBoxVisible(glm::vec3(-0.5f, -0.5f, -10.5f), glm::vec3(0.5f, 0.5f, -9.5f), identity));
+
+  // A triangle facing the camera and a neighbour folding away from it, sharing an edge
+  // which crosses pixel 32 at 32.7, to the right of its centre. The neighbour is farther
+  // on the part of the pixel it covers, so its depth is the one kept.
+  Model folded;
+  float foldedVertices[16] = {
+      0.109375f, -2.0f, -5.0f, 1.0f,
+      0.109375f, 2.0f, -5.0f, 1.0f,
+      -2.0f, 0.0f, -5.0f, 1.0f,
+      8.0f, 0.0f, -20.0f, 1.0f
+  };
+  unsigned int foldedIndexes[6] = {0, 1, 2, 1, 0, 3};
+  folded.vertexData.assign(foldedVertices, foldedVertices + 16);
+  folded.indexData.assign(foldedIndexes, foldedIndexes + 6);
+
+  occlusionBuffer.clear(viewProjectionMatrix);
+  occlusionBuffer.rasteriseOccluder(folded, identity);
+  glm::vec4 neighbourPoint = viewProjectionMatrix * glm::vec4(0.996f * 0.109375f + 0.004f * 8.0f, 0.0f,
+                                                              0.996f * -5.0f + 0.004f * -20.0f, 1.0f);
+  EXPECT_LT(neighbourPoint.x / neighbourPoint.w, 1.0f / 32.0f);
+  EXPECT_LT(occlusionBuffer.getDepth(31, 32), occlusionBuffer.getDepth(32, 32));
+  EXPECT_LT(occlusionBuffer.getDepth(32, 32), numeric_limits<float>::max());
+  EXPECT_GE(occlusionBuffer.getDepth(32, 32), neighbourPoint.z / neighbourPoint.w);
+
+  // With a sliver for a neighbour, which ends at 32.8, the rest of the pixel is not
+  // covered by either triangle
+  folded.vertexData[12] = 0.125f;
+  folded.vertexData[14] = -5.0f;
+  occlusionBuffer.clear(viewProjectionMatrix);
+  occlusionBuffer.rasteriseOccluder(folded, identity);
+  EXPECT_LT(occlusionBuffer.getDepth(31, 32), 1.0f);
+  EXPECT_EQ(numeric_limits<float>::max(), occlusionBuffer.getDepth(32, 32));
+
+  // Benchmark, rasterising the tree and testing a grid of boxes behind it
+  Model tree;
+  WavefrontLoader loader;
+  loader.load("resources/models/Tree/tree.obj", tree);
+  OcclusionBuffer largeBuffer(256, 192);
+  glm::mat4 treeMatrix;
+  treeMatrix[3] = glm::vec4(0.0f, -1.0f, -3.0f, 1.0f);
+
+  const int numFrames = 100;
+  int numHidden = 0;
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+  for (int frame = 0; frame < numFrames; ++frame) {
+    largeBuffer.clear(viewProjectionMatrix);
+    largeBuffer.rasteriseOccluder(tree, treeMatrix);
+  }
+  chrono::duration<double, milli> elapsedRasterising = chrono::high_resolution_clock::now() - start;
+
+  start = chrono::high_resolution_clock::now();
+  for (int x = -50; x < 50; ++x) {
+    for (int y = -50; y < 50; ++y) {
+      glm::mat4 boxMatrix;
+      boxMatrix[3] = glm::vec4(static_cast<float>(x) * 0.1f, static_cast<float>(y) * 0.1f, -15.0f, 1.0f);
+      if (!largeBuffer.isBoxVisible(glm::vec3(-0.05f), glm::vec3(0.05f), boxMatrix)) ++numHidden;
+    }
+  }
+  chrono::duration<double, milli> elapsedTesting = chrono::high_resolution_clock::now() - start;
+
+  EXPECT_GT(largeBuffer.getNumTrianglesRasterised(), 0);
+  EXPECT_GT(numHidden, 0);
+  cout << "Tree occluder (" << tree.getNumIndexes() / 3 << " triangles) rasterised in "
+  << elapsedRasterising.count() / numFrames << " ms, " << numHidden << " of 10000 boxes behind it found in "
+  << elapsedTesting.count() << " ms" << endl;
+}
+
 TEST(BoundingBoxesTest, LoadBoundingBoxes) {
 
   unique_ptr<BoundingBoxes> bboxes(new BoundingBoxes());
@@ -184,6 +1347,455 @@ scene->push_back(object);
 unique_ptr<Renderer> renderer(new Renderer());
 renderer->init(640, 480, false);
 
+// The model's data is uploaded once and kept for the next frames
+renderer->prepareSceneObject(object);
+EXPECT_EQ(1, renderer->getNumResidentModels());
+for (int frame = 0; frame < 3; ++frame) {
+  renderer->clearScreen();
+  renderer->renderSceneObject(object);
+  renderer->swapBuffers();
+}
+EXPECT_EQ(1, renderer->getNumResidentModels());
+
+renderer->releaseSceneObject(object);
+EXPECT_EQ(0, renderer->getNumResidentModels());
+renderer->renderSceneObject(object);
+EXPECT_EQ(1, renderer->getNumResidentModels());
+
+// The buffers are released once the model is destroyed
+object.reset();
+scene->clear();
+renderer->swapBuffers();
+EXPECT_EQ(0, renderer->getNumResidentModels());
+
+}
+
+TEST(RendererTest, RenderQueue) {
+
+  unique_ptr<Renderer> renderer(new Renderer());
+  renderer->init(640, 480, false);
+
+  shared_ptr<ModelCache> modelCache(new ModelCache());
+  vector<shared_ptr<SceneObject> > objects;
+  for (int idx = 0; idx < 6; ++idx) {
+    objects.push_back(shared_ptr<SceneObject>(
+        new SceneObject(idx % 2 == 0 ? "goat" : "tree",
+                        idx % 2 == 0 ? "resources/models/Goat/goatAnim_000001.obj" : "resources/models/Tree/tree.obj",
+                        1, "", "", modelCache)));
+    objects.back()->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+    objects.back()->setOffset(static_cast<float>(idx) - 3.0f, -1.0f, -5.0f);
+  }
+
+  Image image("resources/models/Cube/CubeTexture.png");
+  renderer->generateTexture("image", image.getData(), image.getWidth(), image.getHeight());
+  float imageVertices[16] = {
+      -1.0f, -1.0f, 0.5f, 1.0f,
+      -0.8f, -1.0f, 0.5f, 1.0f,
+      -0.8f, -0.8f, 0.5f, 1.0f,
+      -1.0f, -0.8f, 0.5f, 1.0f
+  };
+
+  // The goats and trees alternate, with images between them
+  for (int queued = 0; queued < 2; ++queued) {
+    renderer->clearScreen();
+    for (size_t idx = 0; idx < objects.size(); ++idx) {
+      if (queued == 1) {
+        renderer->queueSceneObject(objects[idx]);
+        renderer->queueImage(imageVertices, "image");
+      }
+      else {
+        renderer->renderSceneObject(objects[idx]);
+        renderer->renderImage(imageVertices, "image");
+      }
+    }
+    // Anything still queued is rendered before swapping
+    renderer->swapBuffers();
+  }
+
+  // Rendered directly, every draw changes the program and vertex array object
+  renderer->clearScreen();
+  for (size_t idx = 0; idx < objects.size(); ++idx) {
+    renderer->renderSceneObject(objects[idx]);
+    renderer->renderImage(imageVertices, "image");
+  }
+  renderer->swapBuffers();
+  RenderStatistics direct = renderer->getLastFrameStatistics();
+
+  renderer->clearScreen();
+  for (size_t idx = 0; idx < objects.size(); ++idx) {
+    renderer->queueSceneObject(objects[idx]);
+    renderer->queueImage(imageVertices, "image");
+  }
+  renderer->renderQueue();
+  renderer->swapBuffers();
+  RenderStatistics queued = renderer->getLastFrameStatistics();
+
+  cout << "Binds rendering directly: " << direct.binds << " (" << direct.bindsAvoided << " avoided), "
+  << "through the render queue: " << queued.binds << " (" << queued.bindsAvoided << " avoided)" << endl;
+
+  EXPECT_LT(queued.binds, direct.binds);
+  EXPECT_GT(queued.bindsAvoided, direct.bindsAvoided);
+  EXPECT_EQ(direct.binds + direct.bindsAvoided, queued.binds + queued.bindsAvoided);
+}
+
+TEST(RendererTest, FrustumCulling) {
+
+  unique_ptr<Renderer> renderer(new Renderer());
+  renderer->init(640, 480, false);
+
+  shared_ptr<ModelCache> modelCache(new ModelCache());
+  shared_ptr<SceneObject> inFront(new SceneObject("goat", "resources/models/Goat/goatAnim_000001.obj", 1, "", "",
+                                                  modelCache));
+  inFront->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+  inFront->setOffset(0.0f, -1.0f, -5.0f);
+  shared_ptr<SceneObject> behind(new SceneObject("goat", "resources/models/Goat/goatAnim_000001.obj", 1, "", "",
+                                                 modelCache));
+  behind->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+  behind->setOffset(0.0f, -1.0f, 5.0f);
+
+  renderer->clearScreen();
+  renderer->renderSceneObject(inFront);
+  renderer->renderSceneObject(behind);
+  renderer->queueSceneObject(inFront);
+  renderer->queueSceneObject(behind);
+  renderer->renderInstances(modelCache->getModel("resources/models/Goat/goatAnim_000001.obj"),
+                            vector<Instance>(1, Instance(glm::vec3(0.0f, -1.0f, 30.0f))));
+  renderer->swapBuffers();
+
+  EXPECT_EQ(2, renderer->getLastFrameStatistics().objectsDrawn);
+  EXPECT_EQ(3, renderer->getLastFrameStatistics().objectsCulled);
+
+  // Turning the camera around brings the other object into view
+  renderer->cameraRotation = glm::vec3(0.0f, 3.14159f, 0.0f);
+  renderer->clearScreen();
+  renderer->renderSceneObject(inFront);
+  renderer->renderSceneObject(behind);
+  renderer->swapBuffers();
+  EXPECT_EQ(1, renderer->getLastFrameStatistics().objectsDrawn);
+  EXPECT_EQ(1, renderer->getLastFrameStatistics().objectsCulled);
+
+  renderer->frustumCulling = false;
+  renderer->clearScreen();
+  renderer->renderSceneObject(inFront);
+  renderer->renderSceneObject(behind);
+  renderer->swapBuffers();
+  EXPECT_EQ(2, renderer->getLastFrameStatistics().objectsDrawn);
+  EXPECT_EQ(0, renderer->getLastFrameStatistics().objectsCulled);
+}
+
+TEST(RendererTest, OcclusionCulling) {
+
+  unique_ptr<Renderer> renderer(new Renderer());
+  renderer->init(640, 480, false);
+
+  shared_ptr<SceneObject> box(new SceneObject("box", "resources/models/Cube/CubeNoTexture.obj"));
+  box->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+  box->setOffset(0.0f, 0.0f, -4.0f);
+  shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim_000001.obj"));
+  goat->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+  goat->setOffset(0.0f, 0.0f, -12.0f);
+
+  renderer->addOccluder(box);
+
+  // The goat is behind the box
+  renderer->clearScreen();
+  renderer->renderSceneObject(box);
+  renderer->renderSceneObject(goat);
+  renderer->queueSceneObject(goat);
+  renderer->swapBuffers();
+  RenderStatistics statistics = renderer->getLastFrameStatistics();
+  EXPECT_EQ(1, statistics.objectsDrawn);
+  EXPECT_EQ(2, statistics.objectsOccluded);
+  EXPECT_EQ(12, statistics.occluderTrianglesRasterised);
+  EXPECT_GT(statistics.occlusionMilliseconds, 0.0);
+
+  // Beside the box
+  goat->setOffset(6.0f, 0.0f, -12.0f);
+  renderer->clearScreen();
+  renderer->renderSceneObject(box);
+  renderer->renderSceneObject(goat);
+  renderer->swapBuffers();
+  EXPECT_EQ(2, renderer->getLastFrameStatistics().objectsDrawn);
+  EXPECT_EQ(0, renderer->getLastFrameStatistics().objectsOccluded);
+
+  // Nothing is rasterised without occluders
+  goat->setOffset(0.0f, 0.0f, -12.0f);
+  renderer->removeOccluder(box);
+  renderer->clearScreen();
+  renderer->renderSceneObject(box);
+  renderer->renderSceneObject(goat);
+  renderer->swapBuffers();
+  EXPECT_EQ(2, renderer->getLastFrameStatistics().objectsDrawn);
+  EXPECT_EQ(0, renderer->getLastFrameStatistics().occluderTrianglesRasterised);
+}
+
+TEST(RendererTest, RenderHeadless) {
+
+  unique_ptr<Renderer> renderer(new Renderer());
+  renderer->initHeadless(320, 240);
+  EXPECT_TRUE(renderer->isHeadless());
+
+  shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim_000001.obj"));
+  goat->setColour(1.0f, 0.0f, 0.0f, 1.0f);
+  goat->setOffset(0.0f, -0.5f, -3.0f);
+  renderer->lightIntensity = -1.0f;
+
+  // Only the clear colour (blue), without anything rendered
+  vector<unsigned char> pixels;
+  int width = 0, height = 0;
+  renderer->clearScreen();
+  renderer->readFrame(pixels, width, height);
+  EXPECT_EQ(320, width);
+  EXPECT_EQ(240, height);
+  ASSERT_EQ(320u * 240u * 4u, pixels.size());
+  for (size_t pixel = 0; pixel < pixels.size(); pixel += 4) {
+    ASSERT_EQ(0, pixels[pixel]);
+    ASSERT_EQ(255, pixels[pixel + 2]);
+  }
+
+  // The goat covers part of the frame, which can be read back after swapping
+  renderer->clearScreen();
+  renderer->renderSceneObject(goat);
+  renderer->swapBuffers();
+  renderer->readFrame(pixels, width, height);
+  int numGoatPixels = 0;
+  for (size_t pixel = 0; pixel < pixels.size(); pixel += 4) {
+    if (pixels[pixel] > 128 && pixels[pixel + 2] < 128) ++numGoatPixels;
+  }
+  EXPECT_GT(numGoatPixels, 0);
+  EXPECT_LT(numGoatPixels, width * height / 2);
+
+  // Benchmark, rendering frames without a display
+  const int numFrames = 100;
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+  for (int frame = 0; frame < numFrames; ++frame) {
+    renderer->clearScreen();
+    renderer->renderSceneObject(goat);
+    renderer->swapBuffers();
+  }
+  renderer->readFrame(pixels, width, height);
+  chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+  cout << "Headless: " << numFrames << " frames of " << width << "x" << height << " in " << elapsed.count()
+  << " ms (" << numGoatPixels << " goat pixels)" << endl;
+}
+
+TEST(RendererTest, FrameStatistics) {
+
+  unique_ptr<Renderer> renderer(new Renderer());
+  renderer->initHeadless(320, 240);
+
+  shared_ptr<ModelCache> modelCache(new ModelCache());
+  shared_ptr<const Model> goatModel = modelCache->getModel("resources/models/Goat/goatAnim_000001.obj");
+  shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim_000001.obj", 1, "", "",
+                                               modelCache));
+  goat->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+  goat->setOffset(0.0f, -0.5f, -3.0f);
+  int goatTriangles = static_cast<int>(goatModel->getNumIndexes() / 3);
+
+  // The model is uploaded in the first frame only
+  renderer->statisticsLogInterval = 5;
+  for (int frame = 0; frame < 10; ++frame) {
+    renderer->clearScreen();
+    renderer->beginPass("goat");
+    renderer->renderSceneObject(goat);
+    renderer->endPass();
+    renderer->beginPass("instances");
+    renderer->renderInstances(goatModel, vector<Instance>(3, Instance(glm::vec3(1.0f, -0.5f, -4.0f))));
+    renderer->endPass();
+    renderer->swapBuffers();
+
+    RenderStatistics statistics = renderer->getLastFrameStatistics();
+    EXPECT_EQ(2, statistics.drawCalls);
+    EXPECT_EQ(4 * goatTriangles, statistics.trianglesDrawn);
+    EXPECT_EQ(1, statistics.programSwitches);
+    if (frame == 0) {
+      EXPECT_GT(statistics.bytesUploaded, goatModel->vertexData.size() * sizeof(float));
+    }
+    else {
+      // Only the instances, which are uploaded in every frame
+      EXPECT_EQ(1, statistics.bufferUploads);
+    }
+  }
+
+  // The GPU timings arrive a few frames late, if timer queries are supported
+  RenderStatistics statistics = renderer->getLastFrameStatistics();
+  cout << "GPU time per frame: " << statistics.gpuMilliseconds << " ms" << endl;
+  if (statistics.gpuMilliseconds >= 0.0) {
+    EXPECT_EQ(2u, statistics.passGpuMilliseconds.size());
+    EXPECT_LE(statistics.passGpuMilliseconds["goat"], statistics.gpuMilliseconds);
+  }
+
+  EXPECT_THROW(renderer->endPass(), Exception);
+}
+
+TEST(RendererTest, ErrorChecking) {
+
+  // Rendering a frame under each policy, which should not find any errors
+  const ErrorChecking policies[] = {noErrorChecking, perFrameErrorChecking, perCallErrorChecking};
+  const char *names[] = {"none", "per frame", "per call"};
+  for (int policy = 0; policy < 3; ++policy) {
+    unique_ptr<Renderer> renderer(new Renderer());
+    renderer->errorChecking = policies[policy];
+    renderer->initHeadless(320, 240);
+
+    shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim_000001.obj"));
+    goat->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+    goat->setOffset(0.0f, -0.5f, -3.0f);
+
+    const int numFrames = 100;
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < numFrames; ++frame) {
+      renderer->clearScreen();
+      EXPECT_NO_THROW(renderer->renderSceneObject(goat));
+      EXPECT_NO_THROW(renderer->swapBuffers());
+    }
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    cout << "Error checking (" << names[policy] << "): " << numFrames << " frames in " << elapsed.count()
+    << " ms" << endl;
+
+    // An invalid enum is found by the next call's check when checking every call, when
+    // swapping the buffers when checking once per frame, and never otherwise
+    renderer->clearScreen();
+    glEnable(0xFFFF);
+    if (policies[policy] == perCallErrorChecking) {
+      EXPECT_THROW(renderer->renderSceneObject(goat), Exception);
+      EXPECT_NO_THROW(renderer->swapBuffers());
+    }
+    else if (policies[policy] == perFrameErrorChecking) {
+      EXPECT_NO_THROW(renderer->renderSceneObject(goat));
+      EXPECT_THROW(renderer->swapBuffers(), Exception);
+    }
+    else {
+      EXPECT_NO_THROW(renderer->renderSceneObject(goat));
+      EXPECT_NO_THROW(renderer->swapBuffers());
+      EXPECT_EQ(static_cast<GLenum>(GL_INVALID_ENUM), glGetError());
+    }
+
+    // Reported once
+    renderer->clearScreen();
+    EXPECT_NO_THROW(renderer->renderSceneObject(goat));
+    EXPECT_NO_THROW(renderer->swapBuffers());
+  }
+}
+
+TEST(RendererTest, ProgramCache) {
+
+  // Left over from an earlier run, they would be loaded the first time
+  string cachePath = SDL_GetBasePath();
+  remove((cachePath + "small3d_perspective.bin").c_str());
+  remove((cachePath + "small3d_orthographic.bin").c_str());
+
+  shared_ptr<SceneObject> goat(new SceneObject("goat", "resources/models/Goat/goatAnim_000001.obj"));
+  goat->setColour(0.5f, 0.5f, 0.5f, 1.0f);
+  goat->setOffset(0.0f, -0.5f, -3.0f);
+
+  // Compiled the first time and loaded from the cache the second, if program
+  // binaries are supported, then compiled again if the cache is stale, or if the
+  // length of the binary it holds is larger than the file
+  double timesToFirstFrame[4];
+  for (int run = 0; run < 4; ++run) {
+    if (run == 2) {
+      ofstream stale((cachePath + "small3d_perspective.bin").c_str(), ios::out | ios::binary | ios::trunc);
+      stale << "stale";
+    }
+    if (run == 3) {
+      ifstream cacheFile((cachePath + "small3d_orthographic.bin").c_str(), ios::in | ios::binary);
+      uint32_t keyLength = 0;
+      cacheFile.read(reinterpret_cast<char *>(&keyLength), sizeof(keyLength));
+      vector<char> header(sizeof(keyLength) + keyLength + sizeof(uint32_t));
+      cacheFile.seekg(0, ios::beg);
+      if (keyLength > 0 && cacheFile.read(header.data(), static_cast<streamsize>(header.size()))) {
+        cacheFile.close();
+        uint32_t binaryLength = 0xFFFFFFFFu;
+        ofstream truncated((cachePath + "small3d_orthographic.bin").c_str(), ios::out | ios::binary | ios::trunc);
+        truncated.write(header.data(), static_cast<streamsize>(header.size()));
+        truncated.write(reinterpret_cast<const char *>(&binaryLength), sizeof(binaryLength));
+      }
+    }
+
+    unique_ptr<Renderer> renderer(new Renderer());
+    renderer->programCachePath = "./";
+    renderer->initHeadless(320, 240);
+    EXPECT_LT(renderer->getTimeToFirstFrame(), 0.0);
+
+    renderer->clearScreen();
+    renderer->renderSceneObject(goat);
+    renderer->swapBuffers();
+    timesToFirstFrame[run] = renderer->getTimeToFirstFrame();
+    EXPECT_GE(timesToFirstFrame[run], 0.0);
+
+    bool cached = ifstream((cachePath + "small3d_orthographic.bin").c_str()).is_open();
+    if (run == 0 || !cached) {
+      EXPECT_EQ(0, renderer->getNumProgramsLoadedFromCache());
+    }
+    else {
+      EXPECT_EQ(run == 1 ? 2 : 1, renderer->getNumProgramsLoadedFromCache());
+    }
+  }
+
+  cout << "Time to first frame: " << timesToFirstFrame[0] << " ms compiling the shaders, "
+  << timesToFirstFrame[1] << " ms with the program cache, " << timesToFirstFrame[2]
+  << " ms with a stale program cache, " << timesToFirstFrame[3] << " ms with a corrupt one" << endl;
+
+  remove((cachePath + "small3d_perspective.bin").c_str());
+  remove((cachePath + "small3d_orthographic.bin").c_str());
+}
+
+TEST(RendererTest, RenderInstances) {
+
+  unique_ptr<Renderer> renderer(new Renderer());
+  renderer->initHeadless(640, 480);
+
+  // Benchmark, drawing a forest of 10000 trees as separate scene objects sharing
+  // their model and as instances of the model
+  const int numTrees = 10000;
+  const int numFrames = 5;
+  shared_ptr<ModelCache> modelCache(new ModelCache());
+  shared_ptr<const Model> treeModel = modelCache->getModel("resources/models/Tree/tree.obj");
+
+  vector<shared_ptr<SceneObject> > trees;
+  vector<Instance> treeInstances;
+  for (int idx = 0; idx < numTrees; ++idx) {
+    float x = static_cast<float>(idx % 100 - 50) * 0.5f;
+    float z = -1.0f - static_cast<float>(idx / 100) * 0.5f;
+    shared_ptr<SceneObject> tree(new SceneObject("tree", "resources/models/Tree/tree.obj", 1, "", "", modelCache));
+    tree->setOffset(x, -1.0f, z);
+    tree->setRotation(0.0f, static_cast<float>(idx), 0.0f);
+    tree->setColour(0.2f, 0.8f, 0.3f, 1.0f);
+    trees.push_back(tree);
+    treeInstances.push_back(Instance(glm::vec3(x, -1.0f, z), glm::vec3(0.0f, static_cast<float>(idx), 0.0f),
+                                     glm::vec4(0.2f, 0.8f, 0.3f, 1.0f)));
+  }
+
+  renderer->prepareSceneObject(trees[0]);
+  EXPECT_EQ(1, renderer->getNumResidentModels());
+
+  for (int instanced = 0; instanced < 2; ++instanced) {
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < numFrames; ++frame) {
+      renderer->clearScreen();
+      if (instanced == 1) {
+        renderer->renderInstances(treeModel, treeInstances);
+      }
+      else {
+        for (size_t idx = 0; idx < trees.size(); ++idx) {
+          renderer->renderSceneObject(trees[idx]);
+        }
+      }
+      glFinish();
+      renderer->swapBuffers();
+    }
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    cout << numTrees << " trees drawn " << (instanced == 1 ? "as instances" : "as scene objects") << ": "
+    << elapsed.count() / numFrames << " ms per frame" << endl;
+  }
+
+  // The instances use the same buffers as the scene objects
+  EXPECT_EQ(1, renderer->getNumResidentModels());
+
+  // Empty batches draw nothing
+  renderer->renderInstances(treeModel, vector<Instance>());
+  EXPECT_THROW(renderer->renderInstances(treeModel, treeInstances, "noSuchTexture"), Exception);
 }
 #endif
 